@@ -1,5 +1,6 @@
 
 include(CheckFunctionExists)
+include(CheckSymbolExists)
 
 #
 # Check for stack-allocated variable-size arrays")
@@ -21,6 +22,26 @@ else()
     set(HAVE_DYNAMIC_ARRAY FALSE)
 endif()
 
+#
+# Check for mmap, used to read the input file in place
+#
+check_symbol_exists(mmap "sys/mman.h" HAVE_MMAP)
+
+#
+# Check for POSIX threads, used to parse large input files in parallel
+#
+set(THREADS_PREFER_PTHREAD_FLAG ON)
+find_package(Threads)
+if(CMAKE_USE_PTHREADS_INIT)
+    set(HAVE_PTHREAD TRUE)
+endif()
+
+#
+# Check for the clocks used by --stats
+#
+check_symbol_exists(gettimeofday "sys/time.h" HAVE_GETTIMEOFDAY)
+check_symbol_exists(getrusage "sys/resource.h" HAVE_GETRUSAGE)
+
 configure_file(cmake/config.h.in ${CMAKE_BINARY_DIR}/config.h @ONLY)
 add_definitions(-DHAVE_CONFIG_H)
 include_directories(${CMAKE_BINARY_DIR})
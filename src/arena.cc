@@ -0,0 +1,75 @@
+/* Bump allocator for strings that live as long as the input.
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of GNU GPERF.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Specification. */
+#include "arena.h"
+
+/* Minimum size of a chunk, including its header.  */
+static const size_t CHUNK_SIZE = 65536;
+
+Arena::Arena ()
+  : _chunks (NULL), _free (NULL), _free_end (NULL)
+{
+}
+
+Arena::~Arena ()
+{
+  while (_chunks != NULL)
+    {
+      Chunk *next = _chunks->_next;
+      delete[] reinterpret_cast<char *>(_chunks);
+      _chunks = next;
+    }
+}
+
+char *
+Arena::allocate (size_t size)
+{
+  if (static_cast<size_t>(_free_end - _free) < size)
+    {
+      /* Start a new chunk.  Requests that don't fit into a chunk of the
+         default size get a chunk of their own.  */
+      size_t chunk_size = sizeof (Chunk) + size;
+      if (chunk_size < CHUNK_SIZE)
+        chunk_size = CHUNK_SIZE;
+      char *memory = new char[chunk_size];
+      Chunk *chunk = reinterpret_cast<Chunk *>(memory);
+      chunk->_next = _chunks;
+      _chunks = chunk;
+      _free = memory + sizeof (Chunk);
+      _free_end = memory + chunk_size;
+    }
+  char *result = _free;
+  _free += size;
+  return result;
+}
+
+void
+Arena::splice (Arena& other)
+{
+  if (other._chunks == NULL)
+    return;
+  Chunk *last = other._chunks;
+  while (last->_next != NULL)
+    last = last->_next;
+  last->_next = _chunks;
+  _chunks = other._chunks;
+  other._chunks = NULL;
+  other._free = NULL;
+  other._free_end = NULL;
+}
@@ -0,0 +1,59 @@
+/* This may look like C code, but it is really -*- C++ -*- */
+
+/* Bump allocator for strings that live as long as the input.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of GNU GPERF.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#ifndef arena_h
+#define arena_h 1
+
+#include <stddef.h>
+
+/* An Arena hands out character buffers from large chunks.  The buffers
+   cannot be freed individually; they are all freed together when the
+   Arena is destroyed.  This avoids one heap allocation per keyword when
+   reading large input files.  */
+
+class Arena
+{
+public:
+                        Arena ();
+                        ~Arena ();
+
+  /* Returns a buffer of SIZE bytes, valid until this Arena is destroyed.  */
+  char *                allocate (size_t size);
+
+  /* Takes over the buffers of OTHER, which becomes empty.  They remain valid
+     until this Arena is destroyed.  */
+  void                  splice (Arena& other);
+
+private:
+  /* Header of a chunk.  The buffers follow it.  */
+  struct Chunk
+    {
+      Chunk *           _next;
+    };
+
+  /* List of all chunks, most recently allocated first.  */
+  Chunk *               _chunks;
+  /* Free part of the current chunk.  */
+  char *                _free;
+  char *                _free_end;
+};
+
+#endif
@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "options.h"
+#include "stats.h"
 
 /* Frees this object.  */
 Bool_Array::~Bool_Array ()
@@ -33,6 +34,10 @@ Bool_Array::~Bool_Array ()
     fprintf (stderr, "\ndumping boolean array information\n"
              "size = %d\niteration number = %d\nend of array dump\n",
              _size, _iteration_number);
+  stats.lock ();
+  stats._bool_array_clears += _clear_calls;
+  stats._bool_array_set_bits += _set_bit_calls;
+  stats.unlock ();
   delete[] const_cast<unsigned int *>(_storage_array);
 }
 
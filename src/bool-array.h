@@ -61,6 +61,10 @@ private:
   /* For each index, we store in storage_array[index] the iteration_number at
      the time set_bit(index) was last called.  */
   unsigned int * const  _storage_array;
+
+  /* Statistics: Number of clear() and set_bit() calls so far.  */
+  unsigned long         _clear_calls;
+  unsigned long         _set_bit_calls;
 };
 
 #ifdef __OPTIMIZE__  /* efficiency hack! */
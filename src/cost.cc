@@ -0,0 +1,149 @@
+/* Cost model of the generated lookup function.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of GNU GPERF.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Specification. */
+#include "cost.h"
+
+#include <math.h> /* declares log() */
+#include "options.h"
+
+/* The relative costs of the parts of a lookup.  */
+
+/* A key position: a load from the keyword, a load from asso_values[] and
+   an addition.  */
+static const double POSITION_COST = 1.0;
+/* The additional address computation for the last character.  */
+static const double LASTCHAR_COST = 0.5;
+/* A switch on the keyword length: an indirect jump, which is mispredicted
+   when the lengths vary.  */
+static const double SWITCH_COST = 3.0;
+/* Each doubling of the number of cache lines that the tables occupy.  */
+static const double CACHE_LINE_DOUBLING_COST = 1.0;
+/* A call of strcmp or memcmp.  */
+static const double COMPARE_CALL_COST = 1.0;
+/* The characters compared per time unit.  */
+static const double COMPARED_CHARS_PER_UNIT = 8.0;
+
+/* Size of a cache line, in bytes.  */
+static const double CACHE_LINE_SIZE = 64.0;
+
+Cost_Model::Cost_Model (KeywordExt_List *list, int min_key_len, int max_key_len)
+  : _min_key_len (min_key_len), _max_key_len (max_key_len),
+    _average_length (0.0), _first_char_discrimination (1.0)
+{
+  unsigned int first_chars[256];
+  for (unsigned int c = 0; c < 256; c++)
+    first_chars[c] = 0;
+
+  int count = 0;
+  double total_length = 0.0;
+  for (KeywordExt_List *temp = list; temp; temp = temp->rest())
+    {
+      KeywordExt *keyword = temp->first();
+      count++;
+      total_length += keyword->_allchars_length;
+      if (keyword->_allchars_length > 0)
+        first_chars[static_cast<unsigned char>(keyword->_allchars[0])]++;
+    }
+
+  if (count > 0)
+    {
+      _average_length = total_length / count;
+      double coincidence = 0.0;
+      for (unsigned int c = 0; c < 256; c++)
+        {
+          double p = static_cast<double>(first_chars[c]) / count;
+          coincidence += p * p;
+        }
+      _first_char_discrimination = 1.0 - coincidence;
+    }
+}
+
+double
+Cost_Model::hash_cost (const Positions& positions) const
+{
+  if (positions.is_useall ())
+    return _average_length * POSITION_COST
+           + (_min_key_len < _max_key_len ? SWITCH_COST : 0.0);
+
+  double cost = 0.0;
+  bool needs_switch = false;
+  for (unsigned int i = 0; i < positions.get_size (); i++)
+    {
+      int pos = positions[i];
+      if (pos < 0)
+        {
+          /* A position counted from the end needs the length.  The hash
+             function reads it only for the keywords that are long
+             enough.  */
+          if (pos >= - _max_key_len)
+            {
+              cost += POSITION_COST + LASTCHAR_COST;
+              if (pos < - _min_key_len)
+                needs_switch = true;
+            }
+        }
+      else if (pos < _max_key_len)
+        {
+          /* The hash function reads the positions >= _min_key_len only for
+             the keywords that are long enough.  */
+          cost += POSITION_COST;
+          if (pos >= _min_key_len)
+            needs_switch = true;
+        }
+    }
+  if (needs_switch)
+    cost += SWITCH_COST;
+  return cost;
+}
+
+Lookup_Cost
+Cost_Model::estimate (const Positions& positions, unsigned int asso_values_size, int max_hash_value) const
+{
+  Lookup_Cost result;
+
+  result._hash = hash_cost (positions);
+
+  /* The asso_values[] elements have the smallest type that holds
+     max_hash_value + 1.  The keyword table has max_hash_value + 1 elements,
+     each a pointer, and with -l also an entry of the length table.  */
+  unsigned int table_size = max_hash_value + 1;
+  unsigned int asso_value_bytes =
+    (table_size < 256 ? 1 : table_size < 65536 ? 2 : 4);
+  unsigned int entry_bytes =
+    static_cast<unsigned int>(sizeof (const char *)) + (option[LENTABLE] ? 1 : 0);
+  result._table_bytes = asso_values_size * asso_value_bytes
+                        + table_size * entry_bytes;
+  result._memory =
+    CACHE_LINE_DOUBLING_COST
+    * log (1.0 + result._table_bytes / CACHE_LINE_SIZE) / log (2.0);
+
+  /* A hit compares the entire keyword.  A miss is compared only if its
+     first character matches.  (A miss may also fall into an empty slot of
+     the keyword table, or be rejected because its hash value is too large.
+     This is not taken into account, so that the cost grows with the maximum
+     hash value.)  */
+  double compare = COMPARE_CALL_COST + _average_length / COMPARED_CHARS_PER_UNIT;
+  result._hit_compare = compare;
+  result._miss_compare = (1.0 - _first_char_discrimination) * compare;
+
+  result._total = result._hash + result._memory
+                  + (result._hit_compare + result._miss_compare) / 2;
+  return result;
+}
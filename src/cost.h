@@ -0,0 +1,85 @@
+/* This may look like C code, but it is really -*- C++ -*- */
+
+/* Cost model of the generated lookup function.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of GNU GPERF.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#ifndef cost_h
+#define cost_h 1
+
+#include "keyword-list.h"
+#include "positions.h"
+
+/* An estimate of the time that a lookup in the generated code takes.  The
+   unit is roughly the time of a load from the L1 cache.  */
+
+struct Lookup_Cost
+{
+  /* Cost of the hash function.  */
+  double                _hash;
+  /* Size of the asso_values[] and keyword tables, in bytes.  */
+  unsigned int          _table_bytes;
+  /* Cost of the accesses to these tables.  */
+  double                _memory;
+  /* Expected cost of the string comparison, for a hit and for a miss.  */
+  double                _hit_compare;
+  double                _miss_compare;
+  /* Total cost, for a workload of as many hits as misses.  */
+  double                _total;
+};
+
+/* A Cost_Model estimates the lookup cost for a keyword set, depending on
+   the key positions and the maximum hash value.  It takes into account:
+     - the number of key positions, since each one costs a load from the
+       keyword and one from asso_values[],
+     - whether the hash function needs a switch on the keyword length,
+     - the size of the tables, since larger tables mean more cache misses,
+     - the length of the string comparison,
+     - how well the test of the first character, which precedes the string
+       comparison, rejects the misses.  */
+
+class Cost_Model
+{
+public:
+  /* Gathers the properties of the keywords in LIST.  */
+                        Cost_Model (KeywordExt_List *list, int min_key_len, int max_key_len);
+
+  /* Returns the cost of a hash function with the given key positions.  */
+  double                hash_cost (const Positions& positions) const;
+
+  /* Estimates the cost of a lookup, for a hash function with the given key
+     positions and maximum hash value, and an asso_values[] table with
+     ASSO_VALUES_SIZE elements.  */
+  Lookup_Cost           estimate (const Positions& positions, unsigned int asso_values_size, int max_hash_value) const;
+
+  /* Returns the probability that two keywords have different first
+     characters.  */
+  double                get_first_char_discrimination () const
+                          { return _first_char_discrimination; }
+
+private:
+  /* Minimum and maximum keyword length.  */
+  int                   _min_key_len;
+  int                   _max_key_len;
+  /* Average keyword length.  */
+  double                _average_length;
+  /* Probability that two keywords have different first characters.  */
+  double                _first_char_discrimination;
+};
+
+#endif
@@ -25,6 +25,7 @@
 #include <string.h> /* declares memset(), strcmp() */
 #include <hash.h>
 #include "options.h"
+#include "stats.h"
 
 /* We use a hash table with double hashing.  This is the simplest kind of
    hash table, given that we always only insert and never remove entries
@@ -83,6 +84,9 @@ Hash_Table::Hash_Table (unsigned int size, bool ignore_length)
 /* Destructor.  */
 Hash_Table::~Hash_Table ()
 {
+  stats.lock ();
+  stats._hash_table_collisions += _collisions;
+  stats.unlock ();
   delete[] _table;
 }
 
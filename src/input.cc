@@ -25,11 +25,24 @@
 #include <stdlib.h> /* declares exit() */
 #include <string.h> /* declares strncpy(), strchr() */
 #include <limits.h> /* defines UCHAR_MAX etc. */
+#include <stdarg.h> /* declares va_list */
 #include "options.h"
 #include "getline.h"
+#include "config.h"
+
+#if HAVE_MMAP
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h> /* declares mmap(), munmap() */
+# include <unistd.h>   /* declares lseek(), sysconf() */
+#endif
+#if HAVE_PTHREAD
+# include <pthread.h>
+#endif
 
 Input::Input (FILE *stream, Keyword_Factory *keyword_factory)
-  : _stream (stream), _factory (keyword_factory)
+  : _stream (stream), _factory (keyword_factory),
+    _input_mapped (false), _input_mapped_length (0)
 {
 }
 
@@ -225,6 +238,487 @@ is_define_declaration (const char *line, const char *line_end,
   return true;
 }
 
+/* Maps the regular file underlying STREAM into memory, so that it can be
+   parsed in place instead of being copied through stdio.  The mapping is
+   private, so that the CR/LF conversion does not modify the file.
+   Returns true and sets *INPUTP and *LENGTHP upon success.  Returns false if
+   the stream is not a regular file or cannot be mapped.  */
+static bool
+map_input (FILE *stream, char **inputp, size_t *lengthp)
+{
+#if HAVE_MMAP
+  int fd = fileno (stream);
+  struct stat statbuf;
+
+  if (fstat (fd, &statbuf) < 0 || !S_ISREG (statbuf.st_mode))
+    return false;
+  /* The stream may already have been read from.  */
+  if (lseek (fd, 0, SEEK_CUR) != 0)
+    return false;
+  if (statbuf.st_size <= 0 || statbuf.st_size > INT_MAX)
+    return false;
+  size_t length = statbuf.st_size;
+
+  /* The parser relies on a NUL byte after the end of the input.  The
+     system fills the remainder of the last page of the mapping with zeroes,
+     but there is no such remainder if the length is a multiple of the page
+     size.  */
+  long pagesize = sysconf (_SC_PAGESIZE);
+  if (pagesize <= 0 || length % pagesize == 0)
+    return false;
+
+  void *addr = mmap (NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED)
+    return false;
+
+  *inputp = static_cast<char *>(addr);
+  *lengthp = length;
+  return true;
+#else
+  (void) stream;
+  (void) inputp;
+  (void) lengthp;
+  return false;
+#endif
+}
+
+/* The binary input format starts with these bytes.  The byte with the high
+   bit set and the CR/LF sequence detect transfers that are not 8-bit clean
+   or that convert line terminators.  */
+static const char binary_magic[8] =
+  { '\211', 'g', 'p', 'e', 'r', 'f', '\r', '\n' };
+
+/* Version of the binary input format.  */
+static const unsigned int BINARY_VERSION = 1;
+
+/* Returns the 32-bit little-endian number at P.  */
+static unsigned int
+get_uint32 (const char *p)
+{
+  const unsigned char *q = reinterpret_cast<const unsigned char *>(p);
+  return static_cast<unsigned int>(q[0])
+         | (static_cast<unsigned int>(q[1]) << 8)
+         | (static_cast<unsigned int>(q[2]) << 16)
+         | (static_cast<unsigned int>(q[3]) << 24);
+}
+
+/* Reads a length-prefixed blob of the binary input format at *PP, not
+   beyond END.  Returns false if the input is truncated.  Otherwise sets
+   *BLOBP and *BLOB_ENDP, and advances *PP beyond the blob.  */
+static bool
+get_blob (const char **pp, const char *end,
+          const char **blobp, const char **blob_endp)
+{
+  const char *p = *pp;
+  if (end - p < 4)
+    return false;
+  size_t length = get_uint32 (p);
+  p += 4;
+  if (length > static_cast<size_t>(end - p))
+    return false;
+  *blobp = p;
+  *blob_endp = p + length;
+  *pp = p + length;
+  return true;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* A part of the keywords section, consisting of complete lines.  The parts
+   are parsed independently, possibly in separate threads, and their results
+   are concatenated in order.  */
+
+struct Keywords_Chunk
+{
+                        Keywords_Chunk ();
+                        ~Keywords_Chunk ();
+  /* Parses the lines, creating the keywords.  */
+  void                  parse ();
+  /* Parses COUNT records of the binary input format instead.  */
+  void                  parse_binary (unsigned int count);
+  /* Reports a warning or error.  */
+  void                  message (const char *format, ...);
+
+  /* The lines (or binary records) to parse.  */
+  const char *          _start;
+  const char *          _end;
+  /* Line number of _start.  */
+  unsigned int          _lineno;
+  /* Creates the keywords.  */
+  Keyword_Factory *     _factory;
+  /* Storage for the unescaped keywords and the rest of the keyword lines.  */
+  Arena                 _arena;
+  /* List of the keywords.  */
+  Keyword_List *        _head;
+  Keyword_List **       _tail;
+  /* Whether the keyword chars would have different values in a different
+     character set.  */
+  bool                  _charset_dependent;
+  /* Whether message() collects the messages in _messages rather than printing
+     them right away.  A chunk that is parsed in a separate thread must not
+     print, so that the messages appear in the same order as when parsing
+     serially.  */
+  bool                  _collect_messages;
+  char *                _messages;
+  size_t                _messages_length;
+  size_t                _messages_allocated;
+  /* Whether parsing stopped because of an error.  */
+  bool                  _failed;
+};
+
+Keywords_Chunk::Keywords_Chunk ()
+  : _start (NULL), _end (NULL), _lineno (0), _factory (NULL),
+    _head (NULL), _tail (&_head), _charset_dependent (false),
+    _collect_messages (false),
+    _messages (NULL), _messages_length (0), _messages_allocated (0),
+    _failed (false)
+{
+}
+
+Keywords_Chunk::~Keywords_Chunk ()
+{
+  delete[] _messages;
+}
+
+void
+Keywords_Chunk::message (const char *format, ...)
+{
+  va_list args;
+
+  if (!_collect_messages)
+    {
+      va_start (args, format);
+      vfprintf (stderr, format, args);
+      va_end (args);
+      return;
+    }
+
+  va_start (args, format);
+  int length = vsnprintf (NULL, 0, format, args);
+  va_end (args);
+  if (length < 0)
+    return;
+
+  size_t needed = _messages_length + length + 1;
+  if (needed > _messages_allocated)
+    {
+      size_t new_allocated = 2 * _messages_allocated;
+      if (new_allocated < needed)
+        new_allocated = needed;
+      char *new_messages = new char[new_allocated];
+      if (_messages_length > 0)
+        memcpy (new_messages, _messages, _messages_length);
+      delete[] _messages;
+      _messages = new_messages;
+      _messages_allocated = new_allocated;
+    }
+
+  va_start (args, format);
+  vsnprintf (_messages + _messages_length, length + 1, format, args);
+  va_end (args);
+  _messages_length += length;
+}
+
+void
+Keywords_Chunk::parse ()
+{
+  const char *delimiters = option.get_delimiters ();
+  unsigned int lineno = _lineno;
+  for (const char *line = _start; line < _end; )
+    {
+      const char *line_end;
+      line_end = (const char *) memchr (line, '\n', _end - line);
+      if (line_end != NULL)
+        line_end++;
+      else
+        line_end = _end;
+
+      if (line[0] == '#')
+        ; /* Comment line.  */
+      else if (line[0] == '%')
+        {
+          message ("%s:%u:"
+                   " declarations are not allowed in the keywords section.\n"
+                   "To declare a keyword starting with %%, enclose it in"
+                   " double-quotes.\n",
+                   pretty_input_file_name (), lineno);
+          _failed = true;
+          return;
+        }
+      else
+        {
+          /* An input line carrying a keyword.  */
+          const char *keyword;
+          size_t keyword_length;
+          const char *rest;
+
+          if (line[0] == '"')
+            {
+              /* Parse a string in ANSI C syntax.  */
+              char *kp = _arena.allocate (line_end - line);
+              keyword = kp;
+              const char *lp = line + 1;
+
+              for (;;)
+                {
+                  if (lp == line_end)
+                    {
+                      message ("%s:%u: unterminated string\n",
+                               pretty_input_file_name (), lineno);
+                      _failed = true;
+                      return;
+                    }
+
+                  char c = *lp;
+                  if (c == '\\')
+                    {
+                      c = *++lp;
+                      switch (c)
+                        {
+                        case '0': case '1': case '2': case '3':
+                        case '4': case '5': case '6': case '7':
+                          {
+                            int code = 0;
+                            int count = 0;
+                            while (count < 3 && *lp >= '0' && *lp <= '7')
+                              {
+                                code = (code << 3) + (*lp - '0');
+                                lp++;
+                                count++;
+                              }
+                            if (code > UCHAR_MAX)
+                              message ("%s:%u: octal escape out of range\n",
+                                       pretty_input_file_name (), lineno);
+                            *kp = static_cast<char>(code);
+                            break;
+                          }
+                        case 'x':
+                          {
+                            int code = 0;
+                            int count = 0;
+                            lp++;
+                            while ((*lp >= '0' && *lp <= '9')
+                                   || (*lp >= 'A' && *lp <= 'F')
+                                   || (*lp >= 'a' && *lp <= 'f'))
+                              {
+                                code = (code << 4)
+                                       + (*lp >= 'A' && *lp <= 'F'
+                                          ? *lp - 'A' + 10 :
+                                          *lp >= 'a' && *lp <= 'f'
+                                          ? *lp - 'a' + 10 :
+                                          *lp - '0');
+                                lp++;
+                                count++;
+                              }
+                            if (count == 0)
+                              message ("%s:%u: hexadecimal escape"
+                                       " without any hex digits\n",
+                                       pretty_input_file_name (), lineno);
+                            if (code > UCHAR_MAX)
+                              message ("%s:%u: hexadecimal escape"
+                                       " out of range\n",
+                                       pretty_input_file_name (), lineno);
+                            *kp = static_cast<char>(code);
+                            break;
+                          }
+                        case '\\': case '\'': case '"':
+                          *kp = c;
+                          lp++;
+                          _charset_dependent = true;
+                          break;
+                        case 'n':
+                          *kp = '\n';
+                          lp++;
+                          _charset_dependent = true;
+                          break;
+                        case 't':
+                          *kp = '\t';
+                          lp++;
+                          _charset_dependent = true;
+                          break;
+                        case 'r':
+                          *kp = '\r';
+                          lp++;
+                          _charset_dependent = true;
+                          break;
+                        case 'f':
+                          *kp = '\f';
+                          lp++;
+                          _charset_dependent = true;
+                          break;
+                        case 'b':
+                          *kp = '\b';
+                          lp++;
+                          _charset_dependent = true;
+                          break;
+                        case 'a':
+                          *kp = '\a';
+                          lp++;
+                          _charset_dependent = true;
+                          break;
+                        case 'v':
+                          *kp = '\v';
+                          lp++;
+                          _charset_dependent = true;
+                          break;
+                        default:
+                          message ("%s:%u: invalid escape sequence"
+                                   " in string\n",
+                                   pretty_input_file_name (), lineno);
+                          _failed = true;
+                          return;
+                        }
+                    }
+                  else if (c == '"')
+                    break;
+                  else
+                    {
+                      *kp = c;
+                      lp++;
+                      _charset_dependent = true;
+                    }
+                  kp++;
+                }
+              lp++;
+              if (lp < line_end && *lp != '\n')
+                {
+                  if (strchr (delimiters, *lp) == NULL)
+                    {
+                      message ("%s:%u: string not followed"
+                               " by delimiter\n",
+                               pretty_input_file_name (), lineno);
+                      _failed = true;
+                      return;
+                    }
+                  lp++;
+                }
+              keyword_length = kp - keyword;
+              if (option[TYPE])
+                {
+                  char *line_rest = _arena.allocate (line_end - lp + 1);
+                  memcpy (line_rest, lp, line_end - lp);
+                  line_rest[line_end - lp -
+                            (line_end > lp && line_end[-1] == '\n' ? 1 : 0)]
+                    = '\0';
+                  rest = line_rest;
+                }
+              else
+                rest = empty_string;
+            }
+          else
+            {
+              /* Not a string.  Look for the delimiter.  */
+              const char *lp = line;
+              for (;;)
+                {
+                  if (!(lp < line_end && *lp != '\n'))
+                    {
+                      keyword = line;
+                      keyword_length = lp - line;
+                      rest = empty_string;
+                      break;
+                    }
+                  if (strchr (delimiters, *lp) != NULL)
+                    {
+                      keyword = line;
+                      keyword_length = lp - line;
+                      lp++;
+                      if (option[TYPE])
+                        {
+                          char *line_rest =
+                            _arena.allocate (line_end - lp + 1);
+                          memcpy (line_rest, lp, line_end - lp);
+                          line_rest[line_end - lp -
+                                    (line_end > lp && line_end[-1] == '\n'
+                                     ? 1 : 0)]
+                            = '\0';
+                          rest = line_rest;
+                        }
+                      else
+                        rest = empty_string;
+                      break;
+                    }
+                  lp++;
+                }
+              if (keyword_length > 0)
+                _charset_dependent = true;
+            }
+
+          /* Allocate Keyword and add it to the list.  */
+          Keyword *new_kw = _factory->create_keyword (keyword, keyword_length,
+                                                      rest, lineno);
+          *_tail = new Keyword_List (new_kw);
+          _tail = &(*_tail)->rest();
+        }
+
+      lineno++;
+      line = line_end;
+    }
+}
+
+void
+Keywords_Chunk::parse_binary (unsigned int count)
+{
+  const char *p = _start;
+  for (unsigned int i = 1; i <= count; i++)
+    {
+      const char *keyword;
+      const char *keyword_end;
+      const char *rest;
+      const char *rest_end;
+
+      if (!(get_blob (&p, _end, &keyword, &keyword_end)
+            && get_blob (&p, _end, &rest, &rest_end)
+            && p < _end))
+        {
+          message ("%s: keyword %u: truncated record\n",
+                   pretty_input_file_name (), i);
+          _failed = true;
+          return;
+        }
+      /* The payload is followed by a NUL byte, so that it can be used in
+         place.  */
+      if (*p != '\0')
+        {
+          message ("%s: keyword %u: payload is not NUL terminated\n",
+                   pretty_input_file_name (), i);
+          _failed = true;
+          return;
+        }
+      p++;
+
+      if (keyword_end > keyword)
+        _charset_dependent = true;
+
+      /* Allocate Keyword and add it to the list.  There are no line numbers
+         to refer to.  */
+      Keyword *new_kw =
+        _factory->create_keyword (keyword, keyword_end - keyword,
+                                  option[TYPE] ? rest : empty_string, 0);
+      *_tail = new Keyword_List (new_kw);
+      _tail = &(*_tail)->rest();
+    }
+  if (p < _end)
+    message ("%s: warning: junk after the last keyword is ignored\n",
+             pretty_input_file_name ());
+}
+
+#if HAVE_PTHREAD
+
+/* Thread entry point: parses the Keywords_Chunk ARG.  */
+static void *
+parse_chunk (void *arg)
+{
+  static_cast<Keywords_Chunk *>(arg)->parse ();
+  return NULL;
+}
+
+#endif
+
+/* Minimum size of the part of the keywords section that is worth parsing in
+   a separate thread.  */
+static const size_t MIN_CHUNK_SIZE = 1 << 20;
+
 /* Reads the entire input file.  */
 void
 Input::read_input ()
@@ -247,11 +741,22 @@ Input::read_input ()
         ADDITIONAL_CODE
      When the option -t is given or when the first section contains
      declaration lines starting with %, we go for the first interpretation,
-     otherwise for the second interpretation.  */
+     otherwise for the second interpretation.
+     A file in the binary input format instead carries the DECLARATIONS and
+     the ADDITIONAL_CODE as length-prefixed blobs in its header, followed by
+     the keywords as length-prefixed records.  */
 
   char *input = NULL;
   size_t input_size = 0;
-  int input_length = get_delim (&input, &input_size, EOF, _stream);
+  int input_length;
+  if (map_input (_stream, &input, &input_size))
+    {
+      _input_mapped = true;
+      _input_mapped_length = input_size;
+      input_length = input_size;
+    }
+  else
+    input_length = get_delim (&input, &input_size, EOF, _stream);
   if (input_length < 0)
     {
       if (ferror (_stream))
@@ -263,6 +768,10 @@ Input::read_input ()
       exit (1);
     }
 
+  /* Recognize the binary input format.  It has no line structure.  */
+  bool binary = (input_length >= static_cast<int>(sizeof (binary_magic))
+                 && memcmp (input, binary_magic, sizeof (binary_magic)) == 0);
+
   /* Convert CR/LF line terminators (Windows) to LF line terminators (Unix).
      GCC 3.3 and newer support CR/LF line terminators in C sources on Unix,
      so we do the same.
@@ -270,22 +779,23 @@ Input::read_input ()
      automatically, but here we also need this conversion on Unix.  As a side
      effect, on Windows we also parse CR/CR/LF into a single \n, but this
      is not a problem.  */
-  {
-    char *p = input;
-    char *p_end = input + input_length;
-    /* Converting the initial segment without CRs is a no-op.  */
-    while (p < p_end && *p != '\r')
-      p++;
-    /* Then start the conversion for real.  */
-    char *q = p;
-    while (p < p_end)
-      {
-        if (p[0] == '\r' && p + 1 < p_end && p[1] == '\n')
-          p++;
-        *q++ = *p++;
-      }
-    input_length = q - input;
-  }
+  if (!binary)
+    {
+      char *p = input;
+      char *p_end = input + input_length;
+      /* Converting the initial segment without CRs is a no-op.  */
+      while (p < p_end && *p != '\r')
+        p++;
+      /* Then start the conversion for real.  */
+      char *q = p;
+      while (p < p_end)
+        {
+          if (p[0] == '\r' && p + 1 < p_end && p[1] == '\n')
+            p++;
+          *q++ = *p++;
+        }
+      input_length = q - input;
+    }
 
   /* We use input_end as a limit, in order to cope with NUL bytes in the
      input.  But note that one trailing NUL byte has been added after
@@ -297,105 +807,153 @@ Input::read_input ()
   const char *keywords;
   const char *keywords_end;
   unsigned int keywords_lineno;
+  unsigned int binary_count = 0;
 
-  /* Break up the input into the three sections.  */
-  {
-    const char *separator[2] = { NULL, NULL };
-    unsigned int separator_lineno[2] = { 0, 0 };
-    int separators = 0;
+  if (binary)
     {
-      unsigned int lineno = 1;
-      for (const char *p = input; p < input_end; )
+      /* The header consists of the magic bytes, the version, the number of
+         keywords, the declarations and the additional code.  */
+      const char *p = input + sizeof (binary_magic);
+      if (input_end - p < 8)
         {
-          if (p[0] == '%' && p[1] == '%')
-            {
-              separator[separators] = p;
-              separator_lineno[separators] = lineno;
-              if (++separators == 2)
-                break;
-            }
-          lineno++;
-          p = (const char *) memchr (p, '\n', input_end - p);
-          if (p != NULL)
-            p++;
-          else
-            p = input_end;
+          fprintf (stderr, "%s: truncated binary input file header\n",
+                   pretty_input_file_name ());
+          exit (1);
+        }
+      unsigned int version = get_uint32 (p);
+      if (version != BINARY_VERSION)
+        {
+          fprintf (stderr, "%s: unsupported binary input format version %u\n",
+                   pretty_input_file_name (), version);
+          exit (1);
         }
+      binary_count = get_uint32 (p + 4);
+      p += 8;
+      const char *verbatim_code;
+      const char *verbatim_code_end;
+      if (!(get_blob (&p, input_end, &declarations, &declarations_end)
+            && get_blob (&p, input_end, &verbatim_code, &verbatim_code_end)))
+        {
+          fprintf (stderr, "%s: truncated binary input file header\n",
+                   pretty_input_file_name ());
+          exit (1);
+        }
+      keywords = p;
+      keywords_end = input_end;
+      keywords_lineno = 0;
+      if (verbatim_code < verbatim_code_end)
+        {
+          _verbatim_code = verbatim_code;
+          _verbatim_code_end = verbatim_code_end;
+        }
+      else
+        {
+          _verbatim_code = NULL;
+          _verbatim_code_end = NULL;
+        }
+      /* Line numbers would refer to lines of the blobs, not of the input
+         file.  Don't emit #line directives for them.  */
+      _verbatim_code_lineno = 0;
     }
-
-    bool has_declarations;
-    if (separators == 1)
+  else
+    {
+      /* Break up the input into the three sections.  */
+      const char *separator[2] = { NULL, NULL };
+      unsigned int separator_lineno[2] = { 0, 0 };
+      int separators = 0;
       {
-        if (option[TYPE])
-          has_declarations = true;
-        else
+        unsigned int lineno = 1;
+        for (const char *p = input; p < input_end; )
           {
-            has_declarations = false;
-            for (const char *p = input; p < separator[0]; )
+            if (p[0] == '%' && p[1] == '%')
               {
-                if (p[0] == '%')
-                  {
-                    has_declarations = true;
-                    break;
-                  }
-                p = (const char *) memchr (p, '\n', separator[0] - p);
-                if (p != NULL)
-                  p++;
-                else
-                  p = separator[0];
+                separator[separators] = p;
+                separator_lineno[separators] = lineno;
+                if (++separators == 2)
+                  break;
               }
+            lineno++;
+            p = (const char *) memchr (p, '\n', input_end - p);
+            if (p != NULL)
+              p++;
+            else
+              p = input_end;
           }
       }
-    else
-      has_declarations = (separators > 0);
 
-    if (has_declarations)
-      {
-        declarations = input;
-        declarations_end = separator[0];
-        /* Give a warning if the separator line is nonempty.  */
-        bool nonempty_line = false;
-        const char *p;
-        for (p = declarations_end + 2; p < input_end; )
-          {
-            if (*p == '\n')
-              {
-                p++;
-                break;
-              }
-            if (!(*p == ' ' || *p == '\t'))
-              nonempty_line = true;
-            p++;
-          }
-        if (nonempty_line)
-          fprintf (stderr, "%s:%u: warning: junk after %%%% is ignored\n",
-                   pretty_input_file_name (), separator_lineno[0]);
-        keywords = p;
-        keywords_lineno = separator_lineno[0] + 1;
-      }
-    else
-      {
-        declarations = NULL;
-        declarations_end = NULL;
-        keywords = input;
-        keywords_lineno = 1;
-      }
+      bool has_declarations;
+      if (separators == 1)
+        {
+          if (option[TYPE])
+            has_declarations = true;
+          else
+            {
+              has_declarations = false;
+              for (const char *p = input; p < separator[0]; )
+                {
+                  if (p[0] == '%')
+                    {
+                      has_declarations = true;
+                      break;
+                    }
+                  p = (const char *) memchr (p, '\n', separator[0] - p);
+                  if (p != NULL)
+                    p++;
+                  else
+                    p = separator[0];
+                }
+            }
+        }
+      else
+        has_declarations = (separators > 0);
 
-    if (separators > (has_declarations ? 1 : 0))
-      {
-        keywords_end = separator[separators-1];
-        _verbatim_code = separator[separators-1] + 2;
-        _verbatim_code_end = input_end;
-        _verbatim_code_lineno = separator_lineno[separators-1];
-      }
-    else
-      {
-        keywords_end = input_end;
-        _verbatim_code = NULL;
-        _verbatim_code_end = NULL;
-        _verbatim_code_lineno = 0;
-      }
-  }
+      if (has_declarations)
+        {
+          declarations = input;
+          declarations_end = separator[0];
+          /* Give a warning if the separator line is nonempty.  */
+          bool nonempty_line = false;
+          const char *p;
+          for (p = declarations_end + 2; p < input_end; )
+            {
+              if (*p == '\n')
+                {
+                  p++;
+                  break;
+                }
+              if (!(*p == ' ' || *p == '\t'))
+                nonempty_line = true;
+              p++;
+            }
+          if (nonempty_line)
+            fprintf (stderr, "%s:%u: warning: junk after %%%% is ignored\n",
+                     pretty_input_file_name (), separator_lineno[0]);
+          keywords = p;
+          keywords_lineno = separator_lineno[0] + 1;
+        }
+      else
+        {
+          declarations = NULL;
+          declarations_end = NULL;
+          keywords = input;
+          keywords_lineno = 1;
+        }
+
+      if (separators > (has_declarations ? 1 : 0))
+        {
+          keywords_end = separator[separators-1];
+          _verbatim_code = separator[separators-1] + 2;
+          _verbatim_code_end = input_end;
+          _verbatim_code_lineno = separator_lineno[separators-1];
+        }
+      else
+        {
+          keywords_end = input_end;
+          _verbatim_code = NULL;
+          _verbatim_code_end = NULL;
+          _verbatim_code_lineno = 0;
+        }
+    }
 
   /* Parse the declarations section.  */
 
@@ -602,6 +1160,18 @@ Input::read_input ()
                   option.set (NOTYPE);
                 else
 
+                if (is_declaration (line, line_end, lineno, "simd"))
+                  option.set (SIMD);
+                else
+
+                if (is_declaration (line, line_end, lineno, "traits"))
+                  option.set (TRAITS);
+                else
+
+                if (is_declaration (line, line_end, lineno, "string-view"))
+                  option.set (STRINGVIEW);
+                else
+
                   {
                     fprintf (stderr, "%s:%u: unrecognized %% directive\n",
                              pretty_input_file_name (), lineno);
@@ -647,6 +1217,97 @@ Input::read_input ()
         exit (1);
       }
 
+    /* Without a NUL terminator, only the length table tells where the
+       string ends.  */
+    if (option[STRINGVIEW])
+      option.set (LENTABLE);
+
+    /* The lookup template relies on 'if constexpr'.  */
+    if (option[TRAITS] && !option[CPLUSPLUS17])
+      {
+        fprintf (stderr, "%s: option --traits requires --language=C++17\n",
+                 pretty_input_file_name ());
+        exit (1);
+      }
+    if (option.get_lookup_template_file_name () != NULL && !option[TRAITS])
+      {
+        fprintf (stderr, "%s: option --lookup-template requires --traits\n",
+                 pretty_input_file_name ());
+        exit (1);
+      }
+    /* The C++17 code must be usable in constant expressions, which excludes
+       the 'goto' statements of --switch and the address arithmetic of
+       --pic.  */
+    if (option[CPLUSPLUS17] && (option[SWITCH] || option[SHAREDLIB]))
+      {
+        fprintf (stderr, "%s: option --%s is not supported"
+                 " with --language=C++17\n",
+                 pretty_input_file_name (),
+                 option[SWITCH] ? "switch" : "pic");
+        exit (1);
+      }
+    /* The shards are separate files, named after the output file.  They
+       hold the tables of the lookup table layout only.  */
+    if (option.get_shards () > 1)
+      {
+        const char *output_file_name = option.get_output_file_name ();
+        if (output_file_name == NULL || strcmp (output_file_name, "-") == 0)
+          {
+            fprintf (stderr, "%s: option --shards requires --output-file\n",
+                     pretty_input_file_name ());
+            exit (1);
+          }
+        if (option[SWITCH] || option[CPLUSPLUS17])
+          {
+            fprintf (stderr, "%s: option --shards is not supported"
+                     " with --%s\n",
+                     pretty_input_file_name (),
+                     option[SWITCH] ? "switch" : "language=C++17");
+            exit (1);
+          }
+      }
+    /* The binary files are named after the output file.  They replace the
+       string pool and the length table, and are not constexpr.  */
+    if (option[INCBIN] || option[EMBED])
+      {
+        const char *output_file_name = option.get_output_file_name ();
+        if (output_file_name == NULL || strcmp (output_file_name, "-") == 0)
+          {
+            fprintf (stderr, "%s: option --binary-tables requires --output-file\n",
+                     pretty_input_file_name ());
+            exit (1);
+          }
+        if (!(option[SHAREDLIB] || option[LENTABLE]))
+          {
+            fprintf (stderr, "%s: option --binary-tables requires --pic"
+                     " or --compare-lengths\n",
+                     pretty_input_file_name ());
+            exit (1);
+          }
+        if (option[CPLUSPLUS17] || option.get_shards () > 1)
+          {
+            fprintf (stderr, "%s: option --binary-tables is not supported"
+                     " with --%s\n",
+                     pretty_input_file_name (),
+                     option[CPLUSPLUS17] ? "language=C++17" : "shards");
+            exit (1);
+          }
+      }
+
+    /* The benchmark driver is self-contained, hence needs the declaration
+       of size_t.  It uses prototypes and calls the lookup function, which
+       the binary image replaces.  */
+    if (option[BENCHMARK])
+      option.set (INCLUDE);
+    if (option[BENCHMARK] && (option[KRC] || option.get_image_file_name ()))
+      {
+        fprintf (stderr, "%s: option --benchmark is not supported"
+                 " with --%s\n",
+                 pretty_input_file_name (),
+                 option[KRC] ? "language=KR-C" : "output-image");
+        exit (1);
+      }
+
     /* Determine _struct_decl, _return_type, _struct_tag.  */
     if (option[TYPE])
       {
@@ -772,238 +1433,106 @@ Input::read_input ()
       delete[] struct_decl_linenos;
   }
 
+  if (binary)
+    {
+      _verbatim_declarations_lineno = 0;
+      _struct_decl_lineno = 0;
+    }
+
   /* Parse the keywords section.  */
   {
-    Keyword_List **list_tail = &_head;
-    const char *delimiters = option.get_delimiters ();
-    unsigned int lineno = keywords_lineno;
-    bool charset_dependent = false;
-    for (const char *line = keywords; line < keywords_end; )
+    /* Split it into chunks of complete lines.  The records of the binary
+       input format are not worth splitting: they need no scanning.  */
+    size_t keywords_size = keywords_end - keywords;
+    unsigned int chunk_count = 1;
+#if HAVE_PTHREAD
+    if (option.get_threads () > 1 && !binary)
       {
-        const char *line_end;
-        line_end = (const char *) memchr (line, '\n', keywords_end - line);
-        if (line_end != NULL)
-          line_end++;
-        else
-          line_end = keywords_end;
+        chunk_count = keywords_size / MIN_CHUNK_SIZE;
+        if (chunk_count > static_cast<unsigned int>(option.get_threads ()))
+          chunk_count = option.get_threads ();
+        if (chunk_count == 0)
+          chunk_count = 1;
+      }
+#endif
+    Keywords_Chunk *chunks = new Keywords_Chunk[chunk_count];
+    {
+      const char *start = keywords;
+      unsigned int lineno = keywords_lineno;
+      for (unsigned int i = 0; i < chunk_count; i++)
+        {
+          const char *end;
+          if (i == chunk_count - 1)
+            end = keywords_end;
+          else
+            {
+              end = keywords + keywords_size / chunk_count * (i + 1);
+              if (end < start)
+                end = start;
+              end = (const char *) memchr (end, '\n', keywords_end - end);
+              end = (end != NULL ? end + 1 : keywords_end);
+            }
+          chunks[i]._start = start;
+          chunks[i]._end = end;
+          chunks[i]._lineno = lineno;
+          chunks[i]._factory = _factory;
+          chunks[i]._collect_messages = (chunk_count > 1);
+          /* Count the lines, for the line number of the next chunk.  */
+          for (const char *p = start;
+               (p = (const char *) memchr (p, '\n', end - p)) != NULL;
+               p++)
+            lineno++;
+          start = end;
+        }
+    }
 
-        if (line[0] == '#')
-          ; /* Comment line.  */
-        else if (line[0] == '%')
-          {
-            fprintf (stderr, "%s:%u:"
-                     " declarations are not allowed in the keywords section.\n"
-                     "To declare a keyword starting with %%, enclose it in"
-                     " double-quotes.\n",
-                     pretty_input_file_name (), lineno);
-            exit (1);
-          }
-        else
+    if (binary)
+      chunks[0].parse_binary (binary_count);
+    else
+#if HAVE_PTHREAD
+    if (chunk_count > 1)
+      {
+        pthread_t *threads = new pthread_t[chunk_count];
+        bool *started = new bool[chunk_count];
+        for (unsigned int i = 1; i < chunk_count; i++)
+          started[i] =
+            (pthread_create (&threads[i], NULL, parse_chunk, &chunks[i]) == 0);
+        chunks[0].parse ();
+        for (unsigned int i = 1; i < chunk_count; i++)
           {
-            /* An input line carrying a keyword.  */
-            const char *keyword;
-            size_t keyword_length;
-            const char *rest;
-
-            if (line[0] == '"')
-              {
-                /* Parse a string in ANSI C syntax.  */
-                char *kp = new char[line_end-line];
-                keyword = kp;
-                const char *lp = line + 1;
-
-                for (;;)
-                  {
-                    if (lp == line_end)
-                      {
-                        fprintf (stderr, "%s:%u: unterminated string\n",
-                                 pretty_input_file_name (), lineno);
-                        exit (1);
-                      }
-
-                    char c = *lp;
-                    if (c == '\\')
-                      {
-                        c = *++lp;
-                        switch (c)
-                          {
-                          case '0': case '1': case '2': case '3':
-                          case '4': case '5': case '6': case '7':
-                            {
-                              int code = 0;
-                              int count = 0;
-                              while (count < 3 && *lp >= '0' && *lp <= '7')
-                                {
-                                  code = (code << 3) + (*lp - '0');
-                                  lp++;
-                                  count++;
-                                }
-                              if (code > UCHAR_MAX)
-                                fprintf (stderr,
-                                         "%s:%u: octal escape out of range\n",
-                                         pretty_input_file_name (), lineno);
-                              *kp = static_cast<char>(code);
-                              break;
-                            }
-                          case 'x':
-                            {
-                              int code = 0;
-                              int count = 0;
-                              lp++;
-                              while ((*lp >= '0' && *lp <= '9')
-                                     || (*lp >= 'A' && *lp <= 'F')
-                                     || (*lp >= 'a' && *lp <= 'f'))
-                                {
-                                  code = (code << 4)
-                                         + (*lp >= 'A' && *lp <= 'F'
-                                            ? *lp - 'A' + 10 :
-                                            *lp >= 'a' && *lp <= 'f'
-                                            ? *lp - 'a' + 10 :
-                                            *lp - '0');
-                                  lp++;
-                                  count++;
-                                }
-                              if (count == 0)
-                                fprintf (stderr, "%s:%u: hexadecimal escape"
-                                         " without any hex digits\n",
-                                         pretty_input_file_name (), lineno);
-                              if (code > UCHAR_MAX)
-                                fprintf (stderr, "%s:%u: hexadecimal escape"
-                                         " out of range\n",
-                                         pretty_input_file_name (), lineno);
-                              *kp = static_cast<char>(code);
-                              break;
-                            }
-                          case '\\': case '\'': case '"':
-                            *kp = c;
-                            lp++;
-                            charset_dependent = true;
-                            break;
-                          case 'n':
-                            *kp = '\n';
-                            lp++;
-                            charset_dependent = true;
-                            break;
-                          case 't':
-                            *kp = '\t';
-                            lp++;
-                            charset_dependent = true;
-                            break;
-                          case 'r':
-                            *kp = '\r';
-                            lp++;
-                            charset_dependent = true;
-                            break;
-                          case 'f':
-                            *kp = '\f';
-                            lp++;
-                            charset_dependent = true;
-                            break;
-                          case 'b':
-                            *kp = '\b';
-                            lp++;
-                            charset_dependent = true;
-                            break;
-                          case 'a':
-                            *kp = '\a';
-                            lp++;
-                            charset_dependent = true;
-                            break;
-                          case 'v':
-                            *kp = '\v';
-                            lp++;
-                            charset_dependent = true;
-                            break;
-                          default:
-                            fprintf (stderr, "%s:%u: invalid escape sequence"
-                                     " in string\n",
-                                     pretty_input_file_name (), lineno);
-                            exit (1);
-                          }
-                      }
-                    else if (c == '"')
-                      break;
-                    else
-                      {
-                        *kp = c;
-                        lp++;
-                        charset_dependent = true;
-                      }
-                    kp++;
-                  }
-                lp++;
-                if (lp < line_end && *lp != '\n')
-                  {
-                    if (strchr (delimiters, *lp) == NULL)
-                      {
-                        fprintf (stderr, "%s:%u: string not followed"
-                                 " by delimiter\n",
-                                 pretty_input_file_name (), lineno);
-                        exit (1);
-                      }
-                    lp++;
-                  }
-                keyword_length = kp - keyword;
-                if (option[TYPE])
-                  {
-                    char *line_rest = new char[line_end - lp + 1];
-                    memcpy (line_rest, lp, line_end - lp);
-                    line_rest[line_end - lp -
-                              (line_end > lp && line_end[-1] == '\n' ? 1 : 0)]
-                      = '\0';
-                    rest = line_rest;
-                  }
-                else
-                  rest = empty_string;
-              }
+            if (started[i])
+              pthread_join (threads[i], NULL);
             else
-              {
-                /* Not a string.  Look for the delimiter.  */
-                const char *lp = line;
-                for (;;)
-                  {
-                    if (!(lp < line_end && *lp != '\n'))
-                      {
-                        keyword = line;
-                        keyword_length = lp - line;
-                        rest = empty_string;
-                        break;
-                      }
-                    if (strchr (delimiters, *lp) != NULL)
-                      {
-                        keyword = line;
-                        keyword_length = lp - line;
-                        lp++;
-                        if (option[TYPE])
-                          {
-                            char *line_rest = new char[line_end - lp + 1];
-                            memcpy (line_rest, lp, line_end - lp);
-                            line_rest[line_end - lp -
-                                      (line_end > lp && line_end[-1] == '\n'
-                                       ? 1 : 0)]
-                              = '\0';
-                            rest = line_rest;
-                          }
-                        else
-                          rest = empty_string;
-                        break;
-                      }
-                    lp++;
-                  }
-                if (keyword_length > 0)
-                  charset_dependent = true;
-              }
-
-            /* Allocate Keyword and add it to the list.  */
-            Keyword *new_kw = _factory->create_keyword (keyword, keyword_length,
-                                                        rest, lineno);
-            *list_tail = new Keyword_List (new_kw);
-            list_tail = &(*list_tail)->rest();
+              chunks[i].parse ();
           }
+        delete[] started;
+        delete[] threads;
+      }
+    else
+#endif
+      chunks[0].parse ();
 
-        lineno++;
-        line = line_end;
+    /* Concatenate the results, in order.  Print the messages of the chunks
+       up to the first one that failed.  */
+    Keyword_List **list_tail = &_head;
+    bool charset_dependent = false;
+    for (unsigned int i = 0; i < chunk_count; i++)
+      {
+        Keywords_Chunk& chunk = chunks[i];
+        if (chunk._messages_length > 0)
+          fwrite (chunk._messages, 1, chunk._messages_length, stderr);
+        if (chunk._failed)
+          exit (1);
+        if (chunk._head != NULL)
+          {
+            *list_tail = chunk._head;
+            list_tail = chunk._tail;
+          }
+        if (chunk._charset_dependent)
+          charset_dependent = true;
+        _arena.splice (chunk._arena);
       }
+    delete[] chunks;
     *list_tail = NULL;
 
     if (_head == NULL)
@@ -1027,5 +1556,10 @@ Input::~Input ()
   delete[] const_cast<char*>(_return_type);
   delete[] const_cast<char*>(_struct_tag);
   delete[] const_cast<char*>(_struct_decl);
-  delete[] _input;
+#if HAVE_MMAP
+  if (_input_mapped)
+    munmap (_input, _input_mapped_length);
+  else
+#endif
+    delete[] _input;
 }
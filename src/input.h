@@ -26,6 +26,7 @@
 
 #include <stdio.h>
 #include "keyword-list.h"
+#include "arena.h"
 
 class Input
 {
@@ -38,10 +39,18 @@ private:
   FILE *                _stream;
   /* Creates the keywords.  */
   Keyword_Factory * const _factory;
+  /* Whether _input is a memory mapping of the input file, rather than
+     allocated with new[].  */
+  bool                  _input_mapped;
+  size_t                _input_mapped_length;
 public:
-  /* Memory block containing the entire input.  */
+  /* Memory block containing the entire input.  The keywords point into it,
+     except those that need unescaping.  */
   char *                _input;
   char *                _input_end;
+  /* Storage for the unescaped keywords and for the rest of the keyword
+     lines.  */
+  Arena                 _arena;
   /* The C code from the declarations section.  */
   const char *          _verbatim_declarations;
   const char *          _verbatim_declarations_end;
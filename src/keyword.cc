@@ -84,9 +84,10 @@ KeywordExt::init_selchars_low (const Positions& positions, const unsigned int *a
   for (int i; (i = iter.next ()) != PositionIterator::EOS; )
     {
       unsigned int c;
-      if (i == Positions::LASTCHAR)
-        /* Special notation for last KEY position, i.e. '$'.  */
-        c = static_cast<unsigned char>(_allchars[_allchars_length - 1]);
+      if (i < 0)
+        /* Special notation for a position counted from the end, i.e. '$' or
+           '$-N'.  The iterator skips those beyond the start of the keyword.  */
+        c = static_cast<unsigned char>(_allchars[_allchars_length + i]);
       else if (i < _allchars_length)
         {
           /* Within range of KEY length, so we'll keep it.  */
@@ -25,6 +25,8 @@
 #include "input.h"
 #include "search.h"
 #include "output.h"
+#include "stats.h"
+#include "portfolio.h"
 
 
 /* ------------------------------------------------------------------------- */
@@ -67,14 +69,27 @@ main (int argc, char *argv[])
     /* Initialize the keyword list.  */
     KeywordExt_Factory factory;
     Input inputter (stdin, &factory);
+    stats.start (PHASE_INPUT);
     inputter.read_input ();
+    stats.stop (PHASE_INPUT);
     /* We can cast the keyword list to KeywordExt_List* because its list
        elements were created by KeywordExt_Factory.  */
     KeywordExt_List* list = static_cast<KeywordExt_List*>(inputter._head);
 
     {
+      /* With --portfolio, choose the settings of the search among several
+         ones.  The best search is then repeated, to produce the output.  */
+      Search_Settings settings;
+      if (option.get_portfolio () != PORTFOLIO_NONE)
+        {
+          stats.start (PHASE_PORTFOLIO);
+          Portfolio portfolio (list);
+          settings = portfolio.run ();
+          stats.stop (PHASE_PORTFOLIO);
+        }
+
       /* Search for a good hash function.  */
-      Search searcher (list);
+      Search searcher (list, settings);
       searcher.optimize ();
       list = searcher._head;
 
@@ -110,8 +125,11 @@ main (int argc, char *argv[])
                           searcher._alpha_inc,
                           searcher._total_duplicates,
                           searcher._alpha_size,
+                          searcher._alpha_reduced,
                           searcher._asso_values);
+        stats.start (PHASE_OUTPUT);
         outputter.output ();
+        stats.stop (PHASE_OUTPUT);
 
         /* Check for write error on stdout.  */
         exitcode = 0;
@@ -134,12 +152,9 @@ main (int argc, char *argv[])
         do
           {
             KeywordExt *next_keyword = keyword->_duplicate_link;
+            /* _allchars and _rest point into inputter._input or
+               inputter._arena.  */
             delete[] const_cast<unsigned int *>(keyword->_selchars);
-            if (keyword->_rest != empty_string)
-              delete[] const_cast<char*>(keyword->_rest);
-            if (!(keyword->_allchars >= inputter._input
-                  && keyword->_allchars < inputter._input_end))
-              delete[] const_cast<char*>(keyword->_allchars);
             delete keyword;
             keyword = next_keyword;
           }
@@ -150,6 +165,16 @@ main (int argc, char *argv[])
     /* Here we run the Input destructor.  */
   }
 
+  /* Write the statistics, now that the Search destructor has collected the
+     counters of its Bool_Array.  */
+  if (option.get_stats_file_name ())
+    if (!stats.write (option.get_stats_file_name ()))
+      {
+        fprintf (stderr, "error while writing statistics file '%s'\n",
+                 option.get_stats_file_name ());
+        exitcode = 1;
+      }
+
   /* Don't use exit() here, it skips the destructors.  */
   return exitcode;
 }
@@ -27,6 +27,7 @@
 #include <ctype.h>  /* declares isdigit() */
 #include <limits.h> /* defines CHAR_MAX */
 #include "getopt.h"
+#include "output-buffer.h"
 #include "version.h"
 
 /* Global option coordinator for the entire program.  */
@@ -38,6 +39,12 @@ const char *program_name;
 /* Size to jump on a collision.  */
 static const int DEFAULT_JUMP_VALUE = 5;
 
+/* Default node limit of the exact search for associated values.  */
+static const int DEFAULT_SOLVER_LIMIT = 10000000;
+
+/* Default number of bits per keyword of the lookup prefilter.  */
+static const int DEFAULT_PREFILTER_BITS = 16;
+
 /* Default name for generated lookup function.  */
 static const char *const DEFAULT_FUNCTION_NAME = "in_word_set";
 
@@ -95,6 +102,19 @@ Options::long_usage (FILE * stream)
            "Output file location:\n");
   fprintf (stream,
            "      --output-file=FILE Write output to specified file.\n");
+  fprintf (stream,
+           "      --output-image=FILE\n"
+           "                         Write the tables to FILE as a binary image, and\n"
+           "                         output a loader for such images instead of the\n"
+           "                         lookup function.\n");
+  fprintf (stream,
+           "      --lookup-template=FILE\n"
+           "                         Write the lookup template of --traits to FILE, and\n"
+           "                         include FILE in the output. The default is to\n"
+           "                         include gperf-lookup.h.\n");
+  fprintf (stream,
+           "      --shards=N         Split the tables into N files, named after the\n"
+           "                         output file, that can be compiled separately.\n");
   fprintf (stream,
            "The results are written to standard output if no output file is specified\n"
            "or if it is -.\n");
@@ -122,8 +142,8 @@ Options::long_usage (FILE * stream)
   fprintf (stream,
            "  -L, --language=LANGUAGE-NAME\n"
            "                         Generates code in the specified language. Languages\n"
-           "                         handled are currently C++, ANSI-C, C, and KR-C. The\n"
-           "                         default is ANSI-C.\n");
+           "                         handled are currently C++17, C++, ANSI-C, C, and\n"
+           "                         KR-C. The default is ANSI-C.\n");
   fprintf (stream, "\n");
   fprintf (stream,
            "Details in the output code:\n");
@@ -155,6 +175,10 @@ Options::long_usage (FILE * stream)
   fprintf (stream,
            "  -c, --compare-strncmp  Generate comparison code using strncmp rather than\n"
            "                         strcmp.\n");
+  fprintf (stream,
+           "      --string-view      Generate a lookup function that does not require\n"
+           "                         the string to be NUL terminated. Implies -l. In C++,\n"
+           "                         adds an overload taking a std::string_view.\n");
   fprintf (stream,
            "  -C, --readonly-tables  Make the contents of generated lookup tables\n"
            "                         constant, i.e., readonly.\n");
@@ -176,6 +200,12 @@ Options::long_usage (FILE * stream)
            "  -Q, --string-pool-name=NAME\n"
            "                         Specify name of string pool generated by option --pic.\n"
            "                         Default name is 'stringpool'.\n");
+  fprintf (stream,
+           "      --binary-tables=METHOD\n"
+           "                         Write the string pool of option --pic and the\n"
+           "                         length table of option -l to binary files, that are\n"
+           "                         pulled in through METHOD: 'incbin' (an assembler\n"
+           "                         file) or 'embed' (C23 #embed).\n");
   fprintf (stream,
            "      --null-strings     Use NULL strings instead of empty strings for empty\n"
            "                         keyword table entries.\n");
@@ -206,6 +236,22 @@ Options::long_usage (FILE * stream)
            "                         Prevents the transfer of the type declaration to the\n"
            "                         output file. Use this option if the type is already\n"
            "                         defined elsewhere.\n");
+  fprintf (stream,
+           "      --simd             Use SIMD instructions (AVX2 gathers) in the hash\n"
+           "                         function for runs of 8 or more consecutive key\n"
+           "                         positions. A portable fallback is generated as well.\n");
+  fprintf (stream,
+           "      --prefilter[=N]    Reject most strings that are not keywords before\n"
+           "                         hashing them, through a Bloom filter over the\n"
+           "                         length and the first and last byte, with N bits\n"
+           "                         per keyword. Default value is %d.\n",
+           DEFAULT_PREFILTER_BITS);
+  fprintf (stream,
+           "      --traits           Generate a traits class for a lookup template that\n"
+           "                         is shared among all tables (requires C++17).\n");
+  fprintf (stream,
+           "      --benchmark        Generate a main program that times the lookup\n"
+           "                         function on the words of a corpus file.\n");
   fprintf (stream, "\n");
   fprintf (stream,
            "Algorithm employed by gperf:\n");
@@ -216,9 +262,10 @@ Options::long_usage (FILE * stream)
            "                         The positions are separated by commas, ranges may be\n"
            "                         used, and key positions may occur in any order.\n"
            "                         Also, the meta-character '*' causes the generated\n"
-           "                         hash function to consider ALL key positions, and $\n"
-           "                         indicates the \"final character\" of a key, e.g.,\n"
-           "                         $,1,2,4,6-10.\n",
+           "                         hash function to consider ALL key positions, $\n"
+           "                         indicates the \"final character\" of a key, and $-N\n"
+           "                         the character N positions before it, e.g.,\n"
+           "                         $,$-1,1,2,4,6-10.\n",
            Positions::MAX_KEY_POS);
   fprintf (stream,
            "  -D, --duplicates       Handle keywords that hash to duplicate values. This\n"
@@ -226,9 +273,10 @@ Options::long_usage (FILE * stream)
   fprintf (stream,
            "  -m, --multiple-iterations=ITERATIONS\n"
            "                         Perform multiple choices of the -i and -j values,\n"
-           "                         and choose the best results. This increases the\n"
-           "                         running time by a factor of ITERATIONS but does a\n"
-           "                         good job minimizing the generated table size.\n");
+           "                         or with -r multiple random searches, and choose\n"
+           "                         the best results. This increases the running time\n"
+           "                         by a factor of ITERATIONS but does a good job\n"
+           "                         minimizing the generated table size.\n");
   fprintf (stream,
            "  -i, --initial-asso=N   Provide an initial value for the associate values\n"
            "                         array. Default is 0. Setting this value larger helps\n"
@@ -244,6 +292,13 @@ Options::long_usage (FILE * stream)
   fprintf (stream,
            "  -r, --random           Utilizes randomness to initialize the associated\n"
            "                         values table.\n");
+  fprintf (stream,
+           "      --seed=N           Use N as seed for the random numbers of -r and\n"
+           "                         -j0, so that the results are reproducible.\n");
+  fprintf (stream,
+           "      --reduce-alphabet  Try to reduce the alphabet to 16 character classes,\n"
+           "                         so that the associated values table has only 16\n"
+           "                         entries.\n");
   fprintf (stream,
            "  -s, --size-multiple=N  Affects the size of the generated hash table. The\n"
            "                         numeric argument N indicates \"how many times larger\n"
@@ -257,13 +312,33 @@ Options::long_usage (FILE * stream)
            "                         decrease the time required for an unsuccessful\n"
            "                         search, at the expense of extra table space. Default\n"
            "                         value is 1.\n");
+  fprintf (stream,
+           "      --threads=N        Use N threads for parsing the keywords of large\n"
+           "                         input files and for searching the associated\n"
+           "                         values of many keywords. Default value is 1.\n");
+  fprintf (stream,
+           "      --solver[=N]       After the search, lower the maximum hash value by\n"
+           "                         an exact search that explores at most N nodes.\n"
+           "                         Default value is %d.\n",
+           DEFAULT_SOLVER_LIMIT);
+  fprintf (stream,
+           "      --minimize-range   After the search, lower the maximum hash value by\n"
+           "                         a local search on the associated values.\n");
+  fprintf (stream,
+           "      --portfolio[=OBJECTIVE]\n"
+           "                         Run searches with different key positions, size\n"
+           "                         multiples and use of the length in parallel, and\n"
+           "                         use the best one. OBJECTIVE is one of size,\n"
+           "                         positions, cost. Default is size.\n");
   fprintf (stream, "\n");
   fprintf (stream,
            "Informative output:\n"
            "  -h, --help             Print this message.\n"
            "  -v, --version          Print the gperf version number.\n"
            "  -d, --debug            Enables the debugging option (produces verbose\n"
-           "                         output to the standard error).\n");
+           "                         output to the standard error).\n"
+           "      --stats=FILE       Write the time spent in each phase and some\n"
+           "                         counters of the search to FILE, in JSON format.\n");
   fprintf (stream, "\n");
   fprintf (stream,
            "Report bugs to <bug-gperf@gnu.org>.\n");
@@ -272,9 +347,9 @@ Options::long_usage (FILE * stream)
 /* Prints the given options.  */
 
 void
-Options::print_options () const
+Options::print_options (Output_Buffer& out) const
 {
-  printf ("/* Command-line: ");
+  out.put ("/* Command-line: ");
 
   for (int i = 0; i < _argument_count; i++)
     {
@@ -283,24 +358,24 @@ Options::print_options () const
       /* Escape arg if it contains shell metacharacters.  */
       if (*arg == '-')
         {
-          putchar (*arg);
+          out.put (*arg);
           arg++;
           if ((*arg >= 'A' && *arg <= 'Z') || (*arg >= 'a' && *arg <= 'z'))
             {
-              putchar (*arg);
+              out.put (*arg);
               arg++;
             }
           else if (*arg == '-')
             {
               do
                 {
-                  putchar (*arg);
+                  out.put (*arg);
                   arg++;
                 }
               while ((*arg >= 'A' && *arg <= 'Z') || (*arg >= 'a' && *arg <= 'z') || *arg == '-');
               if (*arg == '=')
                 {
-                  putchar (*arg);
+                  out.put (*arg);
                   arg++;
                 }
             }
@@ -309,34 +384,34 @@ Options::print_options () const
         {
           if (strchr (arg, '\'') != NULL)
             {
-              putchar ('"');
+              out.put ('"');
               for (; *arg; arg++)
                 {
                   if (*arg == '\"' || *arg == '\\' || *arg == '$' || *arg == '`')
-                    putchar ('\\');
-                  putchar (*arg);
+                    out.put ('\\');
+                  out.put (*arg);
                 }
-              putchar ('"');
+              out.put ('"');
             }
           else
             {
-              putchar ('\'');
+              out.put ('\'');
               for (; *arg; arg++)
                 {
                   if (*arg == '\\')
-                    putchar ('\\');
-                  putchar (*arg);
+                    out.put ('\\');
+                  out.put (*arg);
                 }
-              putchar ('\'');
+              out.put ('\'');
             }
         }
       else
-        printf ("%s", arg);
+        out.put (arg);
 
-      printf (" ");
+      out.put (" ");
     }
 
-  printf (" */");
+  out.put (" */");
 }
 
 /* ------------------------------------------------------------------------- */
@@ -359,7 +434,8 @@ private:
   int const             _low_bound;
   /* Greatest possible value, inclusive.  */
   int const             _high_bound;
-  /* A value marking the abstract "end of word" ( usually '$').  */
+  /* A value marking the abstract "end of word" ( usually '$').  '$-N' is
+     returned as _end_word_marker - N.  */
   int const             _end_word_marker;
   /* Error value returned when input is syntactically erroneous.  */
   int const             _error_value;
@@ -409,6 +485,23 @@ PositionStringParser::nextPosition ()
           case '$':
             /* Valid key position.  */
             _str++;
+            if (*_str == '-')
+              {
+                /* A position counted from the end: '$-N'.  */
+                _str++;
+                if (!isdigit (static_cast<unsigned char>(*_str)))
+                  return _error_value;
+                int offset;
+                for (offset = 0; isdigit (static_cast<unsigned char>(*_str)); _str++)
+                  {
+                    offset = offset * 10 + (*_str - '0');
+                    if (offset >= _high_bound)
+                      return _error_value;
+                  }
+                if (offset == 0)
+                  return _error_value;
+                return _end_word_marker - offset;
+              }
             return _end_word_marker;
           case '0': case '1': case '2': case '3': case '4':
           case '5': case '6': case '7': case '8': case '9':
@@ -457,12 +550,21 @@ Options::Options ()
   : _option_word (ANSIC),
     _input_file_name (NULL),
     _output_file_name (NULL),
+    _image_file_name (NULL),
+    _stats_file_name (NULL),
+    _lookup_template_file_name (NULL),
     _language (NULL),
     _jump (DEFAULT_JUMP_VALUE),
     _initial_asso_value (0),
     _asso_iterations (0),
     _total_switches (1),
     _size_multiple (1),
+    _threads (1),
+    _shards (1),
+    _solver_limit (0),
+    _prefilter_bits (0),
+    _seed (-1),
+    _portfolio (PORTFOLIO_NONE),
     _function_name (DEFAULT_FUNCTION_NAME),
     _slot_name (DEFAULT_SLOT_NAME),
     _initializer_suffix (DEFAULT_INITIALIZER_SUFFIX),
@@ -490,6 +592,7 @@ Options::~Options ()
                "\nC is...........: %s"
                "\nANSIC is.......: %s"
                "\nCPLUSPLUS is...: %s"
+               "\nCPLUSPLUS17 is.: %s"
                "\nSEVENBIT is....: %s"
                "\nLENTABLE is....: %s"
                "\nCOMP is........: %s"
@@ -501,9 +604,17 @@ Options::~Options ()
                "\nSHAREDLIB is...: %s"
                "\nSWITCH is......: %s"
                "\nNOTYPE is......: %s"
+               "\nSIMD is........: %s"
+               "\nTRAITS is......: %s"
+               "\nSTRINGVIEW is..: %s"
+               "\nINCBIN is......: %s"
+               "\nEMBED is.......: %s"
+               "\nBENCHMARK is...: %s"
                "\nDUP is.........: %s"
                "\nNOLENGTH is....: %s"
                "\nRANDOM is......: %s"
+               "\nREDUCE is......: %s"
+               "\nMINRANGE is....: %s"
                "\nDEBUG is.......: %s"
                "\nlookup function name = %s"
                "\nhash function name = %s"
@@ -517,13 +628,22 @@ Options::~Options ()
                "\nhash table size multiplier = %g"
                "\ninitial associated value = %d"
                "\ndelimiters = %s"
-               "\nnumber of switch statements = %d\n",
+               "\nnumber of switch statements = %d"
+               "\nnumber of threads = %d"
+               "\nnumber of shards = %d"
+               "\nsolver node limit = %d"
+               "\nprefilter bits per keyword = %d"
+               "\nrandom seed = %d"
+               "\nportfolio objective = %s"
+               "\nstatistics file = %s"
+               "\nlookup template file = %s\n",
                _option_word & TYPE ? "enabled" : "disabled",
                _option_word & UPPERLOWER ? "enabled" : "disabled",
                _option_word & KRC ? "enabled" : "disabled",
                _option_word & C ? "enabled" : "disabled",
                _option_word & ANSIC ? "enabled" : "disabled",
                _option_word & CPLUSPLUS ? "enabled" : "disabled",
+               _option_word & CPLUSPLUS17 ? "enabled" : "disabled",
                _option_word & SEVENBIT ? "enabled" : "disabled",
                _option_word & LENTABLE ? "enabled" : "disabled",
                _option_word & COMP ? "enabled" : "disabled",
@@ -535,14 +655,27 @@ Options::~Options ()
                _option_word & SHAREDLIB ? "enabled" : "disabled",
                _option_word & SWITCH ? "enabled" : "disabled",
                _option_word & NOTYPE ? "enabled" : "disabled",
+               _option_word & SIMD ? "enabled" : "disabled",
+               _option_word & TRAITS ? "enabled" : "disabled",
+               _option_word & STRINGVIEW ? "enabled" : "disabled",
+               _option_word & INCBIN ? "enabled" : "disabled",
+               _option_word & EMBED ? "enabled" : "disabled",
+               _option_word & BENCHMARK ? "enabled" : "disabled",
                _option_word & DUP ? "enabled" : "disabled",
                _option_word & NOLENGTH ? "enabled" : "disabled",
                _option_word & RANDOM ? "enabled" : "disabled",
+               _option_word & REDUCE ? "enabled" : "disabled",
+               _option_word & MINRANGE ? "enabled" : "disabled",
                _option_word & DEBUG ? "enabled" : "disabled",
                _function_name, _hash_name, _wordlist_name, _lengthtable_name,
                _stringpool_name, _slot_name, _initializer_suffix,
                _asso_iterations, _jump, _size_multiple, _initial_asso_value,
-               _delimiters, _total_switches);
+               _delimiters, _total_switches, _threads, _shards, _solver_limit, _prefilter_bits, _seed,
+               _portfolio == PORTFOLIO_SIZE ? "size" :
+               _portfolio == PORTFOLIO_POSITIONS ? "positions" :
+               _portfolio == PORTFOLIO_COST ? "cost" : "(none)",
+               _stats_file_name ? _stats_file_name : "(none)",
+               _lookup_template_file_name ? _lookup_template_file_name : "(none)");
       if (_key_positions.is_useall())
         fprintf (stderr, "all characters are used in the hash function\n");
       else
@@ -554,6 +687,8 @@ Options::~Options ()
           for (int pos; (pos = iter.next()) != PositionIterator::EOS; )
             if (pos == Positions::LASTCHAR)
               fprintf (stderr, "$\n");
+            else if (pos < 0)
+              fprintf (stderr, "$-%d\n", Positions::LASTCHAR - pos);
             else
               fprintf (stderr, "%d\n", pos + 1);
         }
@@ -570,7 +705,7 @@ Options::set_language (const char *language)
   if (_language == NULL)
     {
       _language = language;
-      _option_word &= ~(KRC | C | ANSIC | CPLUSPLUS);
+      _option_word &= ~(KRC | C | ANSIC | CPLUSPLUS | CPLUSPLUS17);
       if (!strcmp (language, "KR-C"))
         _option_word |= KRC;
       else if (!strcmp (language, "C"))
@@ -579,6 +714,8 @@ Options::set_language (const char *language)
         _option_word |= ANSIC;
       else if (!strcmp (language, "C++"))
         _option_word |= CPLUSPLUS;
+      else if (!strcmp (language, "C++17"))
+        _option_word |= CPLUSPLUS | CPLUSPLUS17;
       else
         {
           fprintf (stderr,
@@ -686,6 +823,9 @@ Options::set_delimiters (const char *delimiters)
 static const struct option long_options[] =
 {
   { "output-file", required_argument, NULL, CHAR_MAX + 1 },
+  { "output-image", required_argument, NULL, CHAR_MAX + 11 },
+  { "shards", required_argument, NULL, CHAR_MAX + 12 },
+  { "binary-tables", required_argument, NULL, CHAR_MAX + 13 },
   { "ignore-case", no_argument, NULL, CHAR_MAX + 2 },
   { "delimiters", required_argument, NULL, 'e' },
   { "struct-type", no_argument, NULL, 't' },
@@ -708,6 +848,17 @@ static const struct option long_options[] =
   { "length-table-name", required_argument, NULL, CHAR_MAX + 4 },
   { "switch", required_argument, NULL, 'S' },
   { "omit-struct-type", no_argument, NULL, 'T' },
+  { "simd", no_argument, NULL, CHAR_MAX + 6 },
+  { "prefilter", optional_argument, NULL, CHAR_MAX + 20 },
+  { "lookup-template", required_argument, NULL, CHAR_MAX + 21 },
+  { "traits", no_argument, NULL, CHAR_MAX + 8 },
+  { "string-view", no_argument, NULL, CHAR_MAX + 9 },
+  { "benchmark", no_argument, NULL, CHAR_MAX + 15 },
+  { "threads", required_argument, NULL, CHAR_MAX + 10 },
+  { "solver", optional_argument, NULL, CHAR_MAX + 16 },
+  { "minimize-range", no_argument, NULL, CHAR_MAX + 17 },
+  { "seed", required_argument, NULL, CHAR_MAX + 18 },
+  { "portfolio", optional_argument, NULL, CHAR_MAX + 19 },
   { "key-positions", required_argument, NULL, 'k' },
   { "compare-strlen", no_argument, NULL, 'l' }, /* backward compatibility */
   { "compare-lengths", no_argument, NULL, 'l' },
@@ -723,10 +874,12 @@ static const struct option long_options[] =
   { "string-pool-name", required_argument, NULL, 'Q' },
   { "null-strings", no_argument, NULL, CHAR_MAX + 3 },
   { "random", no_argument, NULL, 'r' },
+  { "reduce-alphabet", no_argument, NULL, CHAR_MAX + 7 },
   { "size-multiple", required_argument, NULL, 's' },
   { "help", no_argument, NULL, 'h' },
   { "version", no_argument, NULL, 'v' },
   { "debug", no_argument, NULL, 'd' },
+  { "stats", required_argument, NULL, CHAR_MAX + 14 },
   { NULL, no_argument, NULL, 0 }
 };
 
@@ -833,7 +986,7 @@ Options::parse_options (int argc, char *argv[])
         case 'k':               /* Sets key positions used for hash function.  */
           {
             _option_word |= POSITIONS;
-            const int BAD_VALUE = -3;
+            const int BAD_VALUE = PositionIterator::EOS + 1;
             const int EOS = PositionIterator::EOS;
             int       value;
             PositionStringParser sparser (/*getopt*/optarg, 1, Positions::MAX_KEY_POS, Positions::LASTCHAR, BAD_VALUE, EOS);
@@ -842,43 +995,29 @@ Options::parse_options (int argc, char *argv[])
               _key_positions.set_useall(true);
             else
               {
-                _key_positions.set_useall(false);
-                int *key_positions = _key_positions.pointer();
-                int *key_pos;
+                _key_positions = Positions ();
 
-                for (key_pos = key_positions; (value = sparser.nextPosition()) != EOS; key_pos++)
+                while ((value = sparser.nextPosition()) != EOS)
                   {
                     if (value == BAD_VALUE)
                       {
-                        fprintf (stderr, "Invalid position value or range, use 1,2,3-%d,'$' or '*'.\n",
+                        fprintf (stderr, "Invalid position value or range, use 1,2,3-%d,'$','$-1' or '*'.\n",
                                          Positions::MAX_KEY_POS);
                         short_usage (stderr);
                         exit (1);
                       }
-                    if (key_pos - key_positions == Positions::MAX_SIZE)
-                      {
-                        /* More than Positions::MAX_SIZE key positions.
-                           Since all key positions are in the range
-                           0..Positions::MAX_KEY_POS-1 or == Positions::LASTCHAR,
-                           there must be duplicates.  */
-                        fprintf (stderr, "Duplicate key positions selected\n");
-                        short_usage (stderr);
-                        exit (1);
-                      }
-                    if (value != Positions::LASTCHAR)
+                    if (value > 0)
                       /* We use 0-based indices in the class Positions.  */
                       value = value - 1;
-                    *key_pos = value;
+                    _key_positions.append (value);
                   }
 
-                unsigned int total_keysig_size = key_pos - key_positions;
-                if (total_keysig_size == 0)
+                if (_key_positions.get_size() == 0)
                   {
                     fprintf (stderr, "No key positions selected.\n");
                     short_usage (stderr);
                     exit (1);
                   }
-                _key_positions.set_size (total_keysig_size);
 
                 /* Sorts the key positions *IN REVERSE ORDER!!*
                    This makes further routines more efficient.  Especially
@@ -1065,6 +1204,133 @@ There is NO WARRANTY, to the extent permitted by law.\n\
             _constants_prefix = /*getopt*/optarg;
             break;
           }
+        case CHAR_MAX + 6:      /* Use SIMD instructions in the hash function.  */
+          {
+            _option_word |= SIMD;
+            break;
+          }
+        case CHAR_MAX + 7:      /* Try to reduce the alphabet to 16 classes.  */
+          {
+            _option_word |= REDUCE;
+            break;
+          }
+        case CHAR_MAX + 8:      /* Generate a traits class for the lookup template.  */
+          {
+            _option_word |= TRAITS;
+            break;
+          }
+        case CHAR_MAX + 9:      /* Don't assume NUL terminated strings.  */
+          {
+            _option_word |= STRINGVIEW;
+            break;
+          }
+        case CHAR_MAX + 10:     /* Number of threads.  */
+          {
+            if ((_threads = atoi (/*getopt*/optarg)) <= 0)
+              {
+                fprintf (stderr, "number of threads must be positive, assuming 1\n");
+                _threads = 1;
+              }
+            break;
+          }
+        case CHAR_MAX + 11:     /* Set the image file name.  */
+          {
+            _image_file_name = /*getopt*/optarg;
+            break;
+          }
+        case CHAR_MAX + 12:     /* Number of shards.  */
+          {
+            if ((_shards = atoi (/*getopt*/optarg)) <= 0)
+              {
+                fprintf (stderr, "number of shards must be positive, assuming 1\n");
+                _shards = 1;
+              }
+            break;
+          }
+        case CHAR_MAX + 13:     /* Write binary tables.  */
+          {
+            _option_word &= ~(INCBIN | EMBED);
+            if (!strcmp (/*getopt*/optarg, "incbin"))
+              _option_word |= INCBIN;
+            else if (!strcmp (/*getopt*/optarg, "embed"))
+              _option_word |= EMBED;
+            else
+              {
+                fprintf (stderr, "Invalid value for option --binary-tables.\n");
+                short_usage (stderr);
+                exit (1);
+              }
+            break;
+          }
+        case CHAR_MAX + 14:     /* Set the statistics file name.  */
+          {
+            _stats_file_name = /*getopt*/optarg;
+            break;
+          }
+        case CHAR_MAX + 15:     /* Generate a benchmark driver.  */
+          {
+            _option_word |= BENCHMARK;
+            break;
+          }
+        case CHAR_MAX + 16:     /* Exact search for associated values.  */
+          {
+            if (/*getopt*/optarg == NULL)
+              _solver_limit = DEFAULT_SOLVER_LIMIT;
+            else if ((_solver_limit = atoi (/*getopt*/optarg)) <= 0)
+              {
+                fprintf (stderr, "solver node limit must be positive, assuming %d\n",
+                         DEFAULT_SOLVER_LIMIT);
+                _solver_limit = DEFAULT_SOLVER_LIMIT;
+              }
+            break;
+          }
+        case CHAR_MAX + 17:     /* Lower the maximum hash value.  */
+          {
+            _option_word |= MINRANGE;
+            break;
+          }
+        case CHAR_MAX + 18:     /* Seed of the random numbers.  */
+          {
+            if ((_seed = atoi (/*getopt*/optarg)) < 0)
+              {
+                fprintf (stderr, "random seed must not be negative, assuming 0\n");
+                _seed = 0;
+              }
+            break;
+          }
+        case CHAR_MAX + 19:     /* Portfolio search.  */
+          {
+            if (/*getopt*/optarg == NULL || !strcmp (/*getopt*/optarg, "size"))
+              _portfolio = PORTFOLIO_SIZE;
+            else if (!strcmp (/*getopt*/optarg, "positions"))
+              _portfolio = PORTFOLIO_POSITIONS;
+            else if (!strcmp (/*getopt*/optarg, "cost"))
+              _portfolio = PORTFOLIO_COST;
+            else
+              {
+                fprintf (stderr, "Invalid value for option --portfolio.\n");
+                short_usage (stderr);
+                exit (1);
+              }
+            break;
+          }
+        case CHAR_MAX + 20:     /* Prefilter in the lookup function.  */
+          {
+            if (/*getopt*/optarg == NULL)
+              _prefilter_bits = DEFAULT_PREFILTER_BITS;
+            else if ((_prefilter_bits = atoi (/*getopt*/optarg)) <= 0)
+              {
+                fprintf (stderr, "prefilter bits per keyword must be positive, assuming %d\n",
+                         DEFAULT_PREFILTER_BITS);
+                _prefilter_bits = DEFAULT_PREFILTER_BITS;
+              }
+            break;
+          }
+        case CHAR_MAX + 21:     /* Set the lookup template file name.  */
+          {
+            _lookup_template_file_name = /*getopt*/optarg;
+            break;
+          }
         default:
           short_usage (stderr);
           exit (1);
@@ -56,60 +56,106 @@ enum Option_Type
   /* Generate C++ code: prototypes, const, class, inline, enum.  */
   CPLUSPLUS    = 1 << 5,
 
+  /* Generate C++17 code: like C++, but with constexpr functions and tables,
+     usable in constant expressions.  Implies CPLUSPLUS.  */
+  CPLUSPLUS17  = 1 << 6,
+
   /* --- Details in the output code --- */
 
   /* Assume 7-bit, not 8-bit, characters.  */
-  SEVENBIT     = 1 << 6,
+  SEVENBIT     = 1 << 7,
 
   /* Generate a length table for string comparison.  */
-  LENTABLE     = 1 << 7,
+  LENTABLE     = 1 << 8,
 
   /* Generate strncmp rather than strcmp.  */
-  COMP         = 1 << 8,
+  COMP         = 1 << 9,
 
   /* Make the generated tables readonly (const).  */
-  CONST        = 1 << 9,
+  CONST        = 1 << 10,
 
   /* Use enum for constants.  */
-  ENUM         = 1 << 10,
+  ENUM         = 1 << 11,
 
   /* Generate #include statements.  */
-  INCLUDE      = 1 << 11,
+  INCLUDE      = 1 << 12,
 
   /* Make the keyword table a global variable.  */
-  GLOBAL       = 1 << 12,
+  GLOBAL       = 1 << 13,
 
   /* Use NULL strings instead of empty strings for empty table entries.  */
-  NULLSTRINGS  = 1 << 13,
+  NULLSTRINGS  = 1 << 14,
 
   /* Optimize for position-independent code.  */
-  SHAREDLIB    = 1 << 14,
+  SHAREDLIB    = 1 << 15,
 
   /* Generate switch output to save space.  */
-  SWITCH       = 1 << 15,
+  SWITCH       = 1 << 16,
 
   /* Don't include user-defined type definition in output -- it's already
      defined elsewhere.  */
-  NOTYPE       = 1 << 16,
+  NOTYPE       = 1 << 17,
+
+  /* Use SIMD instructions for runs of consecutive key positions in the
+     hash function.  */
+  SIMD         = 1 << 18,
+
+  /* Generate a traits class for a shared C++17 lookup template, instead of
+     a hash function and a lookup function.  */
+  TRAITS       = 1 << 19,
+
+  /* Make no assumption that the looked-up string is NUL terminated.  */
+  STRINGVIEW   = 1 << 20,
+
+  /* Write the string pool and the length table to binary files, and pull
+     them in through .incbin in a generated assembler file.  */
+  INCBIN       = 1 << 21,
+
+  /* Write the string pool and the length table to binary files, and pull
+     them in through #embed.  */
+  EMBED        = 1 << 22,
+
+  /* Generate a main program that benchmarks the lookup function.  */
+  BENCHMARK    = 1 << 23,
 
   /* --- Algorithm employed by gperf --- */
 
   /* Use the given key positions.  */
-  POSITIONS    = 1 << 17,
+  POSITIONS    = 1 << 24,
 
   /* Handle duplicate hash values for keywords.  */
-  DUP          = 1 << 18,
+  DUP          = 1 << 25,
 
   /* Don't include keyword length in hash computations.  */
-  NOLENGTH     = 1 << 19,
+  NOLENGTH     = 1 << 26,
 
   /* Randomly initialize the associated values table.  */
-  RANDOM       = 1 << 20,
+  RANDOM       = 1 << 27,
+
+  /* Try to reduce the alphabet to 16 character classes.  */
+  REDUCE       = 1 << 28,
+
+  /* Lower the maximum hash value through local search.  */
+  MINRANGE     = 1 << 29,
 
   /* --- Informative output --- */
 
   /* Enable debugging (prints diagnostics to stderr).  */
-  DEBUG        = 1 << 21
+  DEBUG        = 1 << 30
+};
+
+/* Enumeration of the objectives of the portfolio search.  */
+
+enum Portfolio_Objective
+{
+  /* No portfolio search.  */
+  PORTFOLIO_NONE,
+  /* Minimize the size of the keyword table.  */
+  PORTFOLIO_SIZE,
+  /* Minimize the number of key positions.  */
+  PORTFOLIO_POSITIONS,
+  /* Minimize the estimated cost of a lookup.  */
+  PORTFOLIO_COST
 };
 
 /* Class manager for gperf program Options.  */
@@ -127,7 +173,7 @@ public:
   void                  parse_options (int argc, char *argv[]);
 
   /* Prints the given options.  */
-  void                  print_options () const;
+  void                  print_options (Output_Buffer& out) const;
 
   /* Accessors.  */
 
@@ -142,6 +188,15 @@ public:
   /* Returns the output file name.  */
   const char *          get_output_file_name () const;
 
+  /* Returns the image file name.  */
+  const char *          get_image_file_name () const;
+
+  /* Returns the statistics file name.  */
+  const char *          get_stats_file_name () const;
+
+  /* Returns the file name of the lookup template of --traits.  */
+  const char *          get_lookup_template_file_name () const;
+
   /* Sets the output language, if not already set.  */
   void                  set_language (const char *language);
 
@@ -162,6 +217,27 @@ public:
   /* Returns the factor by which to multiply the generated table's size.  */
   float                 get_size_multiple () const;
 
+  /* Returns the number of threads to use.  */
+  int                   get_threads () const;
+
+  /* Returns the number of files that the tables are split into.  */
+  int                   get_shards () const;
+
+  /* Returns the maximum number of nodes explored by the exact search for
+     associated values, or 0 if it is disabled.  */
+  int                   get_solver_limit () const;
+
+  /* Returns the number of bits per keyword of the Bloom filter that the
+     lookup function checks before the hash function, or 0 if there is no
+     such filter.  */
+  int                   get_prefilter_bits () const;
+
+  /* Returns the seed of the random numbers, or -1 if it is not given.  */
+  int                   get_seed () const;
+
+  /* Returns the objective of the portfolio search.  */
+  Portfolio_Objective   get_portfolio () const;
+
   /* Returns the generated function name.  */
   const char *          get_function_name () const;
   /* Sets the generated function name, if not already set.  */
@@ -237,6 +313,15 @@ private:
   /* Name of output file.  */
   char *                _output_file_name;
 
+  /* Name of binary image file.  */
+  char *                _image_file_name;
+
+  /* Name of statistics file.  */
+  char *                _stats_file_name;
+
+  /* Name of the file to which the lookup template is written.  */
+  char *                _lookup_template_file_name;
+
   /* The output language.  */
   const char *          _language;
 
@@ -255,6 +340,24 @@ private:
   /* Factor by which to multiply the generated table's size.  */
   float                 _size_multiple;
 
+  /* Number of threads to use.  */
+  int                   _threads;
+
+  /* Number of files that the tables are split into.  */
+  int                   _shards;
+
+  /* Node limit of the exact search for associated values, or 0.  */
+  int                   _solver_limit;
+
+  /* Bits per keyword of the lookup prefilter, or 0.  */
+  int                   _prefilter_bits;
+
+  /* Seed of the random numbers, or -1.  */
+  int                   _seed;
+
+  /* Objective of the portfolio search.  */
+  Portfolio_Objective   _portfolio;
+
   /* Names used for generated lookup function.  */
   const char *          _function_name;
 
@@ -0,0 +1,136 @@
+/* Buffered writer for the generated code.
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of GNU GPERF.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Specification. */
+#include "output-buffer.h"
+
+#include <stdio.h>
+#include <stdarg.h> /* declares va_list */
+#include <string.h> /* declares memcpy() */
+
+/* Size of the buffer.  */
+static const size_t BUFFER_SIZE = 256 * 1024;
+
+Output_Buffer::Output_Buffer ()
+  : _buffer (new char[BUFFER_SIZE]),
+    _end (_buffer),
+    _limit (_buffer + BUFFER_SIZE),
+    _stream (stdout)
+{
+}
+
+Output_Buffer::~Output_Buffer ()
+{
+  flush ();
+  delete[] _buffer;
+}
+
+void
+Output_Buffer::put_slow (const char *s, size_t length)
+{
+  flush ();
+  if (length < BUFFER_SIZE)
+    {
+      memcpy (_end, s, length);
+      _end += length;
+    }
+  else
+    fwrite (s, 1, length, _stream);
+}
+
+void
+Output_Buffer::put_number (long n, int width)
+{
+  /* Enough room for the digits of a 128-bit number and the sign.  */
+  char digits[40];
+  char *p = digits + sizeof (digits);
+  unsigned long u = (n < 0 ? - static_cast<unsigned long>(n) : n);
+  do
+    {
+      *--p = '0' + u % 10;
+      u /= 10;
+    }
+  while (u > 0);
+  if (n < 0)
+    *--p = '-';
+  int length = digits + sizeof (digits) - p;
+  for (; width > length; width--)
+    put (' ');
+  put (p, length);
+}
+
+void
+Output_Buffer::format (const char *format, ...)
+{
+  va_list args;
+
+  va_start (args, format);
+  int length = vsnprintf (_end, _limit - _end, format, args);
+  va_end (args);
+  if (length < 0)
+    return;
+  if (static_cast<size_t>(length) < static_cast<size_t>(_limit - _end))
+    {
+      _end += length;
+      return;
+    }
+
+  /* Not enough room.  */
+  flush ();
+  if (static_cast<size_t>(length) < BUFFER_SIZE)
+    {
+      va_start (args, format);
+      vsnprintf (_end, _limit - _end, format, args);
+      va_end (args);
+      _end += length;
+    }
+  else
+    {
+      char *text = new char[length + 1];
+      va_start (args, format);
+      vsnprintf (text, length + 1, format, args);
+      va_end (args);
+      fwrite (text, 1, length, _stream);
+      delete[] text;
+    }
+}
+
+void
+Output_Buffer::flush ()
+{
+  /* A single large fwrite() call bypasses the stdio buffer.  */
+  if (_end > _buffer)
+    fwrite (_buffer, 1, _end - _buffer, _stream);
+  _end = _buffer;
+  fflush (_stream);
+}
+
+void
+Output_Buffer::set_stream (FILE *stream)
+{
+  flush ();
+  _stream = stream;
+}
+
+#ifndef __OPTIMIZE__
+
+#define INLINE /* not inline */
+#include "output-buffer.icc"
+#undef INLINE
+
+#endif /* not defined __OPTIMIZE__ */
@@ -0,0 +1,86 @@
+/* This may look like C code, but it is really -*- C++ -*- */
+
+/* Buffered writer for the generated code.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of GNU GPERF.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#ifndef output_buffer_h
+#define output_buffer_h 1
+
+#include <stddef.h>
+#include <stdio.h>
+
+/* An Output_Buffer collects the generated code in a large buffer and writes
+   it to stdout, or another stream, in big blocks.  Plain strings and
+   numbers are appended without going through a format string, and without
+   the per-call locking of stdio.  */
+
+class Output_Buffer
+{
+public:
+                        Output_Buffer ();
+                        ~Output_Buffer ();
+
+  /* Appends the byte C.  */
+  void                  put (char c);
+
+  /* Appends the NUL terminated string S.  */
+  void                  put (const char *s);
+
+  /* Appends the LENGTH bytes starting at S.  */
+  void                  put (const char *s, size_t length);
+
+  /* Appends the decimal representation of N, padded with spaces on the
+     left to at least WIDTH characters, like printf ("%*ld", WIDTH, N).  */
+  void                  put_number (long n, int width = 0);
+
+  /* Appends the output of printf (FORMAT, ...).  */
+  void                  format (const char *format, ...);
+
+  /* Writes the buffered output to the current stream.  Write errors are
+     reported through ferror on that stream.  */
+  void                  flush ();
+
+  /* Writes the buffered output, and directs further output to STREAM.  */
+  void                  set_stream (FILE *stream);
+
+private:
+  /* Appends the LENGTH bytes starting at S, after the buffer has run out
+     of room.  */
+  void                  put_slow (const char *s, size_t length);
+
+  /* The buffer.  */
+  char * const          _buffer;
+  /* End of the buffered output.  */
+  char *                _end;
+  /* End of the buffer.  */
+  char * const          _limit;
+  /* The stream to which the output is written.  */
+  FILE *                _stream;
+};
+
+#ifdef __OPTIMIZE__  /* efficiency hack! */
+
+#include <string.h>
+#define INLINE inline
+#include "output-buffer.icc"
+#undef INLINE
+
+#endif
+
+#endif
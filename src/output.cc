@@ -22,11 +22,14 @@
 #include "output.h"
 
 #include <stdio.h>
+#include <stdlib.h> /* declares exit() */
 #include <string.h> /* declares strncpy(), strchr() */
 #include <ctype.h>  /* declares isprint() */
 #include <assert.h> /* defines assert() */
 #include <limits.h> /* defines SCHAR_MAX etc. */
 #include "options.h"
+#include "output-buffer.h"
+#include "stats.h"
 #include "version.h"
 #include "config.h"
 
@@ -52,6 +55,9 @@
 
 /* ========================================================================= */
 
+/* The generated code is written through this buffer.  */
+static Output_Buffer out;
+
 /* The "register " storage-class specifier.  */
 static const char *register_scs;
 
@@ -64,6 +70,10 @@ static const char *const_readonly_array;
 /* The "const " qualifier, for the array type.  */
 static const char *const_for_struct;
 
+/* The "constexpr " specifier, for functions and tables that are usable in
+   constant expressions.  */
+static const char *constexpr_scs;
+
 /* Returns the smallest unsigned C type capable of holding integers
    up to N.  */
 
@@ -89,6 +99,65 @@ smallest_integral_type (int min, int max)
 
 /* ------------------------------------------------------------------------- */
 
+/* Returns the name of a file next to the output file: the output file name
+   without its extension, followed by SUFFIX and EXTENSION, or followed by
+   SUFFIX and the extension of the output file if EXTENSION is NULL.  */
+
+static char *
+derived_file_name (const char *suffix, const char *extension)
+{
+  const char *output_file_name = option.get_output_file_name ();
+  const char *base = strrchr (output_file_name, '/');
+  const char *end = strrchr (base != NULL ? base : output_file_name, '.');
+  if (end == NULL || end == base + 1 || end == output_file_name)
+    end = output_file_name + strlen (output_file_name);
+  if (extension == NULL)
+    extension = end;
+
+  char *file_name =
+    new char[end - output_file_name + strlen (suffix) + strlen (extension) + 1];
+  memcpy (file_name, output_file_name, end - output_file_name);
+  strcpy (file_name + (end - output_file_name), suffix);
+  strcat (file_name, extension);
+  return file_name;
+}
+
+/* Returns the name of the binary file that holds the given table, with
+   --binary-tables.  */
+
+static char *
+binary_table_file_name (const char *table_name)
+{
+  char *suffix = new char[strlen (table_name) + 2];
+  suffix[0] = '-';
+  strcpy (suffix + 1, table_name);
+  char *file_name = derived_file_name (suffix, ".bin");
+  delete[] suffix;
+  return file_name;
+}
+
+/* Returns the prefix of the names of the tables that have external
+   linkage: the name of the lookup function, or of its class in C++.  With
+   it, the tables of several keyword sets can be linked into the same
+   program.  */
+
+static const char *
+external_table_prefix ()
+{
+  return option[CPLUSPLUS] ? option.get_class_name () : option.get_function_name ();
+}
+
+/* Returns the last component of FILE_NAME.  */
+
+static const char *
+base_name (const char *file_name)
+{
+  const char *slash = strrchr (file_name, '/');
+  return (slash != NULL ? slash + 1 : file_name);
+}
+
+/* ------------------------------------------------------------------------- */
+
 /* Constructor.
    Note about the keyword list starting at head:
    - The list is ordered by increasing _hash_value.  This has been achieved
@@ -110,7 +179,8 @@ Output::Output (KeywordExt_List *head, const char *struct_decl,
                 int total_keys, int max_key_len, int min_key_len,
                 bool hash_includes_len, const Positions& positions,
                 const unsigned int *alpha_inc, int total_duplicates,
-                unsigned int alpha_size, const int *asso_values)
+                unsigned int alpha_size, bool alpha_reduced,
+                const int *asso_values)
   : _head (head), _struct_decl (struct_decl),
     _struct_decl_lineno (struct_decl_lineno), _return_type (return_type),
     _struct_tag (struct_tag),
@@ -126,7 +196,11 @@ Output::Output (KeywordExt_List *head, const char *struct_decl,
     _hash_includes_len (hash_includes_len),
     _key_positions (positions), _alpha_inc (alpha_inc),
     _total_duplicates (total_duplicates), _alpha_size (alpha_size),
-    _asso_values (asso_values)
+    _alpha_reduced (alpha_reduced), _asso_values (asso_values),
+    _table_size (0), _shard_size (0),
+    _table (NULL), _table_duplicates (NULL),
+    _binary_lengthtable (false), _pool_offsets (NULL),
+    _prefilter (NULL), _prefilter_size (0)
 {
 }
 
@@ -190,12 +264,12 @@ struct Output_Defines : public Output_Constants
 
 void Output_Defines::output_start ()
 {
-  printf ("\n");
+  out.put ("\n");
 }
 
 void Output_Defines::output_item (const char *name, int value)
 {
-  printf ("#define %s %d\n", name, value);
+  out.format ("#define %s %d\n", name, value);
 }
 
 void Output_Defines::output_end ()
@@ -219,25 +293,25 @@ private:
 
 void Output_Enum::output_start ()
 {
-  printf ("%senum\n"
-          "%s  {\n",
-          _indentation, _indentation);
+  out.format ("%senum\n"
+              "%s  {\n",
+              _indentation, _indentation);
   _pending_comma = false;
 }
 
 void Output_Enum::output_item (const char *name, int value)
 {
   if (_pending_comma)
-    printf (",\n");
-  printf ("%s    %s = %d", _indentation, name, value);
+    out.put (",\n");
+  out.format ("%s    %s = %d", _indentation, name, value);
   _pending_comma = true;
 }
 
 void Output_Enum::output_end ()
 {
   if (_pending_comma)
-    printf ("\n");
-  printf ("%s  };\n\n", _indentation);
+    out.put ("\n");
+  out.format ("%s  };\n\n", _indentation);
 }
 
 /* Outputs a constant in the given style.  */
@@ -264,6 +338,8 @@ Output::output_constants (struct Output_Constants& style) const
   output_constant (style, "MAX_WORD_LENGTH", _max_key_len);
   output_constant (style, "MIN_HASH_VALUE", _min_hash_value);
   output_constant (style, "MAX_HASH_VALUE", _max_hash_value);
+  if (_shard_size > 0)
+    output_constant (style, "SHARD_SIZE", _shard_size);
   style.output_end ();
 }
 
@@ -286,21 +362,22 @@ output_upperlower_table ()
 {
   unsigned int c;
 
-  printf ("#ifndef GPERF_DOWNCASE\n"
-          "#define GPERF_DOWNCASE 1\n"
-          "static unsigned char gperf_downcase[256] =\n"
-          "  {");
+  out.format ("#ifndef GPERF_DOWNCASE\n"
+              "#define GPERF_DOWNCASE 1\n"
+              "static %sunsigned char gperf_downcase[256] =\n"
+              "  {",
+              constexpr_scs);
   for (c = 0; c < 256; c++)
     {
       if ((c % 15) == 0)
-        printf ("\n   ");
-      printf (" %3d", c >= 'A' && c <= 'Z' ? c + 'a' - 'A' : c);
+        out.put ("\n   ");
+      out.format (" %3d", c >= 'A' && c <= 'Z' ? c + 'a' - 'A' : c);
       if (c < 255)
-        printf (",");
+        out.put (",");
     }
-  printf ("\n"
-          "  };\n"
-          "#endif\n\n");
+  out.put ("\n"
+           "  };\n"
+           "#endif\n\n");
 }
 
 #endif
@@ -310,50 +387,51 @@ output_upperlower_table ()
 static void
 output_upperlower_strcmp ()
 {
-  printf ("#ifndef GPERF_CASE_STRCMP\n"
-          "#define GPERF_CASE_STRCMP 1\n"
-          "static int\n"
-          "gperf_case_strcmp ");
-  printf (option[KRC] ?
-               "(s1, s2)\n"
-          "     %schar *s1;\n"
-          "     %schar *s2;\n" :
-          option[C] ?
-               "(s1, s2)\n"
-          "     %sconst char *s1;\n"
-          "     %sconst char *s2;\n" :
-          option[ANSIC] | option[CPLUSPLUS] ?
-               "(%sconst char *s1, %sconst char *s2)\n" :
-          "",
-          register_scs, register_scs);
+  out.format ("#ifndef GPERF_CASE_STRCMP\n"
+              "#define GPERF_CASE_STRCMP 1\n"
+              "static %sint\n"
+              "gperf_case_strcmp ",
+              constexpr_scs);
+  out.format (option[KRC] ?
+                   "(s1, s2)\n"
+              "     %schar *s1;\n"
+              "     %schar *s2;\n" :
+              option[C] ?
+                   "(s1, s2)\n"
+              "     %sconst char *s1;\n"
+              "     %sconst char *s2;\n" :
+              option[ANSIC] | option[CPLUSPLUS] ?
+                   "(%sconst char *s1, %sconst char *s2)\n" :
+              "",
+              register_scs, register_scs);
   #if USE_DOWNCASE_TABLE
-  printf ("{\n"
-          "  for (;;)\n"
-          "    {\n"
-          "      unsigned char c1 = gperf_downcase[(unsigned char)*s1++];\n"
-          "      unsigned char c2 = gperf_downcase[(unsigned char)*s2++];\n"
-          "      if (c1 != 0 && c1 == c2)\n"
-          "        continue;\n"
-          "      return (int)c1 - (int)c2;\n"
-          "    }\n"
-          "}\n");
+  out.put ("{\n"
+           "  for (;;)\n"
+           "    {\n"
+           "      unsigned char c1 = gperf_downcase[(unsigned char)*s1++];\n"
+           "      unsigned char c2 = gperf_downcase[(unsigned char)*s2++];\n"
+           "      if (c1 != 0 && c1 == c2)\n"
+           "        continue;\n"
+           "      return (int)c1 - (int)c2;\n"
+           "    }\n"
+           "}\n");
   #else
-  printf ("{\n"
-          "  for (;;)\n"
-          "    {\n"
-          "      unsigned char c1 = *s1++;\n"
-          "      unsigned char c2 = *s2++;\n"
-          "      if (c1 >= 'A' && c1 <= 'Z')\n"
-          "        c1 += 'a' - 'A';\n"
-          "      if (c2 >= 'A' && c2 <= 'Z')\n"
-          "        c2 += 'a' - 'A';\n"
-          "      if (c1 != 0 && c1 == c2)\n"
-          "        continue;\n"
-          "      return (int)c1 - (int)c2;\n"
-          "    }\n"
-          "}\n");
+  out.put ("{\n"
+           "  for (;;)\n"
+           "    {\n"
+           "      unsigned char c1 = *s1++;\n"
+           "      unsigned char c2 = *s2++;\n"
+           "      if (c1 >= 'A' && c1 <= 'Z')\n"
+           "        c1 += 'a' - 'A';\n"
+           "      if (c2 >= 'A' && c2 <= 'Z')\n"
+           "        c2 += 'a' - 'A';\n"
+           "      if (c1 != 0 && c1 == c2)\n"
+           "        continue;\n"
+           "      return (int)c1 - (int)c2;\n"
+           "    }\n"
+           "}\n");
   #endif
-  printf ("#endif\n\n");
+  out.put ("#endif\n\n");
 }
 
 /* Output gperf's ASCII-case insensitive strncmp replacement.  */
@@ -361,60 +439,61 @@ output_upperlower_strcmp ()
 static void
 output_upperlower_strncmp ()
 {
-  printf ("#ifndef GPERF_CASE_STRNCMP\n"
-          "#define GPERF_CASE_STRNCMP 1\n"
-          "static int\n"
-          "gperf_case_strncmp ");
-  printf (option[KRC] ?
-               "(s1, s2, n)\n"
-          "     %schar *s1;\n"
-          "     %schar *s2;\n"
-          "     %ssize_t n;\n" :
-          option[C] ?
-               "(s1, s2, n)\n"
-          "     %sconst char *s1;\n"
-          "     %sconst char *s2;\n"
-          "     %ssize_t n;\n" :
-          option[ANSIC] | option[CPLUSPLUS] ?
-               "(%sconst char *s1, %sconst char *s2, %ssize_t n)\n" :
-          "",
-          register_scs, register_scs, register_scs);
+  out.format ("#ifndef GPERF_CASE_STRNCMP\n"
+              "#define GPERF_CASE_STRNCMP 1\n"
+              "static %sint\n"
+              "gperf_case_strncmp ",
+              constexpr_scs);
+  out.format (option[KRC] ?
+                   "(s1, s2, n)\n"
+              "     %schar *s1;\n"
+              "     %schar *s2;\n"
+              "     %ssize_t n;\n" :
+              option[C] ?
+                   "(s1, s2, n)\n"
+              "     %sconst char *s1;\n"
+              "     %sconst char *s2;\n"
+              "     %ssize_t n;\n" :
+              option[ANSIC] | option[CPLUSPLUS] ?
+                   "(%sconst char *s1, %sconst char *s2, %ssize_t n)\n" :
+              "",
+              register_scs, register_scs, register_scs);
   #if USE_DOWNCASE_TABLE
-  printf ("{\n"
-          "  for (; n > 0;)\n"
-          "    {\n"
-          "      unsigned char c1 = gperf_downcase[(unsigned char)*s1++];\n"
-          "      unsigned char c2 = gperf_downcase[(unsigned char)*s2++];\n"
-          "      if (c1 != 0 && c1 == c2)\n"
-          "        {\n"
-          "          n--;\n"
-          "          continue;\n"
-          "        }\n"
-          "      return (int)c1 - (int)c2;\n"
-          "    }\n"
-          "  return 0;\n"
-          "}\n");
+  out.put ("{\n"
+           "  for (; n > 0;)\n"
+           "    {\n"
+           "      unsigned char c1 = gperf_downcase[(unsigned char)*s1++];\n"
+           "      unsigned char c2 = gperf_downcase[(unsigned char)*s2++];\n"
+           "      if (c1 != 0 && c1 == c2)\n"
+           "        {\n"
+           "          n--;\n"
+           "          continue;\n"
+           "        }\n"
+           "      return (int)c1 - (int)c2;\n"
+           "    }\n"
+           "  return 0;\n"
+           "}\n");
   #else
-  printf ("{\n"
-          "  for (; n > 0;)\n"
-          "    {\n"
-          "      unsigned char c1 = *s1++;\n"
-          "      unsigned char c2 = *s2++;\n"
-          "      if (c1 >= 'A' && c1 <= 'Z')\n"
-          "        c1 += 'a' - 'A';\n"
-          "      if (c2 >= 'A' && c2 <= 'Z')\n"
-          "        c2 += 'a' - 'A';\n"
-          "      if (c1 != 0 && c1 == c2)\n"
-          "        {\n"
-          "          n--;\n"
-          "          continue;\n"
-          "        }\n"
-          "      return (int)c1 - (int)c2;\n"
-          "    }\n"
-          "  return 0;\n"
-          "}\n");
+  out.put ("{\n"
+           "  for (; n > 0;)\n"
+           "    {\n"
+           "      unsigned char c1 = *s1++;\n"
+           "      unsigned char c2 = *s2++;\n"
+           "      if (c1 >= 'A' && c1 <= 'Z')\n"
+           "        c1 += 'a' - 'A';\n"
+           "      if (c2 >= 'A' && c2 <= 'Z')\n"
+           "        c2 += 'a' - 'A';\n"
+           "      if (c1 != 0 && c1 == c2)\n"
+           "        {\n"
+           "          n--;\n"
+           "          continue;\n"
+           "        }\n"
+           "      return (int)c1 - (int)c2;\n"
+           "    }\n"
+           "  return 0;\n"
+           "}\n");
   #endif
-  printf ("#endif\n\n");
+  out.put ("#endif\n\n");
 }
 
 /* Output gperf's ASCII-case insensitive memcmp replacement.  */
@@ -422,60 +501,61 @@ output_upperlower_strncmp ()
 static void
 output_upperlower_memcmp ()
 {
-  printf ("#ifndef GPERF_CASE_MEMCMP\n"
-          "#define GPERF_CASE_MEMCMP 1\n"
-          "static int\n"
-          "gperf_case_memcmp ");
-  printf (option[KRC] ?
-               "(s1, s2, n)\n"
-          "     %schar *s1;\n"
-          "     %schar *s2;\n"
-          "     %ssize_t n;\n" :
-          option[C] ?
-               "(s1, s2, n)\n"
-          "     %sconst char *s1;\n"
-          "     %sconst char *s2;\n"
-          "     %ssize_t n;\n" :
-          option[ANSIC] | option[CPLUSPLUS] ?
-               "(%sconst char *s1, %sconst char *s2, %ssize_t n)\n" :
-          "",
-          register_scs, register_scs, register_scs);
+  out.format ("#ifndef GPERF_CASE_MEMCMP\n"
+              "#define GPERF_CASE_MEMCMP 1\n"
+              "static %sint\n"
+              "gperf_case_memcmp ",
+              constexpr_scs);
+  out.format (option[KRC] ?
+                   "(s1, s2, n)\n"
+              "     %schar *s1;\n"
+              "     %schar *s2;\n"
+              "     %ssize_t n;\n" :
+              option[C] ?
+                   "(s1, s2, n)\n"
+              "     %sconst char *s1;\n"
+              "     %sconst char *s2;\n"
+              "     %ssize_t n;\n" :
+              option[ANSIC] | option[CPLUSPLUS] ?
+                   "(%sconst char *s1, %sconst char *s2, %ssize_t n)\n" :
+              "",
+              register_scs, register_scs, register_scs);
   #if USE_DOWNCASE_TABLE
-  printf ("{\n"
-          "  for (; n > 0;)\n"
-          "    {\n"
-          "      unsigned char c1 = gperf_downcase[(unsigned char)*s1++];\n"
-          "      unsigned char c2 = gperf_downcase[(unsigned char)*s2++];\n"
-          "      if (c1 == c2)\n"
-          "        {\n"
-          "          n--;\n"
-          "          continue;\n"
-          "        }\n"
-          "      return (int)c1 - (int)c2;\n"
-          "    }\n"
-          "  return 0;\n"
-          "}\n");
+  out.put ("{\n"
+           "  for (; n > 0;)\n"
+           "    {\n"
+           "      unsigned char c1 = gperf_downcase[(unsigned char)*s1++];\n"
+           "      unsigned char c2 = gperf_downcase[(unsigned char)*s2++];\n"
+           "      if (c1 == c2)\n"
+           "        {\n"
+           "          n--;\n"
+           "          continue;\n"
+           "        }\n"
+           "      return (int)c1 - (int)c2;\n"
+           "    }\n"
+           "  return 0;\n"
+           "}\n");
   #else
-  printf ("{\n"
-          "  for (; n > 0;)\n"
-          "    {\n"
-          "      unsigned char c1 = *s1++;\n"
-          "      unsigned char c2 = *s2++;\n"
-          "      if (c1 >= 'A' && c1 <= 'Z')\n"
-          "        c1 += 'a' - 'A';\n"
-          "      if (c2 >= 'A' && c2 <= 'Z')\n"
-          "        c2 += 'a' - 'A';\n"
-          "      if (c1 == c2)\n"
-          "        {\n"
-          "          n--;\n"
-          "          continue;\n"
-          "        }\n"
-          "      return (int)c1 - (int)c2;\n"
-          "    }\n"
-          "  return 0;\n"
-          "}\n");
+  out.put ("{\n"
+           "  for (; n > 0;)\n"
+           "    {\n"
+           "      unsigned char c1 = *s1++;\n"
+           "      unsigned char c2 = *s2++;\n"
+           "      if (c1 >= 'A' && c1 <= 'Z')\n"
+           "        c1 += 'a' - 'A';\n"
+           "      if (c2 >= 'A' && c2 <= 'Z')\n"
+           "        c2 += 'a' - 'A';\n"
+           "      if (c1 == c2)\n"
+           "        {\n"
+           "          n--;\n"
+           "          continue;\n"
+           "        }\n"
+           "      return (int)c1 - (int)c2;\n"
+           "    }\n"
+           "  return 0;\n"
+           "}\n");
   #endif
-  printf ("#endif\n\n");
+  out.put ("#endif\n\n");
 }
 
 /* ------------------------------------------------------------------------- */
@@ -486,15 +566,15 @@ output_upperlower_memcmp ()
 static void
 output_string (const char *key, int len)
 {
-  putchar ('"');
+  out.put ('"');
   for (; len > 0; len--)
     {
       unsigned char c = static_cast<unsigned char>(*key++);
       if (isprint (c))
         {
           if (c == '"' || c == '\\')
-            putchar ('\\');
-          putchar (c);
+            out.put ('\\');
+          out.put (c);
         }
       else
         {
@@ -502,28 +582,39 @@ output_string (const char *key, int len)
              C compilers didn't understand hexadecimal escapes, and because
              hexadecimal escapes are not limited to 2 digits, thus needing
              special care if the following character happens to be a digit.  */
-          putchar ('\\');
-          putchar ('0' + ((c >> 6) & 7));
-          putchar ('0' + ((c >> 3) & 7));
-          putchar ('0' + (c & 7));
+          out.put ('\\');
+          out.put ('0' + ((c >> 6) & 7));
+          out.put ('0' + ((c >> 3) & 7));
+          out.put ('0' + (c & 7));
         }
     }
-  putchar ('"');
+  out.put ('"');
+}
+
+/* Starts a new line of a table of numbers.  */
+
+static inline void
+output_table_newline (const char *indent)
+{
+  out.put ('\n');
+  out.put (indent);
+  out.put ("   ");
 }
 
 /* ------------------------------------------------------------------------- */
 
-/* Outputs a #line directive, referring to the given line number.  */
+/* Outputs a #line directive, referring to the given line number.
+   Line number 0 stands for an unknown line.  */
 
 static void
 output_line_directive (unsigned int lineno)
 {
   const char *file_name = option.get_input_file_name ();
-  if (file_name != NULL)
+  if (file_name != NULL && lineno > 0)
     {
-      printf ("#line %u ", lineno);
+      out.format ("#line %u ", lineno);
       output_string (file_name, strlen (file_name));
-      printf ("\n");
+      out.put ("\n");
     }
 }
 
@@ -537,10 +628,10 @@ output_const_type (const char *const_string, const char *type_string)
 {
   if (type_string[strlen(type_string)-1] == '*')
     /* For pointer types, put the 'const' after the type.  */
-    printf ("%s %s", type_string, const_string);
+    out.format ("%s %s", type_string, const_string);
   else
     /* For scalar or struct types, put the 'const' before the type.  */
-    printf ("%s%s ", const_string, type_string);
+    out.format ("%s%s ", const_string, type_string);
 }
 
 /* ----------------------- Output_Expr and subclasses ----------------------- */
@@ -567,7 +658,7 @@ private:
 
 void Output_Expr1::output_expr () const
 {
-  printf ("%s", _p1);
+  out.format ("%s", _p1);
 }
 
 #if 0 /* unused */
@@ -588,7 +679,7 @@ private:
 
 void Output_Expr2::output_expr () const
 {
-  printf ("%s%s", _p1, _p2);
+  out.format ("%s%s", _p1, _p2);
 }
 
 #endif
@@ -624,19 +715,19 @@ bool Output_Compare::output_firstchar_comparison (const Output_Expr& expr1,
   if (option[UPPERLOWER])
     {
       /* Incomplete comparison, just for speedup.  */
-      printf ("(((unsigned char)*");
+      out.put ("(((unsigned char)*");
       expr1.output_expr ();
-      printf (" ^ (unsigned char)*");
+      out.put (" ^ (unsigned char)*");
       expr2.output_expr ();
-      printf (") & ~32) == 0");
+      out.put (") & ~32) == 0");
       return false;
     }
   else
     {
       /* Complete comparison.  */
-      printf ("*");
+      out.put ("*");
       expr1.output_expr ();
-      printf (" == *");
+      out.put (" == *");
       expr2.output_expr ();
       return true;
     }
@@ -656,24 +747,24 @@ void Output_Compare_Strcmp::output_comparison (const Output_Expr& expr1,
                                                const Output_Expr& expr2) const
 {
   bool firstchar_done = output_firstchar_comparison (expr1, expr2);
-  printf (" && !");
+  out.put (" && !");
   if (option[UPPERLOWER])
-    printf ("gperf_case_");
-  printf ("strcmp (");
+    out.put ("gperf_case_");
+  out.put ("strcmp (");
   if (firstchar_done)
     {
       expr1.output_expr ();
-      printf (" + 1, ");
+      out.put (" + 1, ");
       expr2.output_expr ();
-      printf (" + 1");
+      out.put (" + 1");
     }
   else
     {
       expr1.output_expr ();
-      printf (", ");
+      out.put (", ");
       expr2.output_expr ();
     }
-  printf (")");
+  out.put (")");
 }
 
 /* This class outputs a comparison using strncmp.
@@ -692,27 +783,27 @@ void Output_Compare_Strncmp::output_comparison (const Output_Expr& expr1,
                                                 const Output_Expr& expr2) const
 {
   bool firstchar_done = output_firstchar_comparison (expr1, expr2);
-  printf (" && !");
+  out.put (" && !");
   if (option[UPPERLOWER])
-    printf ("gperf_case_");
-  printf ("strncmp (");
+    out.put ("gperf_case_");
+  out.put ("strncmp (");
   if (firstchar_done)
     {
       expr1.output_expr ();
-      printf (" + 1, ");
+      out.put (" + 1, ");
       expr2.output_expr ();
-      printf (" + 1, len - 1");
+      out.put (" + 1, len - 1");
     }
   else
     {
       expr1.output_expr ();
-      printf (", ");
+      out.put (", ");
       expr2.output_expr ();
-      printf (", len");
+      out.put (", len");
     }
-  printf (") && ");
+  out.put (") && ");
   expr2.output_expr ();
-  printf ("[len] == '\\0'");
+  out.put ("[len] == '\\0'");
 }
 
 /* This class outputs a comparison using memcmp.
@@ -732,25 +823,67 @@ void Output_Compare_Memcmp::output_comparison (const Output_Expr& expr1,
                                                const Output_Expr& expr2) const
 {
   bool firstchar_done = output_firstchar_comparison (expr1, expr2);
-  printf (" && !");
+  out.put (" && !");
   if (option[UPPERLOWER])
-    printf ("gperf_case_");
-  printf ("memcmp (");
+    out.put ("gperf_case_memcmp (");
+  else if (option[CPLUSPLUS17])
+    /* memcmp is not usable in constant expressions.  */
+    out.put ("std::char_traits<char>::compare (");
+  else
+    out.put ("memcmp (");
+  if (firstchar_done)
+    {
+      expr1.output_expr ();
+      out.put (" + 1, ");
+      expr2.output_expr ();
+      out.put (" + 1, len - 1");
+    }
+  else
+    {
+      expr1.output_expr ();
+      out.put (", ");
+      expr2.output_expr ();
+      out.put (", len");
+    }
+  out.put (")");
+}
+
+/* This class outputs a comparison that verifies the length of expr2 before
+   comparing the bytes, using only functions that are usable in constant
+   expressions.  expr1 need not be NUL terminated.
+   Note that the length of expr1 will be available through the local variable
+   'len'.  */
+
+struct Output_Compare_Length : public Output_Compare
+{
+  virtual void          output_comparison (const Output_Expr& expr1,
+                                           const Output_Expr& expr2) const;
+                        Output_Compare_Length () {}
+  virtual               ~Output_Compare_Length () {}
+};
+
+void Output_Compare_Length::output_comparison (const Output_Expr& expr1,
+                                               const Output_Expr& expr2) const
+{
+  bool firstchar_done = output_firstchar_comparison (expr1, expr2);
+  out.put (" && std::char_traits<char>::length (");
+  expr2.output_expr ();
+  out.put (") == len && !std::char_traits<char>::compare (");
   if (firstchar_done)
     {
       expr1.output_expr ();
-      printf (" + 1, ");
+      out.put (" + 1, ");
       expr2.output_expr ();
-      printf (" + 1, len - 1");
+      out.put (" + 1, len - 1");
     }
   else
     {
       expr1.output_expr ();
-      printf (", ");
+      out.put (", ");
       expr2.output_expr ();
-      printf (", len");
+      out.put (", len");
     }
-  printf (")");
+  out.put (")");
 }
 
 /* ------------------------------------------------------------------------- */
@@ -760,13 +893,13 @@ void Output_Compare_Memcmp::output_comparison (const Output_Expr& expr1,
 void
 Output::output_asso_values_index (int pos) const
 {
-  if (pos == Positions::LASTCHAR)
-    printf ("str[len - 1]");
+  if (pos < 0)
+    out.format ("str[len - %d]", - pos);
   else
     {
-      printf ("str[%d]", pos);
+      out.format ("str[%d]", pos);
       if (_alpha_inc[pos])
-        printf ("+%u", _alpha_inc[pos]);
+        out.format ("+%u", _alpha_inc[pos]);
     }
 }
 
@@ -775,88 +908,239 @@ Output::output_asso_values_index (int pos) const
 void
 Output::output_asso_values_ref (int pos) const
 {
-  printf ("asso_values[");
+  out.put ("asso_values[");
   /* Always cast to unsigned char.  This is necessary when the alpha_inc
      is nonzero, and also avoids a gcc warning "subscript has type 'char'".  */
   if (option[CPLUSPLUS])
     {
       /* In C++, a C style cast may lead to a 'warning: use of old-style cast'.
          Therefore prefer the C++ style cast syntax.  */
-      printf ("static_cast<unsigned char>(");
+      out.put ("static_cast<unsigned char>(");
       output_asso_values_index (pos);
-      printf (")");
+      out.put (")");
     }
   else
     {
-      printf ("(unsigned char)");
+      /* With a reduced alphabet, parenthesize the sum before masking it.  */
+      bool parens =
+        _alpha_reduced && pos >= 0 && _alpha_inc[pos];
+      if (parens)
+        out.put ("(");
+      out.put ("(unsigned char)");
       output_asso_values_index (pos);
+      if (parens)
+        out.put (")");
     }
-  printf ("]");
+  if (_alpha_reduced)
+    out.put (" & 15");
+  out.put ("]");
 }
 
-/* Generates C code for the hash function that returns the
-   proper encoding for each keyword.
-   The hash function has the signature
-     unsigned int <hash> (const char *str, size_t len).  */
+/* Generates a C expression for the hash function's term of a key position.  */
 
 void
-Output::output_hash_function () const
+Output::output_asso_values_term (int pos) const
 {
-  /* Output the function's head.  */
-  if (option[CPLUSPLUS])
-    printf ("inline ");
-  else if (option[KRC] | option[C] | option[ANSIC])
-    printf ("#ifdef __GNUC__\n"
-            "__inline\n"
-            "#else\n"
-            "#ifdef __cplusplus\n"
-            "inline\n"
-            "#endif\n"
-            "#endif\n");
+  /* The hash function is called only with min_key_len <= len, so a guard
+     is needed only for the positions counted from the end that go beyond
+     the start of the shortest keyword.  */
+  if (pos < 0 && - pos > _min_key_len)
+    {
+      out.format ("(len >= %d ? ", - pos);
+      output_asso_values_ref (pos);
+      out.put (" : 0)");
+    }
+  else
+    output_asso_values_ref (pos);
+}
 
-  if (/* The function does not use the 'str' argument?  */
-      _key_positions.get_size() == 0
-      || /* The function uses 'str', but not the 'len' argument?  */
-         (!_hash_includes_len
-          && _key_positions[0] < _min_key_len
-          && _key_positions[_key_positions.get_size() - 1] != Positions::LASTCHAR))
-    /* Pacify lint.  */
-    printf ("/*ARGSUSED*/\n");
+/* Number of key positions summed up by one SIMD instruction sequence.  */
+static const int SIMD_LANES = 8;
 
-  if (option[KRC] | option[C] | option[ANSIC])
-    printf ("static ");
-  printf ("unsigned int\n");
-  if (option[CPLUSPLUS])
-    printf ("%s::", option.get_class_name ());
-  printf ("%s ", option.get_hash_name ());
-  printf (option[KRC] ?
-                 "(str, len)\n"
-            "     %schar *str;\n"
-            "     %ssize_t len;\n" :
-          option[C] ?
-                 "(str, len)\n"
-            "     %sconst char *str;\n"
-            "     %ssize_t len;\n" :
-          option[ANSIC] | option[CPLUSPLUS] ?
-                 "(%sconst char *str, %ssize_t len)\n" :
-          "",
-          register_scs, register_scs);
+/* Returns the size in bytes of the asso_values[] elements, when they are
+   all <= n.  Corresponds to smallest_integral_type (n).  */
 
-  /* Note that when the hash function is called, it has already been verified
-     that  min_key_len <= len <= max_key_len.  */
+static int
+smallest_integral_size (int n)
+{
+  if (n <= UCHAR_MAX) return 1;
+  if (n <= USHRT_MAX) return 2;
+  return 4;
+}
 
-  /* Output the function's body.  */
-  printf ("{\n");
+/* Determines the run of consecutive key positions that the hash function
+   sums up with SIMD instructions.  Only positions < _min_key_len qualify,
+   because these bytes are present in every string passed to the hash
+   function.  Sets count to a multiple of SIMD_LANES, possibly 0.  */
+
+void
+Output::find_simd_run (int& first, int& count) const
+{
+  first = 0;
+  count = 0;
+  /* SIMD intrinsics are not usable in constant expressions.  */
+  if (!option[SIMD] || option[CPLUSPLUS17])
+    return;
+
+  /* The positions are sorted in decreasing order.  */
+  PositionIterator iter = _key_positions.iterator(_max_key_len);
+  int run_low = 0;
+  int run_length = 0;
+  for (int key_pos; (key_pos = iter.next ()) != PositionIterator::EOS; )
+    {
+      if (key_pos < 0 || key_pos >= _min_key_len)
+        continue;
+      if (run_length > 0 && key_pos == run_low - 1)
+        run_length++;
+      else
+        run_length = 1;
+      run_low = key_pos;
+      if (run_length - run_length % SIMD_LANES > count)
+        {
+          first = run_low;
+          count = run_length - run_length % SIMD_LANES;
+        }
+    }
+}
+
+/* Returns true if the SIMD code looks up the asso_values[] with a byte
+   shuffle instead of a gather instruction.  This requires a reduced
+   alphabet, so that the table fits in a single 16-byte register, and
+   byte-sized elements.  */
+
+bool
+Output::simd_uses_shuffle () const
+{
+  return _alpha_reduced && smallest_integral_size (_max_hash_value + 1) == 1;
+}
+
+/* Generates C code that adds the asso_values[] of the key positions
+   first..first+count-1 to hval.  With AVX2, SIMD_LANES bytes are widened
+   to 32-bit indices and looked up with a single gather instruction.  The
+   gather reads 4 bytes per element; the asso_values array is padded
+   accordingly.  With a reduced alphabet of byte-sized values, the whole
+   asso_values array is held in a register instead, and SSSE3 looks up
+   SIMD_LANES bytes with a single shuffle instruction.  */
+
+void
+Output::output_asso_values_simd (int first, int count) const
+{
+  int element_size = smallest_integral_size (_max_hash_value + 1);
+
+  if (simd_uses_shuffle ())
+    {
+      out.format ("#if defined __SSSE3__\n"
+                  "  {\n"
+                  "    __m128i idx;\n"
+                  "    const __m128i table = _mm_loadu_si128 (%sasso_values%s);\n"
+                  "\n",
+                  option[CPLUSPLUS]
+                  ? "reinterpret_cast<const __m128i *>("
+                  : "(const __m128i *) ",
+                  option[CPLUSPLUS] ? ")" : "");
+      for (int chunk = first; chunk < first + count; chunk += SIMD_LANES)
+        {
+          out.format ("    idx = _mm_loadl_epi64 (%s(str + %d));\n",
+                      option[CPLUSPLUS]
+                      ? "reinterpret_cast<const __m128i *>"
+                      : "(const __m128i *) ",
+                      chunk);
+          /* Only the alpha increments mod 16 matter.  */
+          bool have_alpha_inc = false;
+          for (int i = 0; i < SIMD_LANES; i++)
+            if (_alpha_inc[chunk + i] % 16)
+              have_alpha_inc = true;
+          if (have_alpha_inc)
+            {
+              out.put ("    idx = _mm_add_epi8 (idx, _mm_setr_epi8 (");
+              for (int i = 0; i < SIMD_LANES; i++)
+                out.format ("%u, ", _alpha_inc[chunk + i] % 16);
+              out.put ("0, 0, 0, 0, 0, 0, 0, 0));\n");
+            }
+          /* The upper SIMD_LANES bytes are summed up separately by
+             _mm_sad_epu8, and then ignored.  */
+          out.put ("    idx = _mm_and_si128 (idx, _mm_set1_epi8 (0x0f));\n"
+                   "    hval += _mm_cvtsi128_si32 (_mm_sad_epu8 (_mm_shuffle_epi8 (table, idx),\n"
+                   "                                             _mm_setzero_si128 ()));\n");
+        }
+      out.put ("  }\n");
+    }
+  else
+    {
+      out.put ("#if defined __AVX2__\n"
+               "  {\n"
+               "    __m256i idx;\n"
+               "    __m256i sum = _mm256_setzero_si256 ();\n"
+               "    __m128i total;\n"
+               "\n");
+      for (int chunk = first; chunk < first + count; chunk += SIMD_LANES)
+        {
+          out.format ("    idx = _mm256_cvtepu8_epi32 (_mm_loadl_epi64 (%s(str + %d)));\n",
+                      option[CPLUSPLUS]
+                      ? "reinterpret_cast<const __m128i *>"
+                      : "(const __m128i *) ",
+                      chunk);
+          bool have_alpha_inc = false;
+          for (int i = 0; i < SIMD_LANES; i++)
+            if (_alpha_inc[chunk + i])
+              have_alpha_inc = true;
+          if (have_alpha_inc)
+            {
+              out.put ("    idx = _mm256_add_epi32 (idx, _mm256_setr_epi32 (");
+              for (int i = 0; i < SIMD_LANES; i++)
+                out.format ("%s%u", i > 0 ? ", " : "", _alpha_inc[chunk + i]);
+              out.put ("));\n");
+            }
+          if (_alpha_reduced)
+            out.put ("    idx = _mm256_and_si256 (idx, _mm256_set1_epi32 (15));\n");
+          out.put ("    sum = _mm256_add_epi32 (sum, ");
+          if (element_size < 4)
+            out.put ("_mm256_and_si256 (");
+          out.format ("_mm256_i32gather_epi32 (%sasso_values%s, idx, %d)",
+                      option[CPLUSPLUS] ? "reinterpret_cast<const int *>(" : "(const int *) ",
+                      option[CPLUSPLUS] ? ")" : "",
+                      element_size);
+          if (element_size < 4)
+            out.format (", _mm256_set1_epi32 (0x%x))",
+                        element_size == 1 ? UCHAR_MAX : USHRT_MAX);
+          out.put (");\n");
+        }
+      out.put ("    total = _mm_add_epi32 (_mm256_castsi256_si128 (sum),\n"
+               "                           _mm256_extracti128_si256 (sum, 1));\n"
+               "    total = _mm_add_epi32 (total, _mm_shuffle_epi32 (total, 0x4e));\n"
+               "    total = _mm_add_epi32 (total, _mm_shuffle_epi32 (total, 0xb1));\n"
+               "    hval += _mm_cvtsi128_si32 (total);\n"
+               "  }\n");
+    }
+  out.put ("#else\n"
+           "  hval += ");
+  for (int pos = first + count - 1; pos >= first; pos--)
+    {
+      output_asso_values_ref (pos);
+      if (pos > first)
+        out.put ("\n        + ");
+    }
+  out.put (";\n"
+           "#endif\n");
+}
+
+/* Prints out the asso_values array, for use in the hash function.  */
+
+void
+Output::output_asso_values_table () const
+{
+  int simd_first;
+  int simd_count;
+  find_simd_run (simd_first, simd_count);
 
-  /* First the asso_values array.  */
   if (_key_positions.get_size() > 0)
     {
       /* The values in the asso_values array are all unsigned integers
          <= MAX_HASH_VALUE + 1.  */
-      printf ("  static %s%s asso_values[] =\n"
-              "    {",
-              const_readonly_array,
-              smallest_integral_type (_max_hash_value + 1));
+      out.format ("  static %s%s%s asso_values[] =\n"
+                  "    {",
+                  constexpr_scs, const_readonly_array,
+                  smallest_integral_type (_max_hash_value + 1));
 
       const int columns = 10;
 
@@ -865,45 +1149,151 @@ Output::output_hash_function () const
       for (int trunc = _max_hash_value + 1; (trunc /= 10) > 0;)
         field_width++;
 
-      for (unsigned int count = 0; count < _alpha_size; count++)
+      /* With a reduced alphabet, only the first 16 entries are used.  */
+      unsigned int table_size = (_alpha_reduced ? 16 : _alpha_size);
+
+      /* The SIMD gather instructions read 4 bytes per element.  Pad the
+         array so that they don't read beyond its end.  */
+      unsigned int padding = 0;
+      if (simd_count > 0 && !simd_uses_shuffle ())
+        padding = 4 / smallest_integral_size (_max_hash_value + 1) - 1;
+
+      for (unsigned int count = 0; count < table_size + padding; count++)
         {
           if (count > 0)
-            printf (",");
+            out.put (",");
           if ((count % columns) == 0)
-            printf ("\n     ");
-          printf ("%*d", field_width, _asso_values[count]);
+            out.put ("\n     ");
+          out.format ("%*d", field_width,
+                      count < table_size ? _asso_values[count] : _max_hash_value + 1);
         }
 
-      printf ("\n"
-              "    };\n");
+      out.put ("\n"
+               "    };\n");
+    }
+}
+
+/* Generates C code for the hash function that returns the
+   proper encoding for each keyword.
+   The hash function has the signature
+     unsigned int <hash> (const char *str, size_t len).  */
+
+void
+Output::output_hash_function () const
+{
+  int simd_first;
+  int simd_count;
+  find_simd_run (simd_first, simd_count);
+
+  if (simd_count > 0)
+    {
+      if (simd_uses_shuffle ())
+        out.put ("#if defined __SSSE3__\n"
+                 "#include <tmmintrin.h>\n"
+                 "#endif\n"
+                 "\n");
+      else
+        out.put ("#if defined __AVX2__\n"
+                 "#include <immintrin.h>\n"
+                 "#endif\n"
+                 "\n");
     }
 
-  if (_key_positions.get_size() == 0)
+  /* Output the function's head.  */
+  if (option[CPLUSPLUS17])
+    out.put ("constexpr ");
+  else if (option[CPLUSPLUS])
+    out.put ("inline ");
+  else if (option[KRC] | option[C] | option[ANSIC])
+    out.put ("#ifdef __GNUC__\n"
+             "__inline\n"
+             "#else\n"
+             "#ifdef __cplusplus\n"
+             "inline\n"
+             "#endif\n"
+             "#endif\n");
+
+  if (/* The function does not use the 'str' argument?  */
+      _key_positions.iterator(_max_key_len).remaining () == 0
+      || /* The function uses 'str', but not the 'len' argument?  */
+         (!_hash_includes_len
+          && _key_positions[0] < _min_key_len
+          && _key_positions[_key_positions.get_size() - 1] >= 0))
+    /* Pacify lint.  */
+    out.put ("/*ARGSUSED*/\n");
+
+  if (option[KRC] | option[C] | option[ANSIC])
+    out.put ("static ");
+  out.put ("unsigned int\n");
+  if (option[CPLUSPLUS])
+    out.format ("%s::", option.get_class_name ());
+  out.format ("%s ", option.get_hash_name ());
+  out.format (option[KRC] ?
+                     "(str, len)\n"
+                "     %schar *str;\n"
+                "     %ssize_t len;\n" :
+              option[C] ?
+                     "(str, len)\n"
+                "     %sconst char *str;\n"
+                "     %ssize_t len;\n" :
+              option[ANSIC] | option[CPLUSPLUS] ?
+                     "(%sconst char *str, %ssize_t len)\n" :
+              "",
+              register_scs, register_scs);
+
+  /* Note that when the hash function is called, it has already been verified
+     that  min_key_len <= len <= max_key_len.  */
+
+  /* Output the function's body.  */
+  out.put ("{\n");
+
+  /* First the asso_values array.  In C++17, it is a class member.  */
+  if (!option[CPLUSPLUS17])
+    output_asso_values_table ();
+
+  if (_key_positions.iterator(_max_key_len).remaining () == 0)
     {
-      /* Trivial case: No key positions at all.  */
-      printf ("  return %s;\n",
-              _hash_includes_len ? "len" : "0");
+      /* Trivial case: No key positions at all, or none that is present in
+         the keywords.  */
+      out.format ("  return %s;\n",
+                  _hash_includes_len ? "len" : "0");
     }
   else
     {
       /* Iterate through the key positions.  Remember that Positions::sort()
-         has sorted them in decreasing order, with Positions::LASTCHAR coming
-         last.  */
+         has sorted them in decreasing order, with the positions counted from
+         the end (Positions::LASTCHAR first) coming last.  */
       PositionIterator iter = _key_positions.iterator(_max_key_len);
       int key_pos;
 
       /* Get the highest key position.  */
       key_pos = iter.next ();
 
-      if (key_pos == Positions::LASTCHAR || key_pos < _min_key_len)
+      if (simd_count > 0 && key_pos < _min_key_len)
+        {
+          /* All key positions are present in every string.  Sum up the
+             run first, then add the remaining positions.  */
+          out.format ("  %sunsigned int hval = %s;\n\n",
+                      register_scs, _hash_includes_len ? "len" : "0");
+          output_asso_values_simd (simd_first, simd_count);
+          out.put ("  return hval");
+          for (; key_pos != PositionIterator::EOS; key_pos = iter.next ())
+            if (!(key_pos >= simd_first && key_pos < simd_first + simd_count))
+              {
+                out.put (" + ");
+                output_asso_values_term (key_pos);
+              }
+          out.put (";\n");
+        }
+      else if (key_pos < _min_key_len)
         {
           /* We can perform additional optimizations here:
              Write it out as a single expression. Note that the values
              are added as 'int's even though the asso_values array may
              contain 'unsigned char's or 'unsigned short's.  */
 
-          printf ("  return %s",
-                  _hash_includes_len ? "len + " : "");
+          out.format ("  return %s",
+                      _hash_includes_len ? "len + " : "");
 
           if (_key_positions.get_size() == 2
               && _key_positions[0] == 0
@@ -911,25 +1301,21 @@ Output::output_hash_function () const
             /* Optimize special case of "-k 1,$".  */
             {
               output_asso_values_ref (Positions::LASTCHAR);
-              printf (" + ");
+              out.put (" + ");
               output_asso_values_ref (0);
             }
           else
             {
-              for (; key_pos != Positions::LASTCHAR; )
+              for (;;)
                 {
-                  output_asso_values_ref (key_pos);
-                  if ((key_pos = iter.next ()) != PositionIterator::EOS)
-                    printf (" + ");
-                  else
+                  output_asso_values_term (key_pos);
+                  if ((key_pos = iter.next ()) == PositionIterator::EOS)
                     break;
+                  out.put (" + ");
                 }
-
-              if (key_pos == Positions::LASTCHAR)
-                output_asso_values_ref (Positions::LASTCHAR);
             }
 
-          printf (";\n");
+          out.put (";\n");
         }
       else
         {
@@ -945,57 +1331,74 @@ Output::output_hash_function () const
             "      /*FALLTHROUGH*/\n";
           /* It doesn't really matter whether hval is an 'int' or
              'unsigned int', but 'unsigned int' gives fewer warnings.  */
-          printf ("  %sunsigned int hval = %s;\n\n"
-                  "  switch (%s)\n"
-                  "    {\n"
-                  "      default:\n",
-                  register_scs, _hash_includes_len ? "len" : "0",
-                  _hash_includes_len ? "hval" : "len");
-
-          while (key_pos != Positions::LASTCHAR && key_pos >= _max_key_len)
-            if ((key_pos = iter.next ()) == PositionIterator::EOS)
-              break;
-
-          if (key_pos != PositionIterator::EOS && key_pos != Positions::LASTCHAR)
+          out.format ("  %sunsigned int hval = %s;\n\n"
+                      "  switch (%s)\n"
+                      "    {\n"
+                      "      default:\n",
+                      register_scs, _hash_includes_len ? "len" : "0",
+                      _hash_includes_len ? "hval" : "len");
+
+          while (key_pos >= _max_key_len)
+            key_pos = iter.next ();
+
+          if (key_pos >= 0)
             {
               int i = key_pos;
               do
                 {
-                  if (i > key_pos)
-                    printf ("%s", fallthrough_marker);
-                  for ( ; i > key_pos; i--)
-                    printf ("      case %d:\n", i);
-
-                  printf ("        hval += ");
-                  output_asso_values_ref (key_pos);
-                  printf (";\n");
+                  /* The run of SIMD positions is summed up after the
+                     switch.  */
+                  if (!(key_pos >= simd_first
+                        && key_pos < simd_first + simd_count))
+                    {
+                      if (i > key_pos)
+                        out.format ("%s", fallthrough_marker);
+                      for ( ; i > key_pos; i--)
+                        out.format ("      case %d:\n", i);
+
+                      out.put ("        hval += ");
+                      output_asso_values_ref (key_pos);
+                      out.put (";\n");
+                    }
 
                   key_pos = iter.next ();
                 }
-              while (key_pos != PositionIterator::EOS && key_pos != Positions::LASTCHAR);
+              while (key_pos >= 0);
 
               if (i >= _min_key_len)
-                printf ("%s", fallthrough_marker);
+                out.format ("%s", fallthrough_marker);
               for ( ; i >= _min_key_len; i--)
-                printf ("      case %d:\n", i);
+                out.format ("      case %d:\n", i);
             }
 
-          printf ("        break;\n"
-                  "    }\n"
-                  "  return hval");
-          if (key_pos == Positions::LASTCHAR)
+          out.put ("        break;\n"
+                   "    }\n");
+          if (simd_count > 0)
+            output_asso_values_simd (simd_first, simd_count);
+          out.put ("  return hval");
+          /* The positions counted from the end.  */
+          for (; key_pos != PositionIterator::EOS; key_pos = iter.next ())
             {
-              printf (" + ");
-              output_asso_values_ref (Positions::LASTCHAR);
+              out.put (" + ");
+              output_asso_values_term (key_pos);
             }
-          printf (";\n");
+          out.put (";\n");
         }
     }
-  printf ("}\n\n");
+  out.put ("}\n\n");
 }
 
 /* ------------------------------------------------------------------------- */
 
+/* Returns the indentation of the lookup tables: none for global tables,
+   otherwise the same as for function locals or class members.  */
+
+static const char *
+table_indent ()
+{
+  return option[GLOBAL] && !option[CPLUSPLUS17] ? "" : "  ";
+}
+
 /* Prints out a table of keyword lengths, for use with the
    comparison code in generated function 'in_word_set'.
    Only called if option[LENTABLE].  */
@@ -1004,14 +1407,45 @@ void
 Output::output_keylength_table () const
 {
   const int columns = 14;
-  const char * const indent = option[GLOBAL] ? "" : "  ";
+  const char * const indent = table_indent ();
+
+  if (_binary_lengthtable)
+    {
+      /* With --binary-tables=incbin, the length table is declared at file
+         scope.  */
+      if (option[EMBED])
+        {
+          char *file_name =
+            binary_table_file_name (option.get_lengthtable_name ());
+          out.format ("%sstatic %sunsigned char %s[] =\n"
+                      "%s  {\n"
+                      "#embed \"%s\"\n"
+                      "%s  };\n",
+                      indent, const_readonly_array,
+                      option.get_lengthtable_name (),
+                      indent, base_name (file_name), indent);
+          if (indent[0] == '\0')
+            out.put ("\n");
+          delete[] file_name;
+        }
+      else
+        {
+          out.format ("%sstatic %sunsigned char *%s%s = %s_%s;\n",
+                      indent, const_always, const_always,
+                      option.get_lengthtable_name (),
+                      external_table_prefix (), option.get_lengthtable_name ());
+          if (indent[0] == '\0')
+            out.put ("\n");
+        }
+      return;
+    }
 
-  printf ("%sstatic %s%s %s[] =\n"
-          "%s  {",
-          indent, const_readonly_array,
-          smallest_integral_type (_max_key_len),
-          option.get_lengthtable_name (),
-          indent);
+  out.format ("%sstatic %s%s%s %s[] =\n"
+              "%s  {",
+              indent, constexpr_scs, const_readonly_array,
+              smallest_integral_type (_max_key_len),
+              option.get_lengthtable_name (),
+              indent);
 
   /* Generate an array of lengths, similar to output_keyword_table.  */
   int index;
@@ -1035,35 +1469,35 @@ Output::output_keylength_table () const
           for ( ; index < keyword->_hash_value; index++)
             {
               if (index > 0)
-                printf (",");
+                out.put (",");
               if ((column++ % columns) == 0)
-                printf ("\n%s   ", indent);
-              printf ("%3d", 0);
+                output_table_newline (indent);
+              out.put_number (0, 3);
             }
         }
 
       if (index > 0)
-        printf (",");
+        out.put (",");
       if ((column++ % columns) == 0)
-        printf("\n%s   ", indent);
-      printf ("%3d", keyword->_allchars_length);
+        output_table_newline (indent);
+      out.put_number (keyword->_allchars_length, 3);
       index++;
 
       /* Deal with duplicates specially.  */
       if (keyword->_duplicate_link) // implies option[DUP]
         for (KeywordExt *links = keyword->_duplicate_link; links; links = links->_duplicate_link)
           {
-            printf (",");
+            out.put (",");
             if ((column++ % columns) == 0)
-              printf("\n%s   ", indent);
-            printf ("%3d", links->_allchars_length);
+              output_table_newline (indent);
+            out.put_number (links->_allchars_length, 3);
             index++;
           }
     }
 
-  printf ("\n%s  };\n", indent);
-  if (option[GLOBAL])
-    printf ("\n");
+  out.format ("\n%s  };\n", indent);
+  if (indent[0] == '\0')
+    out.put ("\n");
 }
 
 /* ------------------------------------------------------------------------- */
@@ -1078,9 +1512,38 @@ Output::output_string_pool () const
   int index;
   KeywordExt_List *temp;
 
-  printf ("%sstruct %s_t\n"
-          "%s  {\n",
-          indent, option.get_stringpool_name (), indent);
+  if (_pool_offsets != NULL)
+    {
+      /* With --binary-tables=incbin, the string pool is declared at file
+         scope.  */
+      if (option[EMBED])
+        {
+          char *file_name =
+            binary_table_file_name (option.get_stringpool_name ());
+          out.format ("%sstatic %sunsigned char %s_contents[] =\n"
+                      "%s  {\n"
+                      "#embed \"%s\"\n"
+                      "%s  };\n",
+                      indent, const_readonly_array,
+                      option.get_stringpool_name (),
+                      indent, base_name (file_name), indent);
+          delete[] file_name;
+          out.format ("%s#define %s ((%schar *) %s_contents)\n",
+                      indent, option.get_stringpool_name (), const_always,
+                      option.get_stringpool_name ());
+        }
+      else
+        out.format ("%s#define %s ((%schar *) %s_%s_contents)\n",
+                    indent, option.get_stringpool_name (), const_always,
+                    external_table_prefix (), option.get_stringpool_name ());
+      if (option[GLOBAL])
+        out.put ("\n");
+      return;
+    }
+
+  out.format ("%sstruct %s_t\n"
+              "%s  {\n",
+              indent, option.get_stringpool_name (), indent);
   for (temp = _head, index = 0; temp; temp = temp->rest())
     {
       KeywordExt *keyword = temp->first();
@@ -1094,10 +1557,14 @@ Output::output_string_pool () const
       if (!option[SWITCH] && !option[DUP])
         index = keyword->_hash_value;
 
-      printf ("%s    char %s_str%d[sizeof(",
-              indent, option.get_stringpool_name (), index);
+      out.put (indent);
+      out.put ("    char ");
+      out.put (option.get_stringpool_name ());
+      out.put ("_str");
+      out.put_number (index);
+      out.put ("[sizeof(");
       output_string (keyword->_allchars, keyword->_allchars_length);
-      printf (")];\n");
+      out.put (")];\n");
 
       /* Deal with duplicates specially.  */
       if (keyword->_duplicate_link) // implies option[DUP]
@@ -1107,21 +1574,25 @@ Output::output_string_pool () const
                            keyword->_allchars_length) == 0))
             {
               index++;
-              printf ("%s    char %s_str%d[sizeof(",
-                      indent, option.get_stringpool_name (), index);
+              out.put (indent);
+              out.put ("    char ");
+              out.put (option.get_stringpool_name ());
+              out.put ("_str");
+              out.put_number (index);
+              out.put ("[sizeof(");
               output_string (links->_allchars, links->_allchars_length);
-              printf (")];\n");
+              out.put (")];\n");
             }
 
       index++;
     }
-  printf ("%s  };\n",
-          indent);
+  out.format ("%s  };\n",
+              indent);
 
-  printf ("%sstatic %sstruct %s_t %s_contents =\n"
-          "%s  {\n",
-          indent, const_readonly_array, option.get_stringpool_name (),
-          option.get_stringpool_name (), indent);
+  out.format ("%sstatic %sstruct %s_t %s_contents =\n"
+              "%s  {\n",
+              indent, const_readonly_array, option.get_stringpool_name (),
+              option.get_stringpool_name (), indent);
   for (temp = _head, index = 0; temp; temp = temp->rest())
     {
       KeywordExt *keyword = temp->first();
@@ -1133,13 +1604,13 @@ Output::output_string_pool () const
         continue;
 
       if (index > 0)
-        printf (",\n");
+        out.put (",\n");
 
       if (!option[SWITCH] && !option[DUP])
         index = keyword->_hash_value;
 
-      printf ("%s    ",
-              indent);
+      out.put (indent);
+      out.put ("    ");
       output_string (keyword->_allchars, keyword->_allchars_length);
 
       /* Deal with duplicates specially.  */
@@ -1150,35 +1621,61 @@ Output::output_string_pool () const
                            keyword->_allchars_length) == 0))
             {
               index++;
-              printf (",\n");
-              printf ("%s    ",
-                      indent);
+              out.put (",\n");
+              out.put (indent);
+              out.put ("    ");
               output_string (links->_allchars, links->_allchars_length);
             }
 
       index++;
     }
   if (index > 0)
-    printf ("\n");
-  printf ("%s  };\n",
-          indent);
-  printf ("%s#define %s ((%schar *) &%s_contents)\n",
-          indent, option.get_stringpool_name (), const_always,
-          option.get_stringpool_name ());
+    out.put ("\n");
+  out.format ("%s  };\n",
+              indent);
+  out.format ("%s#define %s ((%schar *) &%s_contents)\n",
+              indent, option.get_stringpool_name (), const_always,
+              option.get_stringpool_name ());
   if (option[GLOBAL])
-    printf ("\n");
+    out.put ("\n");
 }
 
 /* ------------------------------------------------------------------------- */
 
+/* Outputs the name of the given table in the given shard (counted from 1).
+   The tables of the shards have external linkage.  */
+
+static void
+output_shard_table_name (const char *name, int shard)
+{
+  out.put (external_table_prefix ());
+  out.put ('_');
+  out.put (name);
+  out.put ('_');
+  out.put_number (shard);
+}
+
+/* Outputs the name of the string pool, or of its part in the given shard
+   (counted from 1).  */
+
+static void
+output_pool_name (int shard)
+{
+  if (shard > 0)
+    output_shard_table_name (option.get_stringpool_name (), shard);
+  else
+    out.put (option.get_stringpool_name ());
+}
+
 static void
-output_keyword_entry (KeywordExt *temp, int stringpool_index, const char *indent, bool is_duplicate)
+output_keyword_entry (KeywordExt *temp, int stringpool_index, const char *indent, bool is_duplicate, int shard)
 {
   if (option[TYPE])
     output_line_directive (temp->_lineno);
-  printf ("%s    ", indent);
+  out.put (indent);
+  out.put ("    ");
   if (option[TYPE])
-    printf ("{");
+    out.put ("{");
   if (option[SHAREDLIB])
     /* How to determine a certain offset in stringpool at compile time?
        - The standard way would be to use the 'offsetof' macro.  But it is only
@@ -1192,26 +1689,40 @@ output_keyword_entry (KeywordExt *temp, int stringpool_index, const char *indent
          in the prerequisite header <string.h>.
        - The types 'long' and 'unsigned long' do work as well, but on 64-bit
          native Windows platforms, they don't have the same size as pointers
-         and therefore generate warnings.  */
-    printf ("(int)(size_t)&((struct %s_t *)0)->%s_str%d",
-            option.get_stringpool_name (), option.get_stringpool_name (),
-            stringpool_index);
+         and therefore generate warnings.
+       With --binary-tables, the offset is known to gperf.  */
+    {
+      if (option[INCBIN] || option[EMBED])
+        out.put_number (stringpool_index);
+      else
+        {
+          out.put ("(int)(size_t)&((struct ");
+          output_pool_name (shard);
+          out.put ("_t *)0)->");
+          output_pool_name (shard);
+          out.put ("_str");
+          out.put_number (stringpool_index);
+        }
+    }
   else
     output_string (temp->_allchars, temp->_allchars_length);
   if (option[TYPE])
     {
-      if (strlen (temp->_rest) > 0)
-        printf (",%s", temp->_rest);
-      printf ("}");
+      if (temp->_rest[0] != '\0')
+        {
+          out.put (',');
+          out.put (temp->_rest);
+        }
+      out.put ("}");
     }
   if (option[DEBUG])
     {
-      printf (" /* ");
+      out.put (" /* ");
       if (is_duplicate)
-        printf ("hash value duplicate, ");
+        out.put ("hash value duplicate, ");
       else
-        printf ("hash value = %d, ", temp->_hash_value);
-      printf ("index = %d */", temp->_final_index);
+        out.format ("hash value = %d, ", temp->_hash_value);
+      out.format ("index = %d */", temp->_final_index);
     }
 }
 
@@ -1236,27 +1747,31 @@ output_keyword_blank_entries (int count, const char *indent)
       if ((column % columns) == 0)
         {
           if (i > 0)
-            printf (",\n");
-          printf ("%s    ", indent);
+            out.put (",\n");
+          out.put (indent);
+          out.put ("    ");
         }
       else
         {
           if (i > 0)
-            printf (", ");
+            out.put (", ");
         }
       if (option[TYPE])
-        printf ("{");
+        out.put ("{");
       if (option[SHAREDLIB])
-        printf ("-1");
+        out.put ("-1");
       else
         {
           if (option[NULLSTRINGS])
-            printf ("(char*)0");
+            out.put ("(char*)0");
           else
-            printf ("\"\"");
+            out.put ("\"\"");
         }
       if (option[TYPE])
-        printf ("%s}", option.get_initializer_suffix());
+        {
+          out.put (option.get_initializer_suffix());
+          out.put ('}');
+        }
       column++;
     }
 }
@@ -1266,17 +1781,17 @@ output_keyword_blank_entries (int count, const char *indent)
 void
 Output::output_keyword_table () const
 {
-  const char *indent  = option[GLOBAL] ? "" : "  ";
+  const char *indent  = table_indent ();
   int index;
   KeywordExt_List *temp;
 
-  printf ("%sstatic ",
-          indent);
+  out.format ("%sstatic %s",
+              indent, constexpr_scs);
   output_const_type (const_readonly_array, _wordlist_eltype);
-  printf ("%s[] =\n"
-          "%s  {\n",
-          option.get_wordlist_name (),
-          indent);
+  out.format ("%s[] =\n"
+              "%s  {\n",
+              option.get_wordlist_name (),
+              indent);
 
   /* Generate an array of reserved words at appropriate locations.  */
 
@@ -1291,41 +1806,46 @@ Output::output_keyword_table () const
         continue;
 
       if (index > 0)
-        printf (",\n");
+        out.put (",\n");
 
       if (index < keyword->_hash_value && !option[SWITCH] && !option[DUP])
         {
           /* Some blank entries.  */
           output_keyword_blank_entries (keyword->_hash_value - index, indent);
-          printf (",\n");
+          out.put (",\n");
           index = keyword->_hash_value;
         }
 
       keyword->_final_index = index;
 
-      output_keyword_entry (keyword, index, indent, false);
+      output_keyword_entry (keyword,
+                            _pool_offsets ? _pool_offsets[index] : index,
+                            indent, false, 0);
 
       /* Deal with duplicates specially.  */
       if (keyword->_duplicate_link) // implies option[DUP]
         for (KeywordExt *links = keyword->_duplicate_link; links; links = links->_duplicate_link)
           {
             links->_final_index = ++index;
-            printf (",\n");
+            out.put (",\n");
             int stringpool_index =
               (links->_allchars_length == keyword->_allchars_length
                && memcmp (links->_allchars, keyword->_allchars,
                           keyword->_allchars_length) == 0
                ? keyword->_final_index
                : links->_final_index);
-            output_keyword_entry (links, stringpool_index, indent, true);
+            if (_pool_offsets)
+              stringpool_index = _pool_offsets[stringpool_index];
+            output_keyword_entry (links, stringpool_index, indent, true, 0);
           }
 
       index++;
     }
   if (index > 0)
-    printf ("\n");
+    out.put ("\n");
+  stats._keyword_table_size = index;
 
-  printf ("%s  };\n\n", indent);
+  out.format ("%s  };\n\n", indent);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -1436,11 +1956,12 @@ Output::output_lookup_array () const
             max = val;
         }
 
-      const char *indent = option[GLOBAL] ? "" : "  ";
-      printf ("%sstatic %s%s lookup[] =\n"
-              "%s  {",
-              indent, const_readonly_array, smallest_integral_type (min, max),
-              indent);
+      const char *indent = table_indent ();
+      out.format ("%sstatic %s%s%s lookup[] =\n"
+                  "%s  {",
+                  indent, constexpr_scs, const_readonly_array,
+                  smallest_integral_type (min, max),
+                  indent);
 
       int field_width;
       /* Calculate maximum number of digits required for MIN..MAX.  */
@@ -1466,12 +1987,12 @@ Output::output_lookup_array () const
       for (int i = 0; i < lookup_array_size; i++)
         {
           if (i > 0)
-            printf (",");
+            out.put (",");
           if ((column++ % columns) == 0)
-            printf("\n%s   ", indent);
-          printf ("%*d", field_width, lookup_array[i]);
+            output_table_newline (indent);
+          out.put_number (lookup_array[i], field_width);
         }
-      printf ("\n%s  };\n\n", indent);
+      out.format ("\n%s  };\n\n", indent);
 
       delete[] duplicates;
       delete[] lookup_array;
@@ -1490,6 +2011,10 @@ Output::output_lookup_pools () const
       if (option[TYPE] || (option[DUP] && _total_duplicates > 0))
         output_string_pool ();
     }
+  else if (_shard_size > 0)
+    {
+      output_pool_shard_declarations ();
+    }
   else
     {
       output_string_pool ();
@@ -1512,83 +2037,792 @@ Output::output_lookup_tables () const
   else
     {
       /* Use the lookup table, in place of switch.  */
-      if (option[LENTABLE])
-        output_keylength_table ();
-      output_keyword_table ();
+      if (_shard_size > 0)
+        output_table_shard_declarations ();
+      else
+        {
+          if (option[LENTABLE])
+            output_keylength_table ();
+          output_keyword_table ();
+        }
       output_lookup_array ();
     }
+
+  if (_prefilter != NULL)
+    output_prefilter_table ();
 }
 
 /* ------------------------------------------------------------------------- */
 
-/* Output a single switch case (including duplicates).  Advance list.  */
-
-static KeywordExt_List *
-output_switch_case (KeywordExt_List *list, int indent, int *jumps_away)
-{
-  if (option[DEBUG])
-    printf ("%*s/* hash value = %4d, keyword = \"%.*s\" */\n",
-            indent, "", list->first()->_hash_value, list->first()->_allchars_length, list->first()->_allchars);
+/* The lookup prefilter is a Bloom filter over a fingerprint of the length
+   and the first and last byte of a string.  The fingerprint and the two
+   probe positions are computed modulo 2^16, so that the generated code
+   computes the same values on every platform, whatever the width of an
+   'unsigned int'.  */
 
-  if (option[DUP] && list->first()->_duplicate_link)
-    {
-      if (option[LENTABLE])
-        printf ("%*slengthptr = &%s[%d];\n",
-                indent, "", option.get_lengthtable_name (), list->first()->_final_index);
-      printf ("%*swordptr = &%s[%d];\n",
-              indent, "", option.get_wordlist_name (), list->first()->_final_index);
+/* Multipliers of the fingerprint and the two probes.  */
+static const unsigned int PREFILTER_LEN_FACTOR = 155;
+static const unsigned int PREFILTER_PROBE1_FACTOR = 40503;
+static const unsigned int PREFILTER_PROBE2_FACTOR = 31325;
 
-      int count = 0;
-      for (KeywordExt *links = list->first(); links; links = links->_duplicate_link)
-        count++;
+/* Returns the fingerprint of a string with the given length, first and last
+   byte.  */
 
-      printf ("%*swordendptr = wordptr + %d;\n"
-              "%*sgoto multicompare;\n",
-              indent, "", count,
-              indent, "");
-      *jumps_away = 1;
-    }
-  else
+static unsigned int
+prefilter_fingerprint (unsigned int len, unsigned int first, unsigned int last)
+{
+  if (option[UPPERLOWER])
     {
-      if (option[LENTABLE])
-        {
-          printf ("%*sif (len == %d)\n"
-                  "%*s  {\n",
-                  indent, "", list->first()->_allchars_length,
-                  indent, "");
-          indent += 4;
-        }
-      printf ("%*sresword = ",
-              indent, "");
-      if (option[TYPE])
-        printf ("&%s[%d]", option.get_wordlist_name (), list->first()->_final_index);
-      else
-        output_string (list->first()->_allchars, list->first()->_allchars_length);
-      printf (";\n");
-      printf ("%*sgoto compare;\n",
-              indent, "");
-      if (option[LENTABLE])
-        {
-          indent -= 4;
-          printf ("%*s  }\n",
-                  indent, "");
-        }
-      else
-        *jumps_away = 1;
+      /* Map each ASCII letter and its other case to the same value.  */
+      first |= 0x20;
+      last |= 0x20;
     }
-
-  return list->rest();
+  return (first + (last << 8) + len * PREFILTER_LEN_FACTOR) & 0xffff;
 }
 
-/* Output a total of size cases, grouped into num_switches switch statements,
-   where 0 < num_switches <= size.  */
+/* Returns the bit position of a probe, for a filter of 2^(16 - shift)
+   bits.  */
 
-static void
-output_switches (KeywordExt_List *list, int num_switches, int size, int min_hash_value, int max_hash_value, int indent)
+static unsigned int
+prefilter_probe (unsigned int fingerprint, unsigned int factor, int shift)
 {
-  if (option[DEBUG])
-    printf ("%*s/* know %d <= key <= %d, contains %d cases */\n",
-            indent, "", min_hash_value, max_hash_value, size);
+  return ((fingerprint * factor) & 0xffff) >> shift;
+}
+
+/* Returns the shift of the probes of a filter of the given number of
+   bits.  */
+
+static int
+prefilter_shift (unsigned int size)
+{
+  int shift = 16;
+  while ((1U << (16 - shift)) < size)
+    shift--;
+  return shift;
+}
+
+/* Fills the Bloom filter that the lookup function checks before the hash
+   function.  */
+
+void
+Output::compute_prefilter ()
+{
+  /* The size is a power of 2, between 64 bits and 2^16 bits.  */
+  unsigned int wanted =
+    static_cast<unsigned int>(option.get_prefilter_bits ()) * _total_keys;
+  _prefilter_size = 64;
+  while (_prefilter_size < wanted && _prefilter_size < 0x10000)
+    _prefilter_size <<= 1;
+  int shift = prefilter_shift (_prefilter_size);
+
+  _prefilter = new unsigned char[_prefilter_size / 8];
+  memset (_prefilter, 0, _prefilter_size / 8);
+
+  unsigned int bits_set = 0;
+  for (KeywordExt_List *temp = _head; temp; temp = temp->rest())
+    for (KeywordExt *keyword = temp->first(); keyword; keyword = keyword->_duplicate_link)
+      {
+        unsigned int len = keyword->_allchars_length;
+        unsigned int f =
+          prefilter_fingerprint (len,
+                                 static_cast<unsigned char>(keyword->_allchars[0]),
+                                 static_cast<unsigned char>(keyword->_allchars[len - 1]));
+        unsigned int probes[2];
+        probes[0] = prefilter_probe (f, PREFILTER_PROBE1_FACTOR, shift);
+        probes[1] = prefilter_probe (f, PREFILTER_PROBE2_FACTOR, shift);
+        for (int i = 0; i < 2; i++)
+          {
+            unsigned char mask = 1 << (probes[i] & 7);
+            if (!(_prefilter[probes[i] >> 3] & mask))
+              {
+                _prefilter[probes[i] >> 3] |= mask;
+                bits_set++;
+              }
+          }
+      }
+
+  if (option[DEBUG])
+    {
+      double fill = static_cast<double>(bits_set) / _prefilter_size;
+      fprintf (stderr, "\nPrefilter: %u bits, %u set, "
+                       "estimated false positive rate %.2f%%\n",
+               _prefilter_size, bits_set, 100.0 * fill * fill);
+    }
+}
+
+/* Prints out the Bloom filter of the lookup function.  */
+
+void
+Output::output_prefilter_table () const
+{
+  const int columns = 12;
+  const char * const indent = table_indent ();
+
+  out.format ("%sstatic %s%sunsigned char prefilter[] =\n"
+              "%s  {",
+              indent, constexpr_scs, const_readonly_array, indent);
+  for (unsigned int i = 0; i < _prefilter_size / 8; i++)
+    {
+      if (i > 0)
+        out.put (",");
+      if ((i % columns) == 0)
+        output_table_newline (indent);
+      out.format ("0x%02x", _prefilter[i]);
+    }
+  out.format ("\n%s  };\n\n", indent);
+}
+
+/* Generates C code that returns from the lookup function if the Bloom
+   filter rejects the string.  */
+
+void
+Output::output_prefilter_check () const
+{
+  const char *byte_cast_begin;
+  const char *int_cast_begin;
+  const char *cast_end;
+  if (option[CPLUSPLUS])
+    {
+      byte_cast_begin = "static_cast<unsigned char>(";
+      int_cast_begin = "static_cast<unsigned int>(";
+      cast_end = ")";
+    }
+  else
+    {
+      byte_cast_begin = "(unsigned char)";
+      int_cast_begin = "(unsigned int)";
+      cast_end = "";
+    }
+  int shift = prefilter_shift (_prefilter_size);
+
+  out.format ("      {\n"
+              "        /* Reject most strings that are not keywords, without hashing them.  */\n"
+              "        %sunsigned int f =\n",
+              register_scs);
+  if (option[UPPERLOWER])
+    out.format ("          ((%sstr[0]%s | 0x20) + (%sstr[len - 1]%s | 0x20) * 256U\n",
+                byte_cast_begin, cast_end, byte_cast_begin, cast_end);
+  else
+    out.format ("          (%sstr[0]%s + %sstr[len - 1]%s * 256U\n",
+                byte_cast_begin, cast_end, byte_cast_begin, cast_end);
+  out.format ("           + %slen%s * %uU) & 0xffff;\n"
+              "        %sunsigned int f1 = ((f * %uU) & 0xffff) >> %d;\n"
+              "        %sunsigned int f2 = ((f * %uU) & 0xffff) >> %d;\n"
+              "\n"
+              "        if (!((prefilter[f1 >> 3] >> (f1 & 7))\n"
+              "              & (prefilter[f2 >> 3] >> (f2 & 7)) & 1))\n"
+              "          return 0;\n"
+              "      }\n",
+              int_cast_begin, cast_end, PREFILTER_LEN_FACTOR,
+              register_scs, PREFILTER_PROBE1_FACTOR, shift,
+              register_scs, PREFILTER_PROBE2_FACTOR, shift);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Assigns the indices in the keyword table, like output_keyword_table does,
+   and divides the keyword table into option.get_shards () shards of
+   _shard_size elements each.  */
+
+void
+Output::compute_shards ()
+{
+  int index;
+  KeywordExt_List *temp;
+
+  /* Determine the size of the keyword table.  */
+  for (temp = _head, index = 0; temp; temp = temp->rest())
+    {
+      KeywordExt *keyword = temp->first();
+
+      if (index < keyword->_hash_value && !option[DUP])
+        index = keyword->_hash_value;
+      for (; keyword; keyword = keyword->_duplicate_link)
+        index++;
+    }
+  _table_size = index;
+  stats._keyword_table_size = _table_size;
+  _table = new KeywordExt *[_table_size];
+  _table_duplicates = new bool[_table_size];
+
+  /* Fill it.  Blank entries are NULL.  */
+  for (temp = _head, index = 0; temp; temp = temp->rest())
+    {
+      KeywordExt *keyword = temp->first();
+
+      for (; index < keyword->_hash_value && !option[DUP]; index++)
+        {
+          _table[index] = NULL;
+          _table_duplicates[index] = false;
+        }
+      for (bool is_duplicate = false;
+           keyword;
+           keyword = keyword->_duplicate_link, is_duplicate = true)
+        {
+          keyword->_final_index = index;
+          _table[index] = keyword;
+          _table_duplicates[index] = is_duplicate;
+          index++;
+        }
+    }
+
+  int shards = option.get_shards ();
+  _shard_size = (_table_size + shards - 1) / shards;
+  if (_shard_size == 0)
+    _shard_size = 1;
+}
+
+/* Returns the range of keyword table indices that the given shard (counted
+   from 1) holds.  A shard extends beyond _shard_size elements when needed
+   to hold the whole duplicate set that starts in it, because the lookup
+   function walks a duplicate set with a pointer.  */
+
+void
+Output::shard_range (int shard, int& start, int& end) const
+{
+  start = (shard - 1) * _shard_size;
+  end = start + _shard_size;
+  if (start > _table_size)
+    start = _table_size;
+  if (end > _table_size)
+    end = _table_size;
+  while (end < _table_size && _table_duplicates[end])
+    end++;
+}
+
+/* Prints out the declarations of the string pool shards, and the table
+   that points to them, for the lookup function.  The pool shards must be
+   declared at file scope, because their struct types are only known by
+   name.  */
+
+void
+Output::output_pool_shard_declarations () const
+{
+  const char *pool = option.get_stringpool_name ();
+  int shards = option.get_shards ();
+
+  for (int k = 1; k <= shards; k++)
+    {
+      out.format ("extern %sstruct ", const_readonly_array);
+      output_pool_name (k);
+      out.put ("_t ");
+      output_pool_name (k);
+      out.put ("_contents;\n");
+    }
+  out.format ("static %schar *%s%s_shards[] =\n"
+              "  {\n",
+              const_always, const_readonly_array, pool);
+  for (int k = 1; k <= shards; k++)
+    {
+      out.format ("    (%schar *) &", const_always);
+      output_pool_name (k);
+      out.format ("_contents%s\n", k < shards ? "," : "");
+    }
+  out.put ("  };\n"
+           "\n");
+}
+
+/* Prints out the declarations of the keyword table shards and of the length
+   table shards, and the tables that point to them, for the lookup
+   function.  */
+
+void
+Output::output_table_shard_declarations () const
+{
+  const char * const indent = table_indent ();
+  int shards = option.get_shards ();
+
+  if (option[LENTABLE])
+    {
+      const char *name = option.get_lengthtable_name ();
+      const char *type = smallest_integral_type (_max_key_len);
+
+      for (int k = 1; k <= shards; k++)
+        {
+          out.format ("%sextern %s%s ", indent, const_readonly_array, type);
+          output_shard_table_name (name, k);
+          out.put ("[];\n");
+        }
+      out.format ("%sstatic %s%s *%s%s_shards[] =\n"
+                  "%s  {\n",
+                  indent, const_readonly_array, type, const_readonly_array,
+                  name, indent);
+      for (int k = 1; k <= shards; k++)
+        {
+          out.format ("%s    ", indent);
+          output_shard_table_name (name, k);
+          out.put (k < shards ? ",\n" : "\n");
+        }
+      out.format ("%s  };\n", indent);
+    }
+
+  const char *name = option.get_wordlist_name ();
+
+  for (int k = 1; k <= shards; k++)
+    {
+      out.format ("%sextern ", indent);
+      output_const_type (const_readonly_array, _wordlist_eltype);
+      output_shard_table_name (name, k);
+      out.put ("[];\n");
+    }
+  out.format ("%sstatic ", indent);
+  output_const_type (const_readonly_array, _wordlist_eltype);
+  out.format ("*%s%s_shards[] =\n"
+              "%s  {\n",
+              const_readonly_array, name, indent);
+  for (int k = 1; k <= shards; k++)
+    {
+      out.format ("%s    ", indent);
+      output_shard_table_name (name, k);
+      out.put (k < shards ? ",\n" : "\n");
+    }
+  out.format ("%s  };\n\n", indent);
+}
+
+/* Prints out the part of the length table that the given shard holds.  */
+
+void
+Output::output_keylength_table_shard (int shard) const
+{
+  const int columns = 14;
+  const char *name = option.get_lengthtable_name ();
+  const char *type = smallest_integral_type (_max_key_len);
+  int start;
+  int end;
+
+  shard_range (shard, start, end);
+
+  out.format ("extern %s%s ", const_readonly_array, type);
+  output_shard_table_name (name, shard);
+  out.format ("[];\n"
+              "%s%s ",
+              const_readonly_array, type);
+  output_shard_table_name (name, shard);
+  out.put ("[] =\n"
+           "  {");
+  /* An array must not be empty.  */
+  if (start == end)
+    {
+      output_table_newline ("");
+      out.put_number (0, 3);
+    }
+  for (int index = start; index < end; index++)
+    {
+      if (index > start)
+        out.put (",");
+      if (((index - start) % columns) == 0)
+        output_table_newline ("");
+      out.put_number (_table[index] ? _table[index]->_allchars_length : 0, 3);
+    }
+  out.put ("\n"
+           "  };\n"
+           "\n");
+}
+
+/* Prints out the part of the string pool that the given shard holds.  It
+   contains the strings of the keyword table elements in the shard.  */
+
+void
+Output::output_string_pool_shard (int shard) const
+{
+  int start;
+  int end;
+  bool empty = true;
+
+  shard_range (shard, start, end);
+
+  out.put ("struct ");
+  output_pool_name (shard);
+  out.put ("_t\n"
+           "  {\n");
+  for (int index = start; index < end; index++)
+    if (_table[index])
+      {
+        out.put ("    char ");
+        output_pool_name (shard);
+        out.put ("_str");
+        out.put_number (index);
+        out.put ("[sizeof(");
+        output_string (_table[index]->_allchars,
+                       _table[index]->_allchars_length);
+        out.put (")];\n");
+        empty = false;
+      }
+  /* A struct must not be empty.  */
+  if (empty)
+    {
+      out.put ("    char ");
+      output_pool_name (shard);
+      out.put ("_unused;\n");
+    }
+  out.put ("  };\n");
+
+  out.format ("extern %sstruct ", const_readonly_array);
+  output_pool_name (shard);
+  out.put ("_t ");
+  output_pool_name (shard);
+  out.put ("_contents;\n");
+  out.format ("%sstruct ", const_readonly_array);
+  output_pool_name (shard);
+  out.put ("_t ");
+  output_pool_name (shard);
+  out.put ("_contents =\n"
+           "  {\n");
+  bool first = true;
+  for (int index = start; index < end; index++)
+    if (_table[index])
+      {
+        if (!first)
+          out.put (",\n");
+        out.put ("    ");
+        output_string (_table[index]->_allchars,
+                       _table[index]->_allchars_length);
+        first = false;
+      }
+  if (empty)
+    out.put ("    0");
+  out.put ("\n"
+           "  };\n"
+           "\n");
+}
+
+/* Prints out the part of the keyword table that the given shard holds.  */
+
+void
+Output::output_keyword_table_shard (int shard) const
+{
+  const char *name = option.get_wordlist_name ();
+  int start;
+  int end;
+
+  shard_range (shard, start, end);
+
+  out.put ("extern ");
+  output_const_type (const_readonly_array, _wordlist_eltype);
+  output_shard_table_name (name, shard);
+  out.put ("[];\n");
+  output_const_type (const_readonly_array, _wordlist_eltype);
+  output_shard_table_name (name, shard);
+  out.put ("[] =\n"
+           "  {\n");
+  /* An array must not be empty.  */
+  if (start == end)
+    output_keyword_blank_entries (1, "");
+  for (int index = start; index < end; )
+    {
+      if (index > start)
+        out.put (",\n");
+      if (_table[index] == NULL)
+        {
+          /* Some blank entries.  */
+          int count = 0;
+          for (; index < end && _table[index] == NULL; index++)
+            count++;
+          output_keyword_blank_entries (count, "");
+        }
+      else
+        {
+          output_keyword_entry (_table[index], index, "",
+                                _table_duplicates[index], shard);
+          index++;
+        }
+    }
+  out.put ("\n"
+           "  };\n");
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Writes SIZE bytes at DATA to the binary file FILE_NAME.  */
+
+static void
+write_binary_file (const char *file_name, const unsigned char *data,
+                   size_t size)
+{
+  FILE *stream = fopen (file_name, "wb");
+  if (stream == NULL)
+    {
+      fprintf (stderr, "Cannot open output file '%s'\n", file_name);
+      exit (1);
+    }
+  fwrite (data, 1, size, stream);
+  if (ferror (stream) | fclose (stream))
+    {
+      fprintf (stderr, "error while writing output file '%s'\n", file_name);
+      exit (1);
+    }
+}
+
+/* Writes the string pool and the length table to binary files, with the
+   same contents as output_string_pool and output_keylength_table would
+   produce, and with --binary-tables=incbin, the assembler file that pulls
+   them in.  The length table is written only if its elements are bytes;
+   otherwise it stays in the C code, because the byte order of the target
+   is unknown.  */
+
+void
+Output::compute_binary_tables ()
+{
+  bool lengthtable_needed =
+    option[LENTABLE]
+    && (!option[SWITCH] || (option[DUP] && _total_duplicates > 0));
+  bool pool_needed =
+    option[SHAREDLIB]
+    && (!option[SWITCH] || option[TYPE]
+        || (option[DUP] && _total_duplicates > 0));
+  int max_index = _max_hash_value + _total_keys + 1;
+  int index;
+  KeywordExt_List *temp;
+
+  if (lengthtable_needed && _max_key_len <= UCHAR_MAX)
+    {
+      unsigned char *lengths = new unsigned char[max_index];
+
+      for (temp = _head, index = 0; temp; temp = temp->rest())
+        {
+          KeywordExt *keyword = temp->first();
+
+          if (option[SWITCH] && !option[TYPE] && !keyword->_duplicate_link)
+            continue;
+
+          if (!option[SWITCH] && !option[DUP])
+            for ( ; index < keyword->_hash_value; index++)
+              lengths[index] = 0;
+
+          for (; keyword; keyword = keyword->_duplicate_link)
+            lengths[index++] = keyword->_allchars_length;
+        }
+
+      char *file_name = binary_table_file_name (option.get_lengthtable_name ());
+      write_binary_file (file_name, lengths, index);
+      delete[] file_name;
+      delete[] lengths;
+      _binary_lengthtable = true;
+    }
+
+  if (pool_needed)
+    {
+      size_t pool_size = 0;
+      for (temp = _head; temp; temp = temp->rest())
+        for (KeywordExt *keyword = temp->first(); keyword;
+             keyword = keyword->_duplicate_link)
+          pool_size += keyword->_allchars_length + 1;
+      unsigned char *pool = new unsigned char[pool_size];
+      size_t offset = 0;
+
+      /* The pool holds the same strings as the struct in
+         output_string_pool.  */
+      _pool_offsets = new int[max_index];
+      for (temp = _head, index = 0; temp; temp = temp->rest())
+        {
+          KeywordExt *keyword = temp->first();
+
+          if (option[SWITCH] && !option[TYPE] && !keyword->_duplicate_link)
+            continue;
+
+          if (!option[SWITCH] && !option[DUP])
+            index = keyword->_hash_value;
+
+          _pool_offsets[index] = offset;
+          memcpy (pool + offset, keyword->_allchars, keyword->_allchars_length);
+          offset += keyword->_allchars_length;
+          pool[offset++] = '\0';
+
+          for (KeywordExt *links = keyword->_duplicate_link; links; links = links->_duplicate_link)
+            if (!(links->_allchars_length == keyword->_allchars_length
+                  && memcmp (links->_allchars, keyword->_allchars,
+                             keyword->_allchars_length) == 0))
+              {
+                index++;
+                _pool_offsets[index] = offset;
+                memcpy (pool + offset, links->_allchars, links->_allchars_length);
+                offset += links->_allchars_length;
+                pool[offset++] = '\0';
+              }
+
+          index++;
+        }
+
+      char *file_name = binary_table_file_name (option.get_stringpool_name ());
+      write_binary_file (file_name, pool, offset);
+      delete[] file_name;
+      delete[] pool;
+    }
+
+  if (option[INCBIN])
+    {
+      char *file_name = derived_file_name ("-tables", ".S");
+      FILE *stream = fopen (file_name, "w");
+      if (stream == NULL)
+        {
+          fprintf (stderr, "Cannot open output file '%s'\n", file_name);
+          exit (1);
+        }
+      out.set_stream (stream);
+
+      out.format ("/* Tables for %s, produced by gperf version %s */\n",
+                  option.get_output_file_name (), version_string);
+      option.print_options (out);
+      out.put ("\n"
+               "#ifdef __USER_LABEL_PREFIX__\n"
+               "# define GPERF_CONCAT1(a, b) a ## b\n"
+               "# define GPERF_CONCAT(a, b) GPERF_CONCAT1 (a, b)\n"
+               "# define GPERF_SYMBOL(name) GPERF_CONCAT (__USER_LABEL_PREFIX__, name)\n"
+               "#else\n"
+               "# define GPERF_SYMBOL(name) name\n"
+               "#endif\n"
+               "\n"
+               "#if defined __APPLE__\n"
+               "        .const\n"
+               "#elif defined _WIN32 || defined __CYGWIN__\n"
+               "        .section .rdata,\"dr\"\n"
+               "#else\n"
+               "        .section .rodata\n"
+               "#endif\n");
+      if (_binary_lengthtable)
+        {
+          char *table_file_name =
+            binary_table_file_name (option.get_lengthtable_name ());
+          out.format ("\n"
+                      "        .globl GPERF_SYMBOL (%s_%s)\n"
+                      "GPERF_SYMBOL (%s_%s):\n"
+                      "        .incbin \"%s\"\n",
+                      external_table_prefix (), option.get_lengthtable_name (),
+                      external_table_prefix (), option.get_lengthtable_name (),
+                      base_name (table_file_name));
+          delete[] table_file_name;
+        }
+      if (_pool_offsets != NULL)
+        {
+          char *table_file_name =
+            binary_table_file_name (option.get_stringpool_name ());
+          out.format ("\n"
+                      "        .globl GPERF_SYMBOL (%s_%s_contents)\n"
+                      "GPERF_SYMBOL (%s_%s_contents):\n"
+                      "        .incbin \"%s\"\n",
+                      external_table_prefix (), option.get_stringpool_name (),
+                      external_table_prefix (), option.get_stringpool_name (),
+                      base_name (table_file_name));
+          delete[] table_file_name;
+        }
+      /* Don't make the stack executable.  */
+      out.put ("\n"
+               "#if defined __ELF__\n"
+               "        .section .note.GNU-stack,\"\",%progbits\n"
+               "#endif\n");
+
+      out.set_stream (stdout);
+      if (ferror (stream) | fclose (stream))
+        {
+          fprintf (stderr, "error while writing output file '%s'\n",
+                   file_name);
+          exit (1);
+        }
+      delete[] file_name;
+    }
+}
+
+/* Prints out the declarations of the tables that the assembler file of
+   --binary-tables=incbin defines.  */
+
+void
+Output::output_binary_table_declarations () const
+{
+  if (!(_binary_lengthtable || _pool_offsets != NULL))
+    return;
+
+  const char *linkage = "extern ";
+  if (option[CPLUSPLUS])
+    linkage = "extern \"C\" ";
+  else
+    out.put ("#ifdef __cplusplus\n"
+             "extern \"C\" {\n"
+             "#endif\n");
+  if (_binary_lengthtable)
+    out.format ("%s%sunsigned char %s_%s[];\n",
+                linkage, const_always,
+                external_table_prefix (), option.get_lengthtable_name ());
+  if (_pool_offsets != NULL)
+    out.format ("%s%sunsigned char %s_%s_contents[];\n",
+                linkage, const_always,
+                external_table_prefix (), option.get_stringpool_name ());
+  if (!option[CPLUSPLUS])
+    out.put ("#ifdef __cplusplus\n"
+             "}\n"
+             "#endif\n");
+  out.put ("\n");
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Output a single switch case (including duplicates).  Advance list.  */
+
+static KeywordExt_List *
+output_switch_case (KeywordExt_List *list, int indent, int *jumps_away)
+{
+  if (option[DEBUG])
+    out.format ("%*s/* hash value = %4d, keyword = \"%.*s\" */\n",
+                indent, "", list->first()->_hash_value, list->first()->_allchars_length, list->first()->_allchars);
+
+  if (option[DUP] && list->first()->_duplicate_link)
+    {
+      if (option[LENTABLE])
+        out.format ("%*slengthptr = &%s[%d];\n",
+                    indent, "", option.get_lengthtable_name (), list->first()->_final_index);
+      out.format ("%*swordptr = &%s[%d];\n",
+                  indent, "", option.get_wordlist_name (), list->first()->_final_index);
+
+      int count = 0;
+      for (KeywordExt *links = list->first(); links; links = links->_duplicate_link)
+        count++;
+
+      out.format ("%*swordendptr = wordptr + %d;\n"
+                  "%*sgoto multicompare;\n",
+                  indent, "", count,
+                  indent, "");
+      *jumps_away = 1;
+    }
+  else
+    {
+      if (option[LENTABLE])
+        {
+          out.format ("%*sif (len == %d)\n"
+                      "%*s  {\n",
+                      indent, "", list->first()->_allchars_length,
+                      indent, "");
+          indent += 4;
+        }
+      out.format ("%*sresword = ",
+                  indent, "");
+      if (option[TYPE])
+        out.format ("&%s[%d]", option.get_wordlist_name (), list->first()->_final_index);
+      else
+        output_string (list->first()->_allchars, list->first()->_allchars_length);
+      out.put (";\n");
+      out.format ("%*sgoto compare;\n",
+                  indent, "");
+      if (option[LENTABLE])
+        {
+          indent -= 4;
+          out.format ("%*s  }\n",
+                      indent, "");
+        }
+      else
+        *jumps_away = 1;
+    }
+
+  return list->rest();
+}
+
+/* Output a total of size cases, grouped into num_switches switch statements,
+   where 0 < num_switches <= size.  */
+
+static void
+output_switches (KeywordExt_List *list, int num_switches, int size, int min_hash_value, int max_hash_value, int indent)
+{
+  if (option[DEBUG])
+    out.format ("%*s/* know %d <= key <= %d, contains %d cases */\n",
+                indent, "", min_hash_value, max_hash_value, size);
 
   if (num_switches > 1)
     {
@@ -1601,22 +2835,22 @@ output_switches (KeywordExt_List *list, int num_switches, int size, int min_hash
       for (int count = size1; count > 0; count--)
         temp = temp->rest();
 
-      printf ("%*sif (key < %d)\n"
-              "%*s  {\n",
-              indent, "", temp->first()->_hash_value,
-              indent, "");
+      out.format ("%*sif (key < %d)\n"
+                  "%*s  {\n",
+                  indent, "", temp->first()->_hash_value,
+                  indent, "");
 
       output_switches (list, part1, size1, min_hash_value, temp->first()->_hash_value-1, indent+4);
 
-      printf ("%*s  }\n"
-              "%*selse\n"
-              "%*s  {\n",
-              indent, "", indent, "", indent, "");
+      out.format ("%*s  }\n"
+                  "%*selse\n"
+                  "%*s  {\n",
+                  indent, "", indent, "", indent, "");
 
       output_switches (temp, part2, size2, temp->first()->_hash_value, max_hash_value, indent+4);
 
-      printf ("%*s  }\n",
-              indent, "");
+      out.format ("%*s  }\n",
+                  indent, "");
     }
   else
     {
@@ -1631,49 +2865,80 @@ output_switches (KeywordExt_List *list, int num_switches, int size, int min_hash
             output_switch_case (list, indent, &jumps_away);
           else
             {
-              printf ("%*sif (key == %d)\n"
-                      "%*s  {\n",
-                      indent, "", lowest_case_value,
-                      indent, "");
+              out.format ("%*sif (key == %d)\n"
+                          "%*s  {\n",
+                          indent, "", lowest_case_value,
+                          indent, "");
               output_switch_case (list, indent+4, &jumps_away);
-              printf ("%*s  }\n",
-                      indent, "");
+              out.format ("%*s  }\n",
+                          indent, "");
             }
         }
       else
         {
           if (lowest_case_value == 0)
-            printf ("%*sswitch (key)\n", indent, "");
+            out.format ("%*sswitch (key)\n", indent, "");
           else
-            printf ("%*sswitch (key - %d)\n", indent, "", lowest_case_value);
-          printf ("%*s  {\n",
-                  indent, "");
+            out.format ("%*sswitch (key - %d)\n", indent, "", lowest_case_value);
+          out.format ("%*s  {\n",
+                      indent, "");
           for (; size > 0; size--)
             {
               int jumps_away = 0;
-              printf ("%*s    case %d:\n",
-                      indent, "", list->first()->_hash_value - lowest_case_value);
+              out.format ("%*s    case %d:\n",
+                          indent, "", list->first()->_hash_value - lowest_case_value);
               list = output_switch_case (list, indent+6, &jumps_away);
               if (!jumps_away)
-                printf ("%*s      break;\n",
-                        indent, "");
+                out.format ("%*s      break;\n",
+                            indent, "");
             }
-          printf ("%*s  }\n",
-                  indent, "");
+          out.format ("%*s  }\n",
+                      indent, "");
         }
     }
 }
 
+/* Generates a reference to the element at INDEX of the table NAME.  When the
+   tables are split into shards, NAME_shards points to the shards.  */
+
+void
+Output::output_table_ref (const char *name, const char *index) const
+{
+  if (_shard_size > 0)
+    out.format ("%s_shards[%s / %sSHARD_SIZE][%s %% %sSHARD_SIZE]",
+                name, index, option.get_constants_prefix (),
+                index, option.get_constants_prefix ());
+  else
+    out.format ("%s[%s]", name, index);
+}
+
+/* Generates the addition of the string pool that holds the string of the
+   keyword table element at INDEX.  */
+
+void
+Output::output_pool_ref (const char *index) const
+{
+  if (_shard_size > 0)
+    out.format (" + %s_shards[%s / %sSHARD_SIZE]",
+                option.get_stringpool_name (), index,
+                option.get_constants_prefix ());
+  else
+    out.format (" + %s",
+                option.get_stringpool_name ());
+}
+
 /* Generates C code to perform the keyword lookup.  */
 
 void
 Output::output_lookup_function_body (const Output_Compare& comparison) const
 {
-  printf ("  if (len <= %sMAX_WORD_LENGTH && len >= %sMIN_WORD_LENGTH)\n"
-          "    {\n"
-          "      %sunsigned int key = %s (str, len);\n\n",
-          option.get_constants_prefix (), option.get_constants_prefix (),
-          register_scs, option.get_hash_name ());
+  out.format ("  if (len <= %sMAX_WORD_LENGTH && len >= %sMIN_WORD_LENGTH)\n"
+              "    {\n",
+              option.get_constants_prefix (), option.get_constants_prefix ());
+  if (_prefilter != NULL)
+    output_prefilter_check ();
+  out.format ("      %sunsigned int key = %s (str, len);\n\n",
+              register_scs, option.get_hash_name ());
 
   if (option[SWITCH])
     {
@@ -1682,231 +2947,259 @@ Output::output_lookup_function_body (const Output_Compare& comparison) const
       if (num_switches > switch_size)
         num_switches = switch_size;
 
-      printf ("      if (key <= %sMAX_HASH_VALUE",
-              option.get_constants_prefix ());
+      out.format ("      if (key <= %sMAX_HASH_VALUE",
+                  option.get_constants_prefix ());
       if (_min_hash_value > 0)
-        printf (" && key >= %sMIN_HASH_VALUE",
-                option.get_constants_prefix ());
-      printf (")\n"
-              "        {\n");
+        out.format (" && key >= %sMIN_HASH_VALUE",
+                    option.get_constants_prefix ());
+      out.put (")\n"
+               "        {\n");
       if (option[DUP] && _total_duplicates > 0)
         {
           if (option[LENTABLE])
-            printf ("          %s%s%s *lengthptr;\n",
-                    register_scs, const_always,
-                    smallest_integral_type (_max_key_len));
-          printf ("          %s",
-                  register_scs);
+            out.format ("          %s%s%s *lengthptr;\n",
+                        register_scs, const_always,
+                        smallest_integral_type (_max_key_len));
+          out.format ("          %s",
+                      register_scs);
           output_const_type (const_readonly_array, _wordlist_eltype);
-          printf ("*wordptr;\n");
-          printf ("          %s",
-                  register_scs);
+          out.put ("*wordptr;\n");
+          out.format ("          %s",
+                      register_scs);
           output_const_type (const_readonly_array, _wordlist_eltype);
-          printf ("*wordendptr;\n");
+          out.put ("*wordendptr;\n");
         }
       if (option[TYPE])
         {
-          printf ("          %s",
-                  register_scs);
+          out.format ("          %s",
+                      register_scs);
           output_const_type (const_readonly_array, _struct_tag);
-          printf ("*resword;\n\n");
+          out.put ("*resword;\n\n");
         }
       else
-        printf ("          %s%sresword;\n\n",
-                register_scs, _struct_tag);
+        out.format ("          %s%sresword;\n\n",
+                    register_scs, _struct_tag);
 
       output_switches (_head, num_switches, switch_size, _min_hash_value, _max_hash_value, 10);
 
-      printf ("          return 0;\n");
+      out.put ("          return 0;\n");
       if (option[DUP] && _total_duplicates > 0)
         {
           int indent = 8;
-          printf ("%*smulticompare:\n"
-                  "%*s  while (wordptr < wordendptr)\n"
-                  "%*s    {\n",
-                  indent, "", indent, "", indent, "");
+          out.format ("%*smulticompare:\n"
+                      "%*s  while (wordptr < wordendptr)\n"
+                      "%*s    {\n",
+                      indent, "", indent, "", indent, "");
           if (option[LENTABLE])
             {
-              printf ("%*s      if (len == *lengthptr)\n"
-                      "%*s        {\n",
-                      indent, "", indent, "");
+              out.format ("%*s      if (len == *lengthptr)\n"
+                          "%*s        {\n",
+                          indent, "", indent, "");
               indent += 4;
             }
-          printf ("%*s      %s%schar *s = ",
-                  indent, "", register_scs, const_always);
+          out.format ("%*s      %s%schar *s = ",
+                      indent, "", register_scs, const_always);
           if (option[TYPE])
-            printf ("wordptr->%s", option.get_slot_name ());
+            out.format ("wordptr->%s", option.get_slot_name ());
           else
-            printf ("*wordptr");
+            out.put ("*wordptr");
           if (option[SHAREDLIB])
-            printf (" + %s",
-                    option.get_stringpool_name ());
-          printf (";\n\n"
-                  "%*s      if (",
-                  indent, "");
+            out.format (" + %s",
+                        option.get_stringpool_name ());
+          out.format (";\n\n"
+                      "%*s      if (",
+                      indent, "");
           comparison.output_comparison (Output_Expr1 ("str"), Output_Expr1 ("s"));
-          printf (")\n"
-                  "%*s        return %s;\n",
-                  indent, "",
-                  option[TYPE] ? "wordptr" : "s");
+          out.format (")\n"
+                      "%*s        return %s;\n",
+                      indent, "",
+                      option[TYPE] ? "wordptr" : "s");
           if (option[LENTABLE])
             {
               indent -= 4;
-              printf ("%*s        }\n",
-                      indent, "");
+              out.format ("%*s        }\n",
+                          indent, "");
             }
           if (option[LENTABLE])
-            printf ("%*s      lengthptr++;\n",
-                    indent, "");
-          printf ("%*s      wordptr++;\n"
-                  "%*s    }\n"
-                  "%*s  return 0;\n",
-                  indent, "", indent, "", indent, "");
+            out.format ("%*s      lengthptr++;\n",
+                        indent, "");
+          out.format ("%*s      wordptr++;\n"
+                      "%*s    }\n"
+                      "%*s  return 0;\n",
+                      indent, "", indent, "", indent, "");
         }
-      printf ("        compare:\n");
+      out.put ("        compare:\n");
       if (option[TYPE])
         {
-          printf ("          {\n"
-                  "            %s%schar *s = resword->%s",
-                  register_scs, const_always, option.get_slot_name ());
+          out.format ("          {\n"
+                      "            %s%schar *s = resword->%s",
+                      register_scs, const_always, option.get_slot_name ());
           if (option[SHAREDLIB])
-            printf (" + %s",
-                    option.get_stringpool_name ());
-          printf (";\n\n"
-                  "            if (");
+            out.format (" + %s",
+                        option.get_stringpool_name ());
+          out.put (";\n\n"
+                   "            if (");
           comparison.output_comparison (Output_Expr1 ("str"), Output_Expr1 ("s"));
-          printf (")\n"
-                  "              return resword;\n"
-                  "          }\n");
+          out.put (")\n"
+                   "              return resword;\n"
+                   "          }\n");
         }
       else
         {
-          printf ("          if (");
+          out.put ("          if (");
           comparison.output_comparison (Output_Expr1 ("str"), Output_Expr1 ("resword"));
-          printf (")\n"
-                  "            return resword;\n");
+          out.put (")\n"
+                   "            return resword;\n");
         }
-      printf ("        }\n");
+      out.put ("        }\n");
     }
   else
     {
-      printf ("      if (key <= %sMAX_HASH_VALUE)\n",
-              option.get_constants_prefix ());
+      out.format ("      if (key <= %sMAX_HASH_VALUE)\n",
+                  option.get_constants_prefix ());
 
       if (option[DUP])
         {
           int indent = 8;
-          printf ("%*s{\n"
-                  "%*s  %sint index = lookup[key];\n\n"
-                  "%*s  if (index >= 0)\n",
-                  indent, "", indent, "", register_scs, indent, "");
+          out.format ("%*s{\n"
+                      "%*s  %sint index = lookup[key];\n\n"
+                      "%*s  if (index >= 0)\n",
+                      indent, "", indent, "", register_scs, indent, "");
           if (option[LENTABLE])
             {
-              printf ("%*s    {\n"
-                      "%*s      if (len == %s[index])\n",
-                      indent, "", indent, "", option.get_lengthtable_name ());
+              out.format ("%*s    {\n"
+                          "%*s      if (len == ",
+                          indent, "", indent, "");
+              output_table_ref (option.get_lengthtable_name (), "index");
+              out.put (")\n");
               indent += 4;
             }
-          printf ("%*s    {\n"
-                  "%*s      %s%schar *s = %s[index]",
-                  indent, "",
-                  indent, "", register_scs, const_always,
-                  option.get_wordlist_name ());
+          out.format ("%*s    {\n"
+                      "%*s      %s%schar *s = ",
+                      indent, "",
+                      indent, "", register_scs, const_always);
+          output_table_ref (option.get_wordlist_name (), "index");
           if (option[TYPE])
-            printf (".%s", option.get_slot_name ());
+            out.format (".%s", option.get_slot_name ());
           if (option[SHAREDLIB])
-            printf (" + %s",
-                    option.get_stringpool_name ());
-          printf (";\n\n"
-                  "%*s      if (",
-                  indent, "");
+            output_pool_ref ("index");
+          out.format (";\n\n"
+                      "%*s      if (",
+                      indent, "");
           comparison.output_comparison (Output_Expr1 ("str"), Output_Expr1 ("s"));
-          printf (")\n"
-                  "%*s        return ",
-                  indent, "");
+          out.format (")\n"
+                      "%*s        return ",
+                      indent, "");
           if (option[TYPE])
-            printf ("&%s[index]", option.get_wordlist_name ());
+            {
+              out.put ('&');
+              output_table_ref (option.get_wordlist_name (), "index");
+            }
           else
-            printf ("s");
-          printf (";\n"
-                  "%*s    }\n",
-                  indent, "");
+            out.put ("s");
+          out.format (";\n"
+                      "%*s    }\n",
+                      indent, "");
           if (option[LENTABLE])
             {
               indent -= 4;
-              printf ("%*s    }\n", indent, "");
+              out.format ("%*s    }\n", indent, "");
             }
           if (_total_duplicates > 0)
             {
-              printf ("%*s  else if (index < -%sTOTAL_KEYWORDS)\n"
-                      "%*s    {\n"
-                      "%*s      %sint offset = - 1 - %sTOTAL_KEYWORDS - index;\n",
-                      indent, "", option.get_constants_prefix (), indent, "",
-                      indent, "", register_scs, option.get_constants_prefix ());
-              if (option[LENTABLE])
-                printf ("%*s      %s%s%s *lengthptr = &%s[%sTOTAL_KEYWORDS + lookup[offset]];\n",
-                        indent, "", register_scs, const_always, smallest_integral_type (_max_key_len),
-                        option.get_lengthtable_name (), option.get_constants_prefix ());
-              printf ("%*s      %s",
-                      indent, "", register_scs);
-              output_const_type (const_readonly_array, _wordlist_eltype);
-              printf ("*wordptr = &%s[%sTOTAL_KEYWORDS + lookup[offset]];\n",
-                      option.get_wordlist_name (), option.get_constants_prefix ());
-              printf ("%*s      %s",
-                      indent, "", register_scs);
+              out.format ("%*s  else if (index < -%sTOTAL_KEYWORDS)\n"
+                          "%*s    {\n"
+                          "%*s      %sint offset = - 1 - %sTOTAL_KEYWORDS - index;\n",
+                          indent, "", option.get_constants_prefix (), indent, "",
+                          indent, "", register_scs, option.get_constants_prefix ());
+              if (_shard_size > 0)
+                {
+                  /* A duplicate set is contiguous within the shard that
+                     holds its first element.  */
+                  out.format ("%*s      %sint start = %sTOTAL_KEYWORDS + lookup[offset];\n",
+                              indent, "", register_scs, option.get_constants_prefix ());
+                  if (option[LENTABLE])
+                    {
+                      out.format ("%*s      %s%s%s *lengthptr = &",
+                                  indent, "", register_scs, const_always, smallest_integral_type (_max_key_len));
+                      output_table_ref (option.get_lengthtable_name (), "start");
+                      out.put (";\n");
+                    }
+                  out.format ("%*s      %s",
+                              indent, "", register_scs);
+                  output_const_type (const_readonly_array, _wordlist_eltype);
+                  out.put ("*wordptr = &");
+                  output_table_ref (option.get_wordlist_name (), "start");
+                  out.put (";\n");
+                }
+              else
+                {
+                  if (option[LENTABLE])
+                    out.format ("%*s      %s%s%s *lengthptr = &%s[%sTOTAL_KEYWORDS + lookup[offset]];\n",
+                                indent, "", register_scs, const_always, smallest_integral_type (_max_key_len),
+                                option.get_lengthtable_name (), option.get_constants_prefix ());
+                  out.format ("%*s      %s",
+                              indent, "", register_scs);
+                  output_const_type (const_readonly_array, _wordlist_eltype);
+                  out.format ("*wordptr = &%s[%sTOTAL_KEYWORDS + lookup[offset]];\n",
+                              option.get_wordlist_name (), option.get_constants_prefix ());
+                }
+              out.format ("%*s      %s",
+                          indent, "", register_scs);
               output_const_type (const_readonly_array, _wordlist_eltype);
-              printf ("*wordendptr = wordptr + -lookup[offset + 1];\n\n");
-              printf ("%*s      while (wordptr < wordendptr)\n"
-                      "%*s        {\n",
-                      indent, "", indent, "");
+              out.put ("*wordendptr = wordptr + -lookup[offset + 1];\n\n");
+              out.format ("%*s      while (wordptr < wordendptr)\n"
+                          "%*s        {\n",
+                          indent, "", indent, "");
               if (option[LENTABLE])
                 {
-                  printf ("%*s          if (len == *lengthptr)\n"
-                          "%*s            {\n",
-                          indent, "", indent, "");
+                  out.format ("%*s          if (len == *lengthptr)\n"
+                              "%*s            {\n",
+                              indent, "", indent, "");
                   indent += 4;
                 }
-              printf ("%*s          %s%schar *s = ",
-                      indent, "", register_scs, const_always);
+              out.format ("%*s          %s%schar *s = ",
+                          indent, "", register_scs, const_always);
               if (option[TYPE])
-                printf ("wordptr->%s", option.get_slot_name ());
+                out.format ("wordptr->%s", option.get_slot_name ());
               else
-                printf ("*wordptr");
+                out.put ("*wordptr");
               if (option[SHAREDLIB])
-                printf (" + %s",
-                        option.get_stringpool_name ());
-              printf (";\n\n"
-                      "%*s          if (",
-                      indent, "");
+                output_pool_ref ("start");
+              out.format (";\n\n"
+                          "%*s          if (",
+                          indent, "");
               comparison.output_comparison (Output_Expr1 ("str"), Output_Expr1 ("s"));
-              printf (")\n"
-                      "%*s            return %s;\n",
-                      indent, "",
-                      option[TYPE] ? "wordptr" : "s");
+              out.format (")\n"
+                          "%*s            return %s;\n",
+                          indent, "",
+                          option[TYPE] ? "wordptr" : "s");
               if (option[LENTABLE])
                 {
                   indent -= 4;
-                  printf ("%*s            }\n",
-                          indent, "");
+                  out.format ("%*s            }\n",
+                              indent, "");
                 }
               if (option[LENTABLE])
-                printf ("%*s          lengthptr++;\n",
-                        indent, "");
-              printf ("%*s          wordptr++;\n"
-                      "%*s        }\n"
-                      "%*s    }\n",
-                      indent, "", indent, "", indent, "");
+                out.format ("%*s          lengthptr++;\n",
+                            indent, "");
+              out.format ("%*s          wordptr++;\n"
+                          "%*s        }\n"
+                          "%*s    }\n",
+                          indent, "", indent, "", indent, "");
             }
-          printf ("%*s}\n",
-                  indent, "");
+          out.format ("%*s}\n",
+                      indent, "");
         }
       else
         {
           int indent = 8;
           if (option[LENTABLE])
             {
-              printf ("%*sif (len == %s[key])\n",
-                      indent, "", option.get_lengthtable_name ());
+              out.format ("%*sif (len == ",
+                          indent, "");
+              output_table_ref (option.get_lengthtable_name (), "key");
+              out.put (")\n");
               indent += 2;
             }
 
@@ -1914,75 +3207,77 @@ Output::output_lookup_function_body (const Output_Compare& comparison) const
             {
               if (!option[LENTABLE])
                 {
-                  printf ("%*s{\n"
-                          "%*s  %sint o = %s[key]",
-                          indent, "",
-                          indent, "", register_scs,
-                          option.get_wordlist_name ());
+                  out.format ("%*s{\n"
+                              "%*s  %sint o = ",
+                              indent, "",
+                              indent, "", register_scs);
+                  output_table_ref (option.get_wordlist_name (), "key");
                   if (option[TYPE])
-                    printf (".%s", option.get_slot_name ());
-                  printf (";\n"
-                          "%*s  if (o >= 0)\n"
-                          "%*s    {\n",
-                          indent, "",
-                          indent, "");
+                    out.format (".%s", option.get_slot_name ());
+                  out.format (";\n"
+                              "%*s  if (o >= 0)\n"
+                              "%*s    {\n",
+                              indent, "",
+                              indent, "");
                   indent += 4;
-                  printf ("%*s  %s%schar *s = o",
-                          indent, "", register_scs, const_always);
+                  out.format ("%*s  %s%schar *s = o",
+                              indent, "", register_scs, const_always);
                 }
               else
                 {
                   /* No need for the (o >= 0) test, because the
                      (len == lengthtable[key]) test already guarantees that
                      key points to nonempty table entry.  */
-                  printf ("%*s{\n"
-                          "%*s  %s%schar *s = %s[key]",
-                          indent, "",
-                          indent, "", register_scs, const_always,
-                          option.get_wordlist_name ());
+                  out.format ("%*s{\n"
+                              "%*s  %s%schar *s = ",
+                              indent, "",
+                              indent, "", register_scs, const_always);
+                  output_table_ref (option.get_wordlist_name (), "key");
                   if (option[TYPE])
-                    printf (".%s", option.get_slot_name ());
+                    out.format (".%s", option.get_slot_name ());
                 }
-              printf (" + %s",
-                      option.get_stringpool_name ());
+              output_pool_ref ("key");
             }
           else
             {
-              printf ("%*s{\n"
-                      "%*s  %s%schar *s = %s[key]",
-                      indent, "",
-                      indent, "", register_scs, const_always,
-                      option.get_wordlist_name ());
+              out.format ("%*s{\n"
+                          "%*s  %s%schar *s = ",
+                          indent, "",
+                          indent, "", register_scs, const_always);
+              output_table_ref (option.get_wordlist_name (), "key");
               if (option[TYPE])
-                printf (".%s", option.get_slot_name ());
+                out.format (".%s", option.get_slot_name ());
             }
 
-          printf (";\n\n"
-                  "%*s  if (",
-                  indent, "");
+          out.format (";\n\n"
+                      "%*s  if (",
+                      indent, "");
           if (!option[SHAREDLIB] && option[NULLSTRINGS])
-            printf ("s && ");
+            out.put ("s && ");
           comparison.output_comparison (Output_Expr1 ("str"), Output_Expr1 ("s"));
-          printf (")\n"
-                  "%*s    return ",
-                  indent, "");
+          out.format (")\n"
+                      "%*s    return ",
+                      indent, "");
           if (option[TYPE])
-            printf ("&%s[key]", option.get_wordlist_name ());
+            {
+              out.put ('&');
+              output_table_ref (option.get_wordlist_name (), "key");
+            }
           else
-            printf ("s");
-          printf (";\n");
+            out.put ("s");
+          out.put (";\n");
           if (option[SHAREDLIB] && !option[LENTABLE])
             {
               indent -= 4;
-              printf ("%*s    }\n",
-                      indent, "");
+              out.format ("%*s    }\n",
+                          indent, "");
             }
-          printf ("%*s}\n",
-                  indent, "");
+          out.format ("%*s}\n",
+                      indent, "");
         }
     }
-  printf ("    }\n"
-          "  return 0;\n");
+  out.put ("    }\n"
+           "  return 0;\n");
 }
 
 /* Generates C code for the lookup function.  */
@@ -1997,26 +3292,26 @@ Output::output_lookup_function () const
      because non-static inline functions must not reference static functions or
      variables, see ISO C 99 section 6.7.4.(3).  */
 
-  printf ("%s%s\n",
-          const_for_struct, _return_type);
+  out.format ("%s%s%s\n",
+              constexpr_scs, const_for_struct, _return_type);
   if (option[CPLUSPLUS])
-    printf ("%s::", option.get_class_name ());
-  printf ("%s ", option.get_function_name ());
-  printf (option[KRC] ?
-                 "(str, len)\n"
-            "     %schar *str;\n"
-            "     %ssize_t len;\n" :
-          option[C] ?
-                 "(str, len)\n"
-            "     %sconst char *str;\n"
-            "     %ssize_t len;\n" :
-          option[ANSIC] | option[CPLUSPLUS] ?
-                 "(%sconst char *str, %ssize_t len)\n" :
-          "",
-          register_scs, register_scs);
+    out.format ("%s::", option.get_class_name ());
+  out.format ("%s ", option.get_function_name ());
+  out.format (option[KRC] ?
+                     "(str, len)\n"
+                "     %schar *str;\n"
+                "     %ssize_t len;\n" :
+              option[C] ?
+                     "(str, len)\n"
+                "     %sconst char *str;\n"
+                "     %ssize_t len;\n" :
+              option[ANSIC] | option[CPLUSPLUS] ?
+                     "(%sconst char *str, %ssize_t len)\n" :
+              "",
+              register_scs, register_scs);
 
   /* Output the function's body.  */
-  printf ("{\n");
+  out.put ("{\n");
 
   if (option[ENUM] && !option[GLOBAL])
     {
@@ -2024,13 +3319,23 @@ Output::output_lookup_function () const
       output_constants (style);
     }
 
-  if (option[SHAREDLIB] && !(option[GLOBAL] || option[TYPE]))
+  if (option[SHAREDLIB] && !(option[GLOBAL] || option[TYPE] || _shard_size > 0))
     output_lookup_pools ();
-  if (!option[GLOBAL])
+  /* In C++17, the tables are class members.  */
+  if (!option[GLOBAL] && !option[CPLUSPLUS17])
     output_lookup_tables ();
 
   if (option[LENTABLE])
     output_lookup_function_body (Output_Compare_Memcmp ());
+  else if (option[CPLUSPLUS17])
+    {
+      /* The string_view overload passes strings that are not NUL
+         terminated.  */
+      if (option[UPPERLOWER])
+        output_lookup_function_body (Output_Compare_Strncmp ());
+      else
+        output_lookup_function_body (Output_Compare_Length ());
+    }
   else
     {
       if (option[COMP])
@@ -2039,7 +3344,1091 @@ Output::output_lookup_function () const
         output_lookup_function_body (Output_Compare_Strcmp ());
     }
 
-  printf ("}\n");
+  out.put ("}\n");
+  /* Don't let the macro of output_string_pool leak into the rest of the
+     file.  */
+  if (_pool_offsets != NULL)
+    out.format ("#undef %s\n", option.get_stringpool_name ());
+
+  if (option[CPLUSPLUS17])
+    out.format ("\n"
+                "constexpr %s%s\n"
+                "%s::%s (std::string_view str)\n"
+                "{\n"
+                "  return %s (str.data (), str.size ());\n"
+                "}\n",
+                const_for_struct, _return_type,
+                option.get_class_name (), option.get_function_name (),
+                option.get_function_name ());
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* The header that the output of --traits includes, by default.  */
+static const char * const DEFAULT_LOOKUP_TEMPLATE_FILE_NAME = "gperf-lookup.h";
+
+/* Version of the interface between the lookup template and the traits
+   classes.  It must be incremented whenever the members that the template
+   uses change.  */
+static const int LOOKUP_TEMPLATE_VERSION = 1;
+
+/* Writes the C++17 lookup template to the file given by --lookup-template.
+   It contains the hash function and the lookup function once, in terms of
+   the constants and tables of a traits class, so that a program with
+   several keyword tables compiles the lookup logic only once.  */
+
+void
+Output::output_lookup_template () const
+{
+  const char *file_name = option.get_lookup_template_file_name ();
+  FILE *stream = fopen (file_name, "w");
+  if (stream == NULL)
+    {
+      fprintf (stderr, "Cannot open output file '%s'\n", file_name);
+      exit (1);
+    }
+
+  fprintf (stream,
+           "/* C++17 lookup template for gperf --traits, produced by gperf version %s */\n"
+           "\n"
+           "#ifndef GPERF_LOOKUP_TEMPLATE\n"
+           "#define GPERF_LOOKUP_TEMPLATE %d\n"
+           "\n"
+           "#include <cstddef>\n"
+           "#include <string_view>\n"
+           "\n",
+           version_string, LOOKUP_TEMPLATE_VERSION);
+  fprintf (stream,
+           "namespace gperf\n"
+           "{\n"
+           "  template <class Traits>\n"
+           "  struct keyword_table\n"
+           "  {\n"
+           "    static constexpr unsigned int\n"
+           "    hash (const char *str, std::size_t len)\n"
+           "    {\n"
+           "      unsigned int hval =\n"
+           "        Traits::HASH_INCLUDES_LEN ? static_cast<unsigned int>(len) : 0;\n"
+           "      if constexpr (Traits::NUM_POSITIONS > 0)\n"
+           "        for (int i = 0; i < Traits::NUM_POSITIONS; i++)\n"
+           "          {\n"
+           "            /* A negative position p denotes the character at len + p.\n"
+           "               For shorter strings, pos wraps around and is >= len.  */\n"
+           "            std::size_t pos =\n"
+           "              Traits::positions[i] < 0\n"
+           "              ? len - static_cast<std::size_t>(-Traits::positions[i])\n"
+           "              : static_cast<std::size_t>(Traits::positions[i]);\n"
+           "            if (pos < len)\n"
+           "              {\n"
+           "                unsigned int c =\n"
+           "                  static_cast<unsigned char>(str[pos] + Traits::alpha_inc[i]);\n"
+           "                if (Traits::ALPHA_REDUCED)\n"
+           "                  c &= 15;\n"
+           "                hval += Traits::asso_values[c];\n"
+           "              }\n"
+           "          }\n"
+           "      return hval;\n"
+           "    }\n"
+           "\n"
+           "    static constexpr bool\n"
+           "    matches (const char *str, std::size_t len, int index)\n"
+           "    {\n"
+           "      const char *s = Traits::key (index);\n"
+           "      if constexpr (Traits::USE_LENGTH_TABLE)\n"
+           "        {\n"
+           "          if (len != Traits::length (index))\n"
+           "            return false;\n"
+           "        }\n"
+           "      else\n"
+           "        {\n"
+           "          if (s == nullptr || std::char_traits<char>::length (s) != len)\n"
+           "            return false;\n"
+           "        }\n"
+           "      if constexpr (Traits::IGNORE_CASE)\n"
+           "        {\n"
+           "          for (std::size_t i = 0; i < len; i++)\n"
+           "            {\n"
+           "              char c1 = str[i];\n"
+           "              char c2 = s[i];\n"
+           "              if (c1 >= 'A' && c1 <= 'Z')\n"
+           "                c1 = static_cast<char>(c1 - 'A' + 'a');\n"
+           "              if (c2 >= 'A' && c2 <= 'Z')\n"
+           "                c2 = static_cast<char>(c2 - 'A' + 'a');\n"
+           "              if (c1 != c2)\n"
+           "                return false;\n"
+           "            }\n"
+           "          return true;\n"
+           "        }\n"
+           "      else\n"
+           "        return !std::char_traits<char>::compare (str, s, len);\n"
+           "    }\n"
+           "\n"
+           "    static constexpr typename Traits::result_type\n"
+           "    in_word_set (const char *str, std::size_t len)\n"
+           "    {\n"
+           "      if (len <= Traits::MAX_WORD_LENGTH && len >= Traits::MIN_WORD_LENGTH)\n"
+           "        {\n"
+           "          unsigned int key = hash (str, len);\n"
+           "\n"
+           "          if (key <= Traits::MAX_HASH_VALUE)\n"
+           "            {\n"
+           "              if constexpr (Traits::USE_LOOKUP_ARRAY)\n"
+           "                {\n"
+           "                  int index = Traits::lookup[key];\n"
+           "\n"
+           "                  if (index >= 0)\n"
+           "                    {\n"
+           "                      if (matches (str, len, index))\n"
+           "                        return Traits::result (index);\n"
+           "                    }\n"
+           "                  else if (index < -Traits::TOTAL_KEYWORDS)\n"
+           "                    {\n"
+           "                      int offset = - 1 - Traits::TOTAL_KEYWORDS - index;\n"
+           "                      int first = Traits::TOTAL_KEYWORDS + Traits::lookup[offset];\n"
+           "                      int end = first - Traits::lookup[offset + 1];\n"
+           "\n"
+           "                      for (int i = first; i < end; i++)\n"
+           "                        if (matches (str, len, i))\n"
+           "                          return Traits::result (i);\n"
+           "                    }\n"
+           "                }\n"
+           "              else\n"
+           "                {\n"
+           "                  int index = static_cast<int>(key);\n"
+           "\n"
+           "                  if (matches (str, len, index))\n"
+           "                    return Traits::result (index);\n"
+           "                }\n"
+           "            }\n"
+           "        }\n"
+           "      return nullptr;\n"
+           "    }\n"
+           "\n"
+           "    static constexpr typename Traits::result_type\n"
+           "    in_word_set (std::string_view str)\n"
+           "    {\n"
+           "      return in_word_set (str.data (), str.size ());\n"
+           "    }\n"
+           "  };\n"
+           "}\n"
+           "\n"
+           "#endif\n");
+
+  if (ferror (stream) | fclose (stream))
+    {
+      fprintf (stderr, "error while writing output file '%s'\n", file_name);
+      exit (1);
+    }
+}
+
+/* Generates the #include of the lookup template, and a check that it
+   matches the traits class.  */
+
+void
+Output::output_lookup_template_include () const
+{
+  const char *file_name = option.get_lookup_template_file_name ();
+  file_name =
+    (file_name != NULL ? base_name (file_name) : DEFAULT_LOOKUP_TEMPLATE_FILE_NAME);
+  out.format ("#include \"%s\"\n"
+              "#if GPERF_LOOKUP_TEMPLATE != %d\n"
+              "#error \"%s does not match this version of gperf\"\n"
+              "#endif\n"
+              "\n",
+              file_name, LOOKUP_TEMPLATE_VERSION, file_name);
+}
+
+/* Generates the traits class <class>_traits, which holds the constants and
+   tables of this keyword set, and the class <class> that derives from the
+   lookup template specialized for it.  */
+
+void
+Output::output_traits () const
+{
+  const char *class_name = option.get_class_name ();
+
+  out.format ("struct %s_traits\n"
+              "{\n"
+              "  typedef %s%s result_type;\n"
+              "\n",
+              class_name, const_for_struct, _return_type);
+
+  out.format ("  static constexpr int TOTAL_KEYWORDS = %d;\n"
+              "  static constexpr std::size_t MIN_WORD_LENGTH = %d;\n"
+              "  static constexpr std::size_t MAX_WORD_LENGTH = %d;\n"
+              "  static constexpr unsigned int MIN_HASH_VALUE = %d;\n"
+              "  static constexpr unsigned int MAX_HASH_VALUE = %d;\n"
+              "  static constexpr bool HASH_INCLUDES_LEN = %s;\n"
+              "  static constexpr bool ALPHA_REDUCED = %s;\n"
+              "  static constexpr bool IGNORE_CASE = %s;\n"
+              "  static constexpr bool USE_LENGTH_TABLE = %s;\n"
+              "  static constexpr bool USE_LOOKUP_ARRAY = %s;\n",
+              _total_keys, _min_key_len, _max_key_len,
+              _min_hash_value, _max_hash_value,
+              _hash_includes_len ? "true" : "false",
+              _alpha_reduced ? "true" : "false",
+              option[UPPERLOWER] ? "true" : "false",
+              option[LENTABLE] ? "true" : "false",
+              option[DUP] ? "true" : "false");
+
+  /* The key positions, in the same order as in the hash function.  */
+  {
+    PositionIterator iter = _key_positions.iterator(_max_key_len);
+    out.format ("  static constexpr int NUM_POSITIONS = %u;\n",
+                iter.remaining ());
+
+    out.put ("  static constexpr int positions[] = {");
+    int count = 0;
+    for (int key_pos; (key_pos = iter.next ()) != PositionIterator::EOS; count++)
+      out.format ("%s %d", count > 0 ? "," : "", key_pos);
+    out.format ("%s };\n", count > 0 ? "" : " 0");
+  }
+  {
+    PositionIterator iter = _key_positions.iterator(_max_key_len);
+    out.put ("  static constexpr unsigned int alpha_inc[] = {");
+    int count = 0;
+    for (int key_pos; (key_pos = iter.next ()) != PositionIterator::EOS; count++)
+      out.format ("%s %u", count > 0 ? "," : "",
+                  key_pos < 0 ? 0 : _alpha_inc[key_pos]);
+    out.format ("%s };\n", count > 0 ? "" : " 0");
+  }
+  out.put ("\n");
+
+  output_asso_values_table ();
+  if (_key_positions.get_size() > 0)
+    out.put ("\n");
+  output_lookup_tables ();
+
+  out.format ("  static constexpr const char *key (int index)\n"
+              "  {\n"
+              "    return %s[index]%s%s;\n"
+              "  }\n"
+              "  static constexpr result_type result (int index)\n"
+              "  {\n"
+              "    return %s%s[index];\n"
+              "  }\n",
+              option.get_wordlist_name (),
+              option[TYPE] ? "." : "", option[TYPE] ? option.get_slot_name () : "",
+              option[TYPE] ? "&" : "", option.get_wordlist_name ());
+  if (option[LENTABLE])
+    out.format ("  static constexpr std::size_t length (int index)\n"
+                "  {\n"
+                "    return %s[index];\n"
+                "  }\n",
+                option.get_lengthtable_name ());
+  out.put ("};\n"
+           "\n");
+
+  out.format ("class %s : public gperf::keyword_table<%s_traits>\n"
+              "{\n",
+              class_name, class_name);
+  /* The template's lookup function is called in_word_set.  Forward to it
+     under the name chosen by the user.  */
+  if (strcmp (option.get_function_name (), "in_word_set") != 0)
+    out.format ("public:\n"
+                "  static constexpr %s%s\n"
+                "  %s (const char *str, std::size_t len)\n"
+                "  {\n"
+                "    return in_word_set (str, len);\n"
+                "  }\n"
+                "  static constexpr %s%s\n"
+                "  %s (std::string_view str)\n"
+                "  {\n"
+                "    return in_word_set (str);\n"
+                "  }\n",
+                const_for_struct, _return_type, option.get_function_name (),
+                const_for_struct, _return_type, option.get_function_name ());
+  out.put ("};\n");
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* The binary image starts with these bytes.  */
+static const char image_magic[8] =
+  { '\211', 'g', 'p', 'i', 'm', 'g', '\r', '\n' };
+
+/* Size of the image header: the magic bytes, followed by 18 numbers.  */
+static const unsigned int IMAGE_HEADER_SIZE = 8 + 18 * 4;
+
+/* Stores VALUE at P, as a 32-bit little-endian number.  */
+static void
+image_put (unsigned char *p, unsigned int value)
+{
+  p[0] = value & 0xff;
+  p[1] = (value >> 8) & 0xff;
+  p[2] = (value >> 16) & 0xff;
+  p[3] = (value >> 24) & 0xff;
+}
+
+/* Writes the tables to the file given by --output-image, as a position
+   independent binary image.  All numbers are 32-bit little-endian, and
+   all references are offsets from the start of the image.  The header
+   consists of
+     the magic bytes, the version (1), the flags (1 = the hash includes
+     the length, 2 = ignore case, 4 = reduced alphabet), the number of
+     keywords, the minimum and maximum keyword length, the maximum hash
+     value, the number of key positions, the offsets of the key positions
+     and of their alpha_inc, the size and the offset of asso_values, the
+     offsets of the buckets, the lengths, the words and the payloads, the
+     offset and the size of the string pool, and the size of the image.
+   The keywords are sorted by hash value; the keywords with hash value h
+   are those from buckets[h] to buckets[h+1]-1.  The words are offsets into
+   the string pool, and the payloads are (offset, length) pairs into it.
+   Each string in the pool is followed by a NUL byte.  */
+
+void
+Output::output_image () const
+{
+  /* Collect the key positions, in the order the hash function uses them.  */
+  unsigned int position_count = 0;
+  PositionIterator positions_iter = _key_positions.iterator(_max_key_len);
+  DYNAMIC_ARRAY (positions, int, positions_iter.remaining ());
+  {
+    PositionIterator iter = positions_iter;
+    for (int key_pos; (key_pos = iter.next ()) != PositionIterator::EOS; )
+      positions[position_count++] = key_pos;
+  }
+
+  /* Count the keywords and the size of the string pool.  The list is
+     sorted by hash value, and duplicates share the hash value of their
+     list element.  */
+  unsigned int count = 0;
+  size_t pool_size = 0;
+  for (KeywordExt_List *temp = _head; temp; temp = temp->rest())
+    for (KeywordExt *keyword = temp->first(); keyword;
+         keyword = keyword->_duplicate_link)
+      {
+        count++;
+        pool_size += keyword->_allchars_length + 1
+                     + (option[TYPE] ? strlen (keyword->_rest) : 0) + 1;
+      }
+
+  unsigned int asso_count = (_alpha_reduced ? 16 : _alpha_size);
+  unsigned int bucket_count = _max_hash_value + 2;
+
+  size_t positions_offset = IMAGE_HEADER_SIZE;
+  size_t alpha_inc_offset = positions_offset + 4 * position_count;
+  size_t asso_values_offset = alpha_inc_offset + 4 * position_count;
+  size_t buckets_offset = asso_values_offset + 4 * asso_count;
+  size_t lengths_offset = buckets_offset + 4 * bucket_count;
+  size_t words_offset = lengths_offset + 4 * count;
+  size_t payloads_offset = words_offset + 4 * count;
+  size_t pool_offset = payloads_offset + 8 * count;
+  size_t image_size = pool_offset + pool_size;
+  if (image_size > 0xffffffffUL)
+    {
+      fprintf (stderr, "The tables are too large for an image file.\n");
+      exit (1);
+    }
+
+  unsigned char *image = new unsigned char[image_size];
+  memset (image, 0, image_size);
+
+  /* The header.  */
+  memcpy (image, image_magic, sizeof (image_magic));
+  {
+    unsigned char *p = image + sizeof (image_magic);
+    image_put (p, 1);
+    image_put (p + 4, (_hash_includes_len ? 1 : 0)
+                      | (option[UPPERLOWER] ? 2 : 0)
+                      | (_alpha_reduced ? 4 : 0));
+    image_put (p + 8, count);
+    image_put (p + 12, _min_key_len);
+    image_put (p + 16, _max_key_len);
+    image_put (p + 20, _max_hash_value);
+    image_put (p + 24, position_count);
+    image_put (p + 28, positions_offset);
+    image_put (p + 32, alpha_inc_offset);
+    image_put (p + 36, asso_count);
+    image_put (p + 40, asso_values_offset);
+    image_put (p + 44, buckets_offset);
+    image_put (p + 48, lengths_offset);
+    image_put (p + 52, words_offset);
+    image_put (p + 56, payloads_offset);
+    image_put (p + 60, pool_offset);
+    image_put (p + 64, pool_size);
+    image_put (p + 68, image_size);
+  }
+
+  /* The hash function.  A position counted from the end is stored modulo
+     2^32, e.g. Positions::LASTCHAR as 0xffffffff.  */
+  for (unsigned int i = 0; i < position_count; i++)
+    {
+      image_put (image + positions_offset + 4 * i, positions[i]);
+      image_put (image + alpha_inc_offset + 4 * i,
+                 positions[i] < 0 ? 0 : _alpha_inc[positions[i]]);
+    }
+  for (unsigned int c = 0; c < asso_count; c++)
+    image_put (image + asso_values_offset + 4 * c, _asso_values[c]);
+
+  /* The keywords.  */
+  {
+    unsigned int index = 0;
+    int hash_value = 0;
+    size_t pool_index = 0;
+    for (KeywordExt_List *temp = _head; temp; temp = temp->rest())
+      {
+        for (; hash_value <= temp->first()->_hash_value; hash_value++)
+          image_put (image + buckets_offset + 4 * hash_value, index);
+        for (KeywordExt *keyword = temp->first(); keyword;
+             keyword = keyword->_duplicate_link)
+          {
+            image_put (image + lengths_offset + 4 * index,
+                       keyword->_allchars_length);
+            image_put (image + words_offset + 4 * index, pool_index);
+            memcpy (image + pool_offset + pool_index, keyword->_allchars,
+                    keyword->_allchars_length);
+            pool_index += keyword->_allchars_length + 1;
+
+            size_t rest_length = (option[TYPE] ? strlen (keyword->_rest) : 0);
+            image_put (image + payloads_offset + 8 * index, pool_index);
+            image_put (image + payloads_offset + 8 * index + 4, rest_length);
+            memcpy (image + pool_offset + pool_index, keyword->_rest,
+                    rest_length);
+            pool_index += rest_length + 1;
+
+            index++;
+          }
+      }
+    for (; hash_value < static_cast<int>(bucket_count); hash_value++)
+      image_put (image + buckets_offset + 4 * hash_value, index);
+  }
+
+  /* Write the image.  */
+  const char *file_name = option.get_image_file_name ();
+  FILE *stream = fopen (file_name, "wb");
+  if (stream == NULL)
+    {
+      fprintf (stderr, "Cannot open image file '%s'\n", file_name);
+      exit (1);
+    }
+  fwrite (image, 1, image_size, stream);
+  if (ferror (stream) | fclose (stream))
+    {
+      fprintf (stderr, "error while writing image file '%s'\n", file_name);
+      exit (1);
+    }
+
+  delete[] image;
+  FREE_DYNAMIC_ARRAY (positions);
+}
+
+/* Generates the reference loader for the images written by output_image.
+   It does not depend on the keywords, so that an image can be replaced
+   without recompiling.  */
+
+void
+Output::output_image_loader () const
+{
+  /* Casts, in C or C++ syntax.  */
+  const char *to_bytes_begin =
+    (option[CPLUSPLUS] ? "static_cast<const unsigned char *>(" : "(const unsigned char *) ");
+  const char *to_chars_begin =
+    (option[CPLUSPLUS] ? "reinterpret_cast<const char *>(" : "(const char *) ");
+  const char *from_chars_begin =
+    (option[CPLUSPLUS] ? "reinterpret_cast<const unsigned char *>(" : "(const unsigned char *) ");
+  const char *cast_end = (option[CPLUSPLUS] ? ")" : "");
+
+  out.put ("#ifndef GPERF_IMAGE_H\n"
+           "#define GPERF_IMAGE_H 1\n"
+           "\n"
+           "#include <stddef.h>\n"
+           "#include <string.h>\n"
+           "\n"
+           "#ifdef __GNUC__\n"
+           "#define GPERF_IMAGE_FUNCTION static __inline\n"
+           "#else\n"
+           "#ifdef __cplusplus\n"
+           "#define GPERF_IMAGE_FUNCTION static inline\n"
+           "#else\n"
+           "#define GPERF_IMAGE_FUNCTION static\n"
+           "#endif\n"
+           "#endif\n"
+           "\n"
+           "/* A keyword image, as written by gperf --output-image.  */\n"
+           "struct gperf_image\n"
+           "{\n"
+           "  unsigned int flags;\n"
+           "  unsigned int count;\n"
+           "  unsigned int min_length;\n"
+           "  unsigned int max_length;\n"
+           "  unsigned int max_hash_value;\n"
+           "  unsigned int position_count;\n"
+           "  unsigned int asso_count;\n"
+           "  unsigned int pool_size;\n"
+           "  const unsigned char *positions;\n"
+           "  const unsigned char *alpha_inc;\n"
+           "  const unsigned char *asso_values;\n"
+           "  const unsigned char *buckets;\n"
+           "  const unsigned char *lengths;\n"
+           "  const unsigned char *words;\n"
+           "  const unsigned char *payloads;\n"
+           "  const char *pool;\n"
+           "};\n"
+           "\n"
+           "/* Returns the 32-bit little-endian number at P.  */\n"
+           "GPERF_IMAGE_FUNCTION unsigned int\n"
+           "gperf_image_word (const unsigned char *p)\n"
+           "{\n"
+           "  return p[0] + p[1] * 0x100u + p[2] * 0x10000u + p[3] * 0x1000000u;\n"
+           "}\n"
+           "\n"
+           "/* Returns nonzero if COUNT elements of SIZE bytes at OFFSET fit into\n"
+           "   an image of IMAGE_SIZE bytes.  */\n"
+           "GPERF_IMAGE_FUNCTION int\n"
+           "gperf_image_fits (unsigned int offset, unsigned int count,\n"
+           "                  unsigned int size, size_t image_size)\n"
+           "{\n"
+           "  return offset <= image_size && count <= (image_size - offset) / size;\n"
+           "}\n"
+           "\n"
+           "/* Initializes IMAGE from the SIZE bytes at DATA, which must remain valid\n"
+           "   while IMAGE is in use.  Returns 0 upon success, or -1 if DATA does not\n"
+           "   contain a valid image.  */\n"
+           "GPERF_IMAGE_FUNCTION int\n"
+           "gperf_image_open (struct gperf_image *image, const void *data, size_t size)\n"
+           "{\n");
+  out.format ("  const unsigned char *p = %sdata%s;\n",
+              to_bytes_begin, cast_end);
+  out.put ("  const unsigned char *h = p + 8;\n"
+           "\n"
+           "  /* Leave no member uninitialized, even if DATA is rejected.  */\n"
+           "  memset (image, 0, sizeof (*image));\n"
+           "  if (!(size >= 80 && memcmp (p, \"\\211gpimg\\r\\n\", 8) == 0\n"
+           "        && gperf_image_word (h) == 1\n"
+           "        && gperf_image_word (h + 68) <= size))\n"
+           "    return -1;\n"
+           "  size = gperf_image_word (h + 68);\n"
+           "  image->flags = gperf_image_word (h + 4);\n"
+           "  image->count = gperf_image_word (h + 8);\n"
+           "  image->min_length = gperf_image_word (h + 12);\n"
+           "  image->max_length = gperf_image_word (h + 16);\n"
+           "  image->max_hash_value = gperf_image_word (h + 20);\n"
+           "  image->position_count = gperf_image_word (h + 24);\n"
+           "  image->asso_count = gperf_image_word (h + 36);\n"
+           "  image->pool_size = gperf_image_word (h + 64);\n"
+           "  if (!(image->max_hash_value < 0xffffffffu\n"
+           "        && gperf_image_fits (gperf_image_word (h + 28), image->position_count, 4, size)\n"
+           "        && gperf_image_fits (gperf_image_word (h + 32), image->position_count, 4, size)\n"
+           "        && gperf_image_fits (gperf_image_word (h + 40), image->asso_count, 4, size)\n"
+           "        && gperf_image_fits (gperf_image_word (h + 44), image->max_hash_value + 2, 4, size)\n"
+           "        && gperf_image_fits (gperf_image_word (h + 48), image->count, 4, size)\n"
+           "        && gperf_image_fits (gperf_image_word (h + 52), image->count, 4, size)\n"
+           "        && gperf_image_fits (gperf_image_word (h + 56), image->count, 8, size)\n"
+           "        && gperf_image_fits (gperf_image_word (h + 60), image->pool_size, 1, size)))\n"
+           "    return -1;\n"
+           "  image->positions = p + gperf_image_word (h + 28);\n"
+           "  image->alpha_inc = p + gperf_image_word (h + 32);\n"
+           "  image->asso_values = p + gperf_image_word (h + 40);\n"
+           "  image->buckets = p + gperf_image_word (h + 44);\n"
+           "  image->lengths = p + gperf_image_word (h + 48);\n"
+           "  image->words = p + gperf_image_word (h + 52);\n"
+           "  image->payloads = p + gperf_image_word (h + 56);\n");
+  out.format ("  image->pool = %sp + gperf_image_word (h + 60)%s;\n",
+              to_chars_begin, cast_end);
+  out.put ("  return 0;\n"
+           "}\n"
+           "\n"
+           "/* Looks up the LEN bytes at STR in IMAGE.  Returns the index of the\n"
+           "   keyword, or -1 if it is not in the image.  */\n"
+           "GPERF_IMAGE_FUNCTION long\n"
+           "gperf_image_lookup (const struct gperf_image *image, const char *str, size_t len)\n"
+           "{\n");
+  out.format ("  const unsigned char *s = %sstr%s;\n",
+              from_chars_begin, cast_end);
+  out.put ("  unsigned int hval = 0;\n"
+           "  unsigned int i;\n"
+           "  unsigned int end;\n"
+           "\n"
+           "  if (!(len >= image->min_length && len <= image->max_length))\n"
+           "    return -1;\n"
+           "  if (image->flags & 1)\n"
+           "    hval += len;\n"
+           "  for (i = 0; i < image->position_count; i++)\n"
+           "    {\n"
+           "      unsigned int pos = gperf_image_word (image->positions + 4 * i);\n"
+           "      unsigned int c;\n"
+           "      if (pos >= 0x80000000u)\n"
+           "        {\n"
+           "          /* A position counted from the end.  */\n"
+           "          unsigned int back = 0u - pos;\n"
+           "          if (back > len)\n"
+           "            continue;\n"
+           "          c = s[len - back];\n"
+           "        }\n"
+           "      else if (pos < len)\n"
+           "        c = s[pos] + gperf_image_word (image->alpha_inc + 4 * i);\n"
+           "      else\n"
+           "        continue;\n"
+           "      if (image->flags & 4)\n"
+           "        c &= 15;\n"
+           "      if (c >= image->asso_count)\n"
+           "        return -1;\n"
+           "      hval += gperf_image_word (image->asso_values + 4 * c);\n"
+           "    }\n"
+           "  if (hval > image->max_hash_value)\n"
+           "    return -1;\n"
+           "\n"
+           "  end = gperf_image_word (image->buckets + 4 * (hval + 1));\n"
+           "  if (end > image->count)\n"
+           "    return -1;\n"
+           "  for (i = gperf_image_word (image->buckets + 4 * hval); i < end; i++)\n"
+           "    if (gperf_image_word (image->lengths + 4 * i) == len)\n"
+           "      {\n"
+           "        unsigned int offset = gperf_image_word (image->words + 4 * i);\n"
+           "        if (offset <= image->pool_size && len <= image->pool_size - offset)\n"
+           "          {\n"
+           "            const unsigned char *w =\n");
+  out.format ("              %simage->pool + offset%s;\n",
+              from_chars_begin, cast_end);
+  out.put ("            size_t n;\n"
+           "            if (image->flags & 2)\n"
+           "              {\n"
+           "                /* Compare ignoring the case of ASCII letters.  */\n"
+           "                for (n = 0; n < len; n++)\n"
+           "                  {\n"
+           "                    unsigned char c1 = s[n];\n"
+           "                    unsigned char c2 = w[n];\n"
+           "                    if (c1 >= 'A' && c1 <= 'Z')\n"
+           "                      c1 += 'a' - 'A';\n"
+           "                    if (c2 >= 'A' && c2 <= 'Z')\n"
+           "                      c2 += 'a' - 'A';\n"
+           "                    if (c1 != c2)\n"
+           "                      break;\n"
+           "                  }\n"
+           "              }\n"
+           "            else\n"
+           "              n = (memcmp (s, w, len) == 0 ? len : 0);\n"
+           "            if (n == len)\n"
+           "              return i;\n"
+           "          }\n"
+           "      }\n"
+           "  return -1;\n"
+           "}\n"
+           "\n"
+           "/* Returns the keyword with the given INDEX, and stores its length in\n"
+           "   *LENGTHP.  */\n"
+           "GPERF_IMAGE_FUNCTION const char *\n"
+           "gperf_image_key (const struct gperf_image *image, long index, size_t *lengthp)\n"
+           "{\n"
+           "  *lengthp = gperf_image_word (image->lengths + 4 * index);\n"
+           "  return image->pool + gperf_image_word (image->words + 4 * index);\n"
+           "}\n"
+           "\n"
+           "/* Returns the payload of the keyword with the given INDEX, that is, the\n"
+           "   rest of its line in the input file when option -t was given, and\n"
+           "   stores its length in *LENGTHP.  */\n"
+           "GPERF_IMAGE_FUNCTION const char *\n"
+           "gperf_image_payload (const struct gperf_image *image, long index, size_t *lengthp)\n"
+           "{\n"
+           "  unsigned int offset = gperf_image_word (image->payloads + 8 * index);\n"
+           "  unsigned int length = gperf_image_word (image->payloads + 8 * index + 4);\n"
+           "  if (!(offset <= image->pool_size && length < image->pool_size - offset))\n"
+           "    {\n"
+           "      *lengthp = 0;\n"
+           "      return NULL;\n"
+           "    }\n"
+           "  *lengthp = length;\n"
+           "  return image->pool + offset;\n"
+           "}\n"
+           "\n"
+           "#endif\n");
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Generates a main program that measures the speed of the lookup function
+   on the words of a corpus file: the words in the set, the words not in the
+   set, and all words in their order in the file.  */
+
+void
+Output::output_benchmark () const
+{
+  /* Casts, in C or C++ syntax.  */
+  const char *to_chars_begin =
+    (option[CPLUSPLUS] ? "static_cast<char *>(" : "(char *) ");
+  const char *to_words_begin =
+    (option[CPLUSPLUS] ? "static_cast<struct gperf_bench_word *>(" : "(struct gperf_bench_word *) ");
+  const char *to_doubles_begin =
+    (option[CPLUSPLUS] ? "static_cast<double *>(" : "(double *) ");
+  const char *to_int_begin =
+    (option[CPLUSPLUS] ? "static_cast<int>(" : "(int) ");
+  const char *to_ulong_begin =
+    (option[CPLUSPLUS] ? "static_cast<unsigned long>(" : "(unsigned long) ");
+  const char *cast_end = (option[CPLUSPLUS] ? ")" : "");
+
+  out.put ("\n"
+           "/* Benchmark driver for the lookup function.\n"
+           "   Usage: PROGRAM CORPUS [RUNS]\n"
+           "   CORPUS contains one word per line.  The words that are in the set form\n"
+           "   the 'hits' workload, the other words the 'misses' workload, and all\n"
+           "   words in their order in CORPUS the 'mixed' workload.  If CORPUS contains\n"
+           "   no misses, they are derived from the hits by changing their first byte.\n"
+           "   Each workload is run GPERF_BENCH_WARMUP times without measurement, then\n"
+           "   RUNS times with measurement.  On Linux, the branch and cache misses are\n"
+           "   counted as well, if the kernel permits it and the compiler is not in\n"
+           "   strict ISO mode.  */\n"
+           "\n"
+           "#include <stdio.h>\n"
+           "#include <stdlib.h>\n"
+           "#include <string.h>\n"
+           "#include <time.h>\n"
+           "#if defined __linux__ && !defined __STRICT_ANSI__\n"
+           "#include <unistd.h>\n"
+           "#include <sys/ioctl.h>\n"
+           "#include <sys/syscall.h>\n"
+           "#include <linux/perf_event.h>\n"
+           "#define GPERF_BENCH_PERF 1\n"
+           "#endif\n"
+           "\n");
+  out.put ("#define GPERF_BENCH_LOOKUP(str, len) ");
+  if (option[CPLUSPLUS])
+    out.format ("%s::", option.get_class_name ());
+  out.format ("%s (str, len)\n", option.get_function_name ());
+  out.put ("#ifndef GPERF_BENCH_WARMUP\n"
+           "#define GPERF_BENCH_WARMUP 2\n"
+           "#endif\n"
+           "#ifndef GPERF_BENCH_RUNS\n"
+           "#define GPERF_BENCH_RUNS 7\n"
+           "#endif\n"
+           "/* Minimum number of lookups in a run.  Small workloads are repeated.  */\n"
+           "#ifndef GPERF_BENCH_MIN_LOOKUPS\n"
+           "#define GPERF_BENCH_MIN_LOOKUPS 1000000\n"
+           "#endif\n"
+           "\n"
+           "struct gperf_bench_word\n"
+           "{\n"
+           "  const char *str;\n"
+           "  size_t len;\n"
+           "};\n"
+           "\n"
+           "static volatile size_t gperf_bench_sink;\n"
+           "\n"
+           "/* Returns the time of a monotonic clock, in nanoseconds.  Falls back\n"
+           "   to the processor time where clock_gettime is not declared.  */\n"
+           "static double\n"
+           "gperf_bench_now (void)\n"
+           "{\n"
+           "#if defined CLOCK_MONOTONIC\n"
+           "  struct timespec ts;\n"
+           "  clock_gettime (CLOCK_MONOTONIC, &ts);\n"
+           "  return ts.tv_sec * 1e9 + ts.tv_nsec;\n"
+           "#else\n"
+           "  return clock () * (1e9 / CLOCKS_PER_SEC);\n"
+           "#endif\n"
+           "}\n"
+           "\n"
+           "#if GPERF_BENCH_PERF\n"
+           "/* Opens a hardware event counter for this thread, or returns -1.  */\n"
+           "static int\n"
+           "gperf_bench_perf_open (unsigned long long config)\n"
+           "{\n"
+           "  struct perf_event_attr attr;\n"
+           "  memset (&attr, 0, sizeof (attr));\n"
+           "  attr.type = PERF_TYPE_HARDWARE;\n"
+           "  attr.size = sizeof (attr);\n"
+           "  attr.config = config;\n"
+           "  attr.disabled = 1;\n"
+           "  attr.exclude_kernel = 1;\n"
+           "  attr.exclude_hv = 1;\n");
+  out.format ("  return %ssyscall (__NR_perf_event_open, &attr, 0, -1, -1, 0)%s;\n",
+              to_int_begin, cast_end);
+  out.put ("}\n"
+           "#endif\n"
+           "\n"
+           "/* Looks up the COUNT words REPS times.  Returns the number of hits.  */\n"
+           "static size_t\n"
+           "gperf_bench_pass (const struct gperf_bench_word *words, size_t count,\n"
+           "                  size_t reps)\n"
+           "{\n"
+           "  size_t found = 0;\n"
+           "  size_t r;\n"
+           "  size_t i;\n"
+           "  for (r = 0; r < reps; r++)\n"
+           "    for (i = 0; i < count; i++)\n"
+           "      if (GPERF_BENCH_LOOKUP (words[i].str, words[i].len))\n"
+           "        found++;\n"
+           "  return found;\n"
+           "}\n"
+           "\n"
+           "/* Measures a workload and prints a line of the report.  PERF_FDS holds\n"
+           "   the branch-misses and cache-misses counters, or -1.  */\n"
+           "static void\n"
+           "gperf_bench_run (const char *name, const struct gperf_bench_word *words,\n"
+           "                 size_t count, int runs, const int *perf_fds)\n"
+           "{\n"
+           "  size_t reps;\n"
+           "  double lookups;\n"
+           "  double *times;\n"
+           "  double events[2] = { 0, 0 };\n"
+           "  int run;\n"
+           "  int k;\n"
+           "\n"
+           "  if (count == 0)\n"
+           "    {\n"
+           "      printf (\"%-8s %10s\\n\", name, \"no words\");\n"
+           "      return;\n"
+           "    }\n"
+           "  reps = (GPERF_BENCH_MIN_LOOKUPS + count - 1) / count;\n"
+           "  lookups = reps;\n"
+           "  lookups *= count;\n"
+           "\n"
+           "  for (k = 0; k < GPERF_BENCH_WARMUP; k++)\n"
+           "    gperf_bench_sink += gperf_bench_pass (words, count, reps);\n"
+           "\n");
+  out.format ("  times = %smalloc (runs * sizeof (double))%s;\n",
+              to_doubles_begin, cast_end);
+  out.put ("  for (run = 0; run < runs; run++)\n"
+           "    {\n"
+           "      double start;\n"
+           "#if GPERF_BENCH_PERF\n"
+           "      for (k = 0; k < 2; k++)\n"
+           "        if (perf_fds[k] >= 0)\n"
+           "          {\n"
+           "            ioctl (perf_fds[k], PERF_EVENT_IOC_RESET, 0);\n"
+           "            ioctl (perf_fds[k], PERF_EVENT_IOC_ENABLE, 0);\n"
+           "          }\n"
+           "#endif\n"
+           "      start = gperf_bench_now ();\n"
+           "      gperf_bench_sink += gperf_bench_pass (words, count, reps);\n"
+           "      times[run] = (gperf_bench_now () - start) / lookups;\n"
+           "#if GPERF_BENCH_PERF\n"
+           "      for (k = 0; k < 2; k++)\n"
+           "        if (perf_fds[k] >= 0)\n"
+           "          {\n"
+           "            unsigned long long value;\n"
+           "            ioctl (perf_fds[k], PERF_EVENT_IOC_DISABLE, 0);\n"
+           "            if (read (perf_fds[k], &value, sizeof (value)) == sizeof (value))\n"
+           "              events[k] += value / lookups;\n"
+           "          }\n"
+           "#endif\n"
+           "    }\n"
+           "\n"
+           "  /* Sort the times, for the minimum and the median.  */\n"
+           "  for (run = 1; run < runs; run++)\n"
+           "    {\n"
+           "      double t = times[run];\n"
+           "      for (k = run; k > 0 && times[k - 1] > t; k--)\n"
+           "        times[k] = times[k - 1];\n"
+           "      times[k] = t;\n"
+           "    }\n"
+           "\n");
+  out.format ("  printf (\"%%-8s %%10lu %%10.2f %%10.2f\", name, %scount%s,\n"
+              "          times[0], times[runs / 2]);\n",
+              to_ulong_begin, cast_end);
+  out.put ("  for (k = 0; k < 2; k++)\n"
+           "    if (perf_fds[k] >= 0)\n"
+           "      printf (\" %12.4f\", events[k] / runs);\n"
+           "    else\n"
+           "      printf (\" %12s\", \"n/a\");\n"
+           "  printf (\"\\n\");\n"
+           "  free (times);\n"
+           "}\n"
+           "\n"
+           "int\n"
+           "main (int argc, char *argv[])\n"
+           "{\n"
+           "  FILE *fp;\n"
+           "  char *data;\n"
+           "  char *derived;\n"
+           "  long size;\n"
+           "  size_t length;\n"
+           "  size_t lines;\n"
+           "  size_t nmixed = 0;\n"
+           "  size_t nhits = 0;\n"
+           "  size_t nmisses = 0;\n"
+           "  struct gperf_bench_word *mixed;\n"
+           "  struct gperf_bench_word *hits;\n"
+           "  struct gperf_bench_word *misses;\n"
+           "  int perf_fds[2] = { -1, -1 };\n"
+           "  int runs = GPERF_BENCH_RUNS;\n"
+           "  char *p;\n"
+           "  char *end;\n"
+           "  size_t i;\n"
+           "\n"
+           "  if (argc < 2)\n"
+           "    {\n"
+           "      fprintf (stderr, \"Usage: %s CORPUS [RUNS]\\n\", argv[0]);\n"
+           "      return 1;\n"
+           "    }\n"
+           "  if (argc > 2 && atoi (argv[2]) > 0)\n"
+           "    runs = atoi (argv[2]);\n"
+           "\n"
+           "  /* Read the corpus.  */\n"
+           "  if ((fp = fopen (argv[1], \"rb\")) == NULL\n"
+           "      || fseek (fp, 0, SEEK_END) != 0 || (size = ftell (fp)) < 0\n"
+           "      || fseek (fp, 0, SEEK_SET) != 0)\n"
+           "    {\n"
+           "      fprintf (stderr, \"%s: cannot read %s\\n\", argv[0], argv[1]);\n"
+           "      return 1;\n"
+           "    }\n"
+           "  length = size;\n");
+  out.format ("  data = %smalloc (length + 1)%s;\n"
+              "  derived = %smalloc (length + 1)%s;\n",
+              to_chars_begin, cast_end, to_chars_begin, cast_end);
+  out.put ("  if (data == NULL || derived == NULL\n"
+           "      || fread (data, 1, length, fp) != length)\n"
+           "    {\n"
+           "      fprintf (stderr, \"%s: cannot read %s\\n\", argv[0], argv[1]);\n"
+           "      return 1;\n"
+           "    }\n"
+           "  fclose (fp);\n"
+           "  data[length] = '\\n';\n"
+           "\n"
+           "  /* Split it into lines.  */\n"
+           "  lines = 0;\n"
+           "  for (i = 0; i < length; i++)\n"
+           "    if (data[i] == '\\n')\n"
+           "      lines++;\n"
+           "  lines++;\n");
+  out.format ("  mixed = %smalloc (lines * sizeof (struct gperf_bench_word))%s;\n"
+              "  hits = %smalloc (lines * sizeof (struct gperf_bench_word))%s;\n"
+              "  misses = %smalloc (lines * sizeof (struct gperf_bench_word))%s;\n",
+              to_words_begin, cast_end, to_words_begin, cast_end,
+              to_words_begin, cast_end);
+  out.put ("  if (mixed == NULL || hits == NULL || misses == NULL)\n"
+           "    return 1;\n"
+           "  for (p = data, end = data + length; p < end; )\n"
+           "    {\n"
+           "      char *nl = p;\n"
+           "      struct gperf_bench_word word;\n"
+           "      while (*nl != '\\n')\n"
+           "        nl++;\n"
+           "      *nl = '\\0';\n"
+           "      word.str = p;\n"
+           "      word.len = nl - p;\n"
+           "      if (word.len > 0 && p[word.len - 1] == '\\r')\n"
+           "        p[--word.len] = '\\0';\n"
+           "      mixed[nmixed++] = word;\n"
+           "      if (GPERF_BENCH_LOOKUP (word.str, word.len))\n"
+           "        hits[nhits++] = word;\n"
+           "      else\n"
+           "        misses[nmisses++] = word;\n"
+           "      p = nl + 1;\n"
+           "    }\n"
+           "\n"
+           "  /* Derive misses from the hits, if the corpus has none.  */\n"
+           "  if (nmisses == 0)\n"
+           "    {\n"
+           "      char *q = derived;\n"
+           "      for (i = 0; i < nhits; i++)\n"
+           "        if (hits[i].len > 0)\n"
+           "          {\n"
+           "            memcpy (q, hits[i].str, hits[i].len);\n"
+           "            q[hits[i].len] = '\\0';\n"
+           "            q[0] ^= 0x20;\n"
+           "            if (!GPERF_BENCH_LOOKUP (q, hits[i].len))\n"
+           "              {\n"
+           "                misses[nmisses].str = q;\n"
+           "                misses[nmisses].len = hits[i].len;\n"
+           "                nmisses++;\n"
+           "                q += hits[i].len + 1;\n"
+           "              }\n"
+           "          }\n"
+           "    }\n"
+           "\n"
+           "#if GPERF_BENCH_PERF\n"
+           "  perf_fds[0] = gperf_bench_perf_open (PERF_COUNT_HW_BRANCH_MISSES);\n"
+           "  perf_fds[1] = gperf_bench_perf_open (PERF_COUNT_HW_CACHE_MISSES);\n"
+           "#endif\n"
+           "\n"
+           "  printf (\"%-8s %10s %10s %10s %12s %12s\\n\", \"workload\", \"words\",\n"
+           "          \"best ns\", \"median ns\", \"branch-miss\", \"cache-miss\");\n"
+           "  gperf_bench_run (\"hits\", hits, nhits, runs, perf_fds);\n"
+           "  gperf_bench_run (\"misses\", misses, nmisses, runs, perf_fds);\n"
+           "  gperf_bench_run (\"mixed\", mixed, nmixed, runs, perf_fds);\n"
+           "\n"
+           "#if GPERF_BENCH_PERF\n"
+           "  for (i = 0; i < 2; i++)\n"
+           "    if (perf_fds[i] >= 0)\n"
+           "      close (perf_fds[i]);\n"
+           "#endif\n"
+           "  free (mixed);\n"
+           "  free (hits);\n"
+           "  free (misses);\n"
+           "  free (derived);\n"
+           "  free (data);\n"
+           "  return 0;\n"
+           "}\n");
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Outputs the C code from the declarations section, the struct type
+   declaration, and the #includes that the tables need.  */
+
+void
+Output::output_declarations () const
+{
+  if (_verbatim_declarations < _verbatim_declarations_end)
+    {
+      output_line_directive (_verbatim_declarations_lineno);
+      out.put (_verbatim_declarations,
+               _verbatim_declarations_end - _verbatim_declarations);
+    }
+
+  if (option[TYPE] && !option[NOTYPE]) /* Output type declaration now, reference it later on.... */
+    {
+      output_line_directive (_struct_decl_lineno);
+      out.format ("%s\n", _struct_decl);
+    }
+
+  if (option[INCLUDE])
+    out.put ("#include <string.h>\n"); /* Declare strlen(), strcmp(), strncmp(). */
+}
+
+/* Returns the name of the file that holds the given shard (counted from 1)
+   of the tables: the output file name, with "-N" inserted before its
+   extension.  */
+
+static char *
+shard_file_name (int shard)
+{
+  char suffix[16];
+  sprintf (suffix, "-%d", shard);
+  return derived_file_name (suffix, NULL);
+}
+
+/* Writes each shard of the tables to its own file, so that huge tables can
+   be compiled in parallel and with bounded memory.  */
+
+void
+Output::output_shards () const
+{
+  int shards = option.get_shards ();
+
+  for (int k = 1; k <= shards; k++)
+    {
+      char *file_name = shard_file_name (k);
+      FILE *stream = fopen (file_name, "w");
+      if (stream == NULL)
+        {
+          fprintf (stderr, "Cannot open output file '%s'\n", file_name);
+          exit (1);
+        }
+      out.set_stream (stream);
+
+      out.format ("/* Tables for %s, shard %d of %d, produced by gperf version %s */\n",
+                  option.get_output_file_name (), k, shards, version_string);
+      option.print_options (out);
+      out.put ("\n");
+      output_declarations ();
+      out.put ("\n");
+      if (option[LENTABLE])
+        output_keylength_table_shard (k);
+      if (option[SHAREDLIB])
+        output_string_pool_shard (k);
+      output_keyword_table_shard (k);
+
+      out.set_stream (stdout);
+      if (ferror (stream) | fclose (stream))
+        {
+          fprintf (stderr, "error while writing output file '%s'\n",
+                   file_name);
+          exit (1);
+        }
+      delete[] file_name;
+    }
 }
 
 /* ------------------------------------------------------------------------- */
@@ -2052,6 +4441,38 @@ Output::output ()
 {
   compute_min_max ();
 
+  stats._total_keys = _total_keys;
+  stats._total_duplicates = _total_duplicates;
+  stats._key_positions =
+    (_key_positions.is_useall () ? -1 : _key_positions.get_size ());
+  stats._asso_values_size = (_alpha_reduced ? 16 : _alpha_size);
+  stats._min_hash_value = _min_hash_value;
+  stats._max_hash_value = _max_hash_value;
+
+  if (option.get_shards () > 1 && !option.get_image_file_name ())
+    compute_shards ();
+  if ((option[INCBIN] || option[EMBED]) && !option.get_image_file_name ())
+    compute_binary_tables ();
+  /* The lookup template of --traits has no prefilter.  */
+  if (option.get_prefilter_bits () > 0 && !option[TRAITS]
+      && !option.get_image_file_name ())
+    compute_prefilter ();
+
+  if (option.get_lookup_template_file_name () != NULL)
+    output_lookup_template ();
+
+  if (option[SIMD] && !option.get_image_file_name ())
+    {
+      int simd_first;
+      int simd_count;
+      find_simd_run (simd_first, simd_count);
+      if (option[CPLUSPLUS17])
+        fprintf (stderr, "warning, --simd has no effect with --language=C++17, ignoring it\n");
+      else if (simd_count == 0)
+        fprintf (stderr, "warning, --simd has no effect: no run of %d consecutive key positions lies within the shortest keyword\n",
+                 SIMD_LANES);
+    }
+
   if (option[CPLUSPLUS])
     /* The 'register' keyword is removed from C++17.
        See http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2015/n4340  */
@@ -2059,11 +4480,16 @@ Output::output ()
   else
     register_scs = "register ";
 
+  constexpr_scs = (option[CPLUSPLUS17] ? "constexpr " : "");
+
   if (option[C] | option[ANSIC] | option[CPLUSPLUS])
     {
       const_always = "const ";
-      const_readonly_array = (option[CONST] ? "const " : "");
-      const_for_struct = ((option[CONST] && option[TYPE]) ? "const " : "");
+      /* constexpr tables are implicitly const.  */
+      const_readonly_array =
+        (option[CONST] || option[CPLUSPLUS17] ? "const " : "");
+      const_for_struct =
+        ((option[CONST] || option[CPLUSPLUS17]) && option[TYPE] ? "const " : "");
     }
   else
     {
@@ -2080,74 +4506,100 @@ Output::output ()
 
   _wordlist_eltype = (option[SHAREDLIB] && !option[TYPE] ? "int" : _struct_tag);
 
-  printf ("/* ");
+  out.put ("/* ");
   if (option[KRC])
-    printf ("KR-C");
+    out.put ("KR-C");
   else if (option[C])
-    printf ("C");
+    out.put ("C");
   else if (option[ANSIC])
-    printf ("ANSI-C");
+    out.put ("ANSI-C");
+  else if (option[CPLUSPLUS17])
+    out.put ("C++17");
   else if (option[CPLUSPLUS])
-    printf ("C++");
-  printf (" code produced by gperf version %s */\n", version_string);
-  option.print_options ();
-  printf ("\n");
+    out.put ("C++");
+  out.format (" code produced by gperf version %s */\n", version_string);
+  option.print_options (out);
+  out.put ("\n");
   if (!option[POSITIONS])
     {
-      printf ("/* Computed positions: -k'");
-      _key_positions.print();
-      printf ("' */\n");
+      out.put ("/* Computed positions: -k'");
+      _key_positions.print (out);
+      out.put ("' */\n");
+    }
+  out.put ("\n");
+
+  if (option.get_image_file_name ())
+    {
+      output_image ();
+      output_image_loader ();
+      out.flush ();
+      return;
     }
-  printf ("\n");
 
   if (_charset_dependent
       && (_key_positions.get_size() > 0 || option[UPPERLOWER]))
     {
       /* The generated tables assume that the execution character set is
          based on ISO-646, not EBCDIC.  */
-      printf ("#if !((' ' == 32) && ('!' == 33) && ('\"' == 34) && ('#' == 35) \\\n"
-              "      && ('%%' == 37) && ('&' == 38) && ('\\'' == 39) && ('(' == 40) \\\n"
-              "      && (')' == 41) && ('*' == 42) && ('+' == 43) && (',' == 44) \\\n"
-              "      && ('-' == 45) && ('.' == 46) && ('/' == 47) && ('0' == 48) \\\n"
-              "      && ('1' == 49) && ('2' == 50) && ('3' == 51) && ('4' == 52) \\\n"
-              "      && ('5' == 53) && ('6' == 54) && ('7' == 55) && ('8' == 56) \\\n"
-              "      && ('9' == 57) && (':' == 58) && (';' == 59) && ('<' == 60) \\\n"
-              "      && ('=' == 61) && ('>' == 62) && ('?' == 63) && ('A' == 65) \\\n"
-              "      && ('B' == 66) && ('C' == 67) && ('D' == 68) && ('E' == 69) \\\n"
-              "      && ('F' == 70) && ('G' == 71) && ('H' == 72) && ('I' == 73) \\\n"
-              "      && ('J' == 74) && ('K' == 75) && ('L' == 76) && ('M' == 77) \\\n"
-              "      && ('N' == 78) && ('O' == 79) && ('P' == 80) && ('Q' == 81) \\\n"
-              "      && ('R' == 82) && ('S' == 83) && ('T' == 84) && ('U' == 85) \\\n"
-              "      && ('V' == 86) && ('W' == 87) && ('X' == 88) && ('Y' == 89) \\\n"
-              "      && ('Z' == 90) && ('[' == 91) && ('\\\\' == 92) && (']' == 93) \\\n"
-              "      && ('^' == 94) && ('_' == 95) && ('a' == 97) && ('b' == 98) \\\n"
-              "      && ('c' == 99) && ('d' == 100) && ('e' == 101) && ('f' == 102) \\\n"
-              "      && ('g' == 103) && ('h' == 104) && ('i' == 105) && ('j' == 106) \\\n"
-              "      && ('k' == 107) && ('l' == 108) && ('m' == 109) && ('n' == 110) \\\n"
-              "      && ('o' == 111) && ('p' == 112) && ('q' == 113) && ('r' == 114) \\\n"
-              "      && ('s' == 115) && ('t' == 116) && ('u' == 117) && ('v' == 118) \\\n"
-              "      && ('w' == 119) && ('x' == 120) && ('y' == 121) && ('z' == 122) \\\n"
-              "      && ('{' == 123) && ('|' == 124) && ('}' == 125) && ('~' == 126))\n"
-              "/* The character set is not based on ISO-646.  */\n");
-      printf ("%s \"gperf generated tables don't work with this execution character set. Please report a bug to <bug-gperf@gnu.org>.\"\n", option[KRC] || option[C] ? "error" : "#error");
-      printf ("#endif\n\n");
+      out.format ("#if !((' ' == 32) && ('!' == 33) && ('\"' == 34) && ('#' == 35) \\\n"
+                  "      && ('%%' == 37) && ('&' == 38) && ('\\'' == 39) && ('(' == 40) \\\n"
+                  "      && (')' == 41) && ('*' == 42) && ('+' == 43) && (',' == 44) \\\n"
+                  "      && ('-' == 45) && ('.' == 46) && ('/' == 47) && ('0' == 48) \\\n"
+                  "      && ('1' == 49) && ('2' == 50) && ('3' == 51) && ('4' == 52) \\\n"
+                  "      && ('5' == 53) && ('6' == 54) && ('7' == 55) && ('8' == 56) \\\n"
+                  "      && ('9' == 57) && (':' == 58) && (';' == 59) && ('<' == 60) \\\n"
+                  "      && ('=' == 61) && ('>' == 62) && ('?' == 63) && ('A' == 65) \\\n"
+                  "      && ('B' == 66) && ('C' == 67) && ('D' == 68) && ('E' == 69) \\\n"
+                  "      && ('F' == 70) && ('G' == 71) && ('H' == 72) && ('I' == 73) \\\n"
+                  "      && ('J' == 74) && ('K' == 75) && ('L' == 76) && ('M' == 77) \\\n"
+                  "      && ('N' == 78) && ('O' == 79) && ('P' == 80) && ('Q' == 81) \\\n"
+                  "      && ('R' == 82) && ('S' == 83) && ('T' == 84) && ('U' == 85) \\\n"
+                  "      && ('V' == 86) && ('W' == 87) && ('X' == 88) && ('Y' == 89) \\\n"
+                  "      && ('Z' == 90) && ('[' == 91) && ('\\\\' == 92) && (']' == 93) \\\n"
+                  "      && ('^' == 94) && ('_' == 95) && ('a' == 97) && ('b' == 98) \\\n"
+                  "      && ('c' == 99) && ('d' == 100) && ('e' == 101) && ('f' == 102) \\\n"
+                  "      && ('g' == 103) && ('h' == 104) && ('i' == 105) && ('j' == 106) \\\n"
+                  "      && ('k' == 107) && ('l' == 108) && ('m' == 109) && ('n' == 110) \\\n"
+                  "      && ('o' == 111) && ('p' == 112) && ('q' == 113) && ('r' == 114) \\\n"
+                  "      && ('s' == 115) && ('t' == 116) && ('u' == 117) && ('v' == 118) \\\n"
+                  "      && ('w' == 119) && ('x' == 120) && ('y' == 121) && ('z' == 122) \\\n"
+                  "      && ('{' == 123) && ('|' == 124) && ('}' == 125) && ('~' == 126))\n"
+                  "/* The character set is not based on ISO-646.  */\n");
+      out.format ("%s \"gperf generated tables don't work with this execution character set. Please report a bug to <bug-gperf@gnu.org>.\"\n", option[KRC] || option[C] ? "error" : "#error");
+      out.put ("#endif\n\n");
     }
 
-  if (_verbatim_declarations < _verbatim_declarations_end)
+  output_declarations ();
+  if (option[TRAITS])
+    out.put ("#include <cstddef>\n"); /* Declare std::size_t. */
+  if (option[CPLUSPLUS17])
+    out.put ("#include <string_view>\n"); /* Declare std::string_view, std::char_traits. */
+  else if (option[CPLUSPLUS] && option[STRINGVIEW])
+    out.put ("#if __cplusplus >= 201703L\n"
+             "#include <string_view>\n"
+             "#endif\n");
+
+  if (option[TRAITS])
     {
-      output_line_directive (_verbatim_declarations_lineno);
-      fwrite (_verbatim_declarations, 1,
-              _verbatim_declarations_end - _verbatim_declarations, stdout);
-    }
+      /* The constants are members of the traits class.  */
+      out.format ("/* maximum key range = %d, duplicates = %d */\n\n",
+                  _max_hash_value - _min_hash_value + 1, _total_duplicates);
 
-  if (option[TYPE] && !option[NOTYPE]) /* Output type declaration now, reference it later on.... */
-    {
-      output_line_directive (_struct_decl_lineno);
-      printf ("%s\n", _struct_decl);
-    }
+      output_lookup_template_include ();
+      output_traits ();
 
-  if (option[INCLUDE])
-    printf ("#include <string.h>\n"); /* Declare strlen(), strcmp(), strncmp(). */
+      if (_verbatim_code < _verbatim_code_end)
+        {
+          output_line_directive (_verbatim_code_lineno);
+          out.put (_verbatim_code, _verbatim_code_end - _verbatim_code);
+        }
+
+      if (option[BENCHMARK])
+        output_benchmark ();
+
+      out.flush ();
+      return;
+    }
 
   if (!option[ENUM])
     {
@@ -2160,8 +4612,8 @@ Output::output ()
       output_constants (style);
     }
 
-  printf ("/* maximum key range = %d, duplicates = %d */\n\n",
-          _max_hash_value - _min_hash_value + 1, _total_duplicates);
+  out.format ("/* maximum key range = %d, duplicates = %d */\n\n",
+              _max_hash_value - _min_hash_value + 1, _total_duplicates);
 
   if (option[UPPERLOWER])
     {
@@ -2173,39 +4625,90 @@ Output::output ()
         output_upperlower_memcmp ();
       else
         {
-          if (option[COMP])
+          if (option[COMP] || option[CPLUSPLUS17])
             output_upperlower_strncmp ();
           else
             output_upperlower_strcmp ();
         }
     }
 
-  if (option[CPLUSPLUS])
-    printf ("class %s\n"
-            "{\n"
-            "private:\n"
-            "  static inline unsigned int %s (const char *str, size_t len);\n"
-            "public:\n"
-            "  static %s%s%s (const char *str, size_t len);\n"
-            "};\n"
-            "\n",
-            option.get_class_name (), option.get_hash_name (),
-            const_for_struct, _return_type, option.get_function_name ());
+  if (option[CPLUSPLUS17])
+    {
+      /* The tables are class members, because constexpr functions cannot
+         have static local variables.  Static constexpr data members are
+         implicitly inline.  */
+      out.format ("class %s\n"
+                  "{\n"
+                  "private:\n",
+                  option.get_class_name ());
+      output_asso_values_table ();
+      if (_key_positions.get_size() > 0)
+        out.put ("\n");
+      output_lookup_tables ();
+      out.format ("  static constexpr unsigned int %s (const char *str, size_t len);\n"
+                  "public:\n"
+                  "  static constexpr %s%s%s (const char *str, size_t len);\n"
+                  "  static constexpr %s%s%s (std::string_view str);\n"
+                  "};\n"
+                  "\n",
+                  option.get_hash_name (),
+                  const_for_struct, _return_type, option.get_function_name (),
+                  const_for_struct, _return_type, option.get_function_name ());
+    }
+  else if (option[CPLUSPLUS])
+    {
+      out.format ("class %s\n"
+                  "{\n"
+                  "private:\n"
+                  "  static inline unsigned int %s (const char *str, size_t len);\n"
+                  "public:\n"
+                  "  static %s%s%s (const char *str, size_t len);\n",
+                  option.get_class_name (), option.get_hash_name (),
+                  const_for_struct, _return_type, option.get_function_name ());
+      if (option[STRINGVIEW])
+        out.format ("#if __cplusplus >= 201703L\n"
+                    "  static %s%s%s (std::string_view str)\n"
+                    "  {\n"
+                    "    return %s (str.data (), str.size ());\n"
+                    "  }\n"
+                    "#endif\n",
+                    const_for_struct, _return_type, option.get_function_name (),
+                    option.get_function_name ());
+      out.put ("};\n"
+               "\n");
+    }
+
+  if (option[INCBIN])
+    output_binary_table_declarations ();
 
   output_hash_function ();
 
-  if (option[SHAREDLIB] && (option[GLOBAL] || option[TYPE]))
-    output_lookup_pools ();
-  if (option[GLOBAL])
-    output_lookup_tables ();
+  if (!option[CPLUSPLUS17])
+    {
+      if (option[SHAREDLIB] && (option[GLOBAL] || option[TYPE] || _shard_size > 0))
+        output_lookup_pools ();
+      if (option[GLOBAL])
+        output_lookup_tables ();
+    }
 
   output_lookup_function ();
 
   if (_verbatim_code < _verbatim_code_end)
     {
       output_line_directive (_verbatim_code_lineno);
-      fwrite (_verbatim_code, 1, _verbatim_code_end - _verbatim_code, stdout);
+      out.put (_verbatim_code, _verbatim_code_end - _verbatim_code);
     }
 
-  fflush (stdout);
+  if (option[BENCHMARK])
+    output_benchmark ();
+
+  out.flush ();
+
+  if (_shard_size > 0)
+    {
+      output_shards ();
+      delete[] _table;
+      delete[] _table_duplicates;
+    }
+  delete[] _pool_offsets;
 }
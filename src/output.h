@@ -54,6 +54,7 @@ public:
                                 const unsigned int *alpha_inc,
                                 int total_duplicates,
                                 unsigned int alpha_size,
+                                bool alpha_reduced,
                                 const int *asso_values);
 
   /* Generates the hash function and the key word recognizer function.  */
@@ -68,15 +69,54 @@ private:
   /* Returns the number of different hash values.  */
   int                   num_hash_values () const;
 
+  /* Assigns the indices in the keyword table, and divides it into
+     shards.  */
+  void                  compute_shards ();
+
+  /* Writes the string pool and the length table to binary files.  */
+  void                  compute_binary_tables ();
+
+  /* Fills the Bloom filter that the lookup function checks before the hash
+     function.  */
+  void                  compute_prefilter ();
+
+  /* Returns the range of keyword table indices that a shard holds.  */
+  void                  shard_range (int shard, int& start, int& end) const;
+
   /* Outputs the maximum and minimum hash values etc.  */
   void                  output_constants (struct Output_Constants&) const;
 
+  /* Outputs the C code from the declarations section, the struct type
+     declaration, and the #includes.  */
+  void                  output_declarations () const;
+
   /* Generates a C expression for an asso_values[] index.  */
   void                  output_asso_values_index (int pos) const;
 
   /* Generates a C expression for an asso_values[] reference.  */
   void                  output_asso_values_ref (int pos) const;
 
+  /* Generates a C expression for the hash function's term of a key
+     position.  It is 0 for the strings that are too short to have a
+     position counted from the end.  */
+  void                  output_asso_values_term (int pos) const;
+
+  /* Determines the run of consecutive key positions that the hash function
+     sums up with SIMD instructions.  */
+  void                  find_simd_run (int& first, int& count) const;
+
+  /* Returns true if the SIMD code looks up the asso_values[] with a byte
+     shuffle instead of a gather instruction.  */
+  bool                  simd_uses_shuffle () const;
+
+  /* Generates C code that adds the asso_values[] of a run of consecutive
+     key positions to hval, with SIMD instructions and a portable
+     fallback.  */
+  void                  output_asso_values_simd (int first, int count) const;
+
+  /* Prints out the asso_values array, for use in the hash function.  */
+  void                  output_asso_values_table () const;
+
   /* Generates C code for the hash function that returns the
      proper encoding for each keyword.  */
   void                  output_hash_function () const;
@@ -102,12 +142,67 @@ private:
   /* Generate all the tables needed for the lookup function.  */
   void                  output_lookup_tables () const;
 
+  /* Prints out the Bloom filter of the lookup function.  */
+  void                  output_prefilter_table () const;
+
+  /* Generates C code that returns from the lookup function if the Bloom
+     filter rejects the string.  */
+  void                  output_prefilter_check () const;
+
+  /* Prints out the declarations of the string pool shards.  */
+  void                  output_pool_shard_declarations () const;
+
+  /* Prints out the declarations of the keyword and length table shards.  */
+  void                  output_table_shard_declarations () const;
+
+  /* Prints out the part of the length table that a shard holds.  */
+  void                  output_keylength_table_shard (int shard) const;
+
+  /* Prints out the part of the string pool that a shard holds.  */
+  void                  output_string_pool_shard (int shard) const;
+
+  /* Prints out the part of the keyword table that a shard holds.  */
+  void                  output_keyword_table_shard (int shard) const;
+
+  /* Writes each shard of the tables to its own file.  */
+  void                  output_shards () const;
+
+  /* Prints out the declarations of the tables in binary files.  */
+  void                  output_binary_table_declarations () const;
+
+  /* Generates a reference to an element of a keyword or length table.  */
+  void                  output_table_ref (const char *name, const char *index) const;
+
+  /* Generates the addition of the string pool for a keyword table
+     element.  */
+  void                  output_pool_ref (const char *index) const;
+
   /* Generates C code to perform the keyword lookup.  */
   void                  output_lookup_function_body (const struct Output_Compare&) const;
 
   /* Generates C code for the lookup function.  */
   void                  output_lookup_function () const;
 
+  /* Writes the C++17 lookup template that is shared among all tables to
+     the file given by --lookup-template.  */
+  void                  output_lookup_template () const;
+
+  /* Generates the #include of the lookup template.  */
+  void                  output_lookup_template_include () const;
+
+  /* Generates the traits class that specializes the lookup template.  */
+  void                  output_traits () const;
+
+  /* Writes the tables to the file given by --output-image.  */
+  void                  output_image () const;
+
+  /* Generates the reference loader for the binary images.  */
+  void                  output_image_loader () const;
+
+  /* Generates a main program that measures the speed of the lookup
+     function.  */
+  void                  output_benchmark () const;
+
   /* Linked list of keywords.  */
   KeywordExt_List *     _head;
 
@@ -151,8 +246,30 @@ private:
   int                   _max_hash_value;
   /* Size of alphabet. */
   unsigned int const    _alpha_size;
+  /* Whether asso_values[] is indexed by the byte values mod 16.  */
+  bool const            _alpha_reduced;
   /* Value associated with each character. */
   const int * const     _asso_values;
+  /* Size of the keyword table, when it is divided into shards.  */
+  int                   _table_size;
+  /* Number of keyword table elements per shard, or 0 if the tables are not
+     divided into shards.  */
+  int                   _shard_size;
+  /* The keyword table elements, NULL for blank elements, when the tables
+     are divided into shards.  */
+  KeywordExt **         _table;
+  /* Whether each keyword table element continues a duplicate set.  */
+  bool *                _table_duplicates;
+  /* Whether the length table is in a binary file.  */
+  bool                  _binary_lengthtable;
+  /* Offsets of the strings in the binary string pool file, indexed like
+     the members of the string pool struct, or NULL if the string pool is
+     not in a binary file.  */
+  int *                 _pool_offsets;
+  /* The Bloom filter that the lookup function checks before the hash
+     function, or NULL, and its size in bits.  */
+  unsigned char *       _prefilter;
+  unsigned int          _prefilter_size;
 };
 
 #endif
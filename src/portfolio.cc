@@ -0,0 +1,361 @@
+/* Portfolio search: several searches with different settings.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of GNU GPERF.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Specification. */
+#include "portfolio.h"
+
+#include <stdio.h>
+#include <time.h> /* declares time() */
+#include "options.h"
+
+/* The state of an entry.  */
+enum Portfolio_State
+{
+  /* Not yet finished.  */
+  ENTRY_PENDING,
+  /* Finished, with a result.  */
+  ENTRY_DONE,
+  /* Stopped without a result.  */
+  ENTRY_STOPPED
+};
+
+/* One search of a portfolio.  It is the monitor of its search.  */
+struct Portfolio_Entry : public Search_Monitor
+{
+  virtual bool          stop (const Search *search, int max_hash_value_bound);
+
+  /* Measures the properties of the search that don't depend on the
+     asso_values[].  */
+  void                  measure (const Search *search);
+
+  /* The portfolio.  */
+  Portfolio *           _owner;
+  /* The index of this entry.  */
+  unsigned int          _index;
+  /* The settings of the search.  */
+  Search_Settings       _settings;
+  /* Whether _positions and _selchars are known.  */
+  bool                  _measured;
+  /* Number of key positions used by the hash function.  */
+  int                   _positions;
+  /* Average number of characters that the hash function adds.  */
+  double                _selchars;
+  /* The state, and the maximum hash value when done.  */
+  Portfolio_State       _state;
+  int                   _max_hash_value;
+};
+
+void
+Portfolio_Entry::measure (const Search *search)
+{
+  _positions = (search->_key_positions.is_useall ()
+                ? search->_max_key_len
+                : static_cast<int>(search->_key_positions.get_size ()));
+  int count = 0;
+  int total = 0;
+  for (KeywordExt_List *ptr = search->_head; ptr; ptr = ptr->rest())
+    {
+      count++;
+      total += ptr->first()->_selchars_length;
+    }
+  _selchars = (count > 0 ? static_cast<double>(total) / count : 0.0);
+  _measured = true;
+}
+
+bool
+Portfolio_Entry::stop (const Search *search, int max_hash_value_bound)
+{
+  if (!_measured)
+    measure (search);
+
+  double key[2];
+  _owner->objective (this, search, max_hash_value_bound, key);
+  _owner->lock ();
+  bool result = _owner->worse_than_best (key, _index);
+  _owner->unlock ();
+  return result;
+}
+
+/* ------------------------------------------------------------------------- */
+
+Portfolio::Portfolio (KeywordExt_List *list)
+  : _list (list), _next (0)
+{
+  Search_Settings base;
+
+  /* When random numbers are used, all searches use the same seed, so that
+     the best search can be repeated.  */
+  if (base._seed < 0 && (option[RANDOM] || option.get_jump () == 0))
+    base._seed = static_cast<int>(time (0) & 0x7fffffff);
+  base._threads = 1;
+
+  /* The variants of the key positions: the given ones, the computed ones,
+     all characters.  */
+  Search_Settings positions_variants[3];
+  unsigned int positions_count = 0;
+  if (base._positions_given)
+    positions_variants[positions_count++] = base;
+  positions_variants[positions_count] = base;
+  positions_variants[positions_count]._positions_given = false;
+  positions_count++;
+  if (!(base._positions_given && base._key_positions.is_useall ()))
+    {
+      positions_variants[positions_count] = base;
+      positions_variants[positions_count]._positions_given = true;
+      positions_variants[positions_count]._key_positions.set_useall (true);
+      positions_count++;
+    }
+
+  /* The size multiples: the given one, half of it, twice it.  */
+  static const float size_factors[3] = { 1.0f, 0.5f, 2.0f };
+
+  _count = positions_count * 2 * 3;
+  _entries = new Portfolio_Entry[_count];
+  unsigned int i = 0;
+  for (unsigned int p = 0; p < positions_count; p++)
+    for (unsigned int l = 0; l < 2; l++)
+      for (unsigned int s = 0; s < 3; s++)
+        {
+          Portfolio_Entry *entry = &_entries[i];
+          entry->_owner = this;
+          entry->_index = i;
+          entry->_settings = positions_variants[p];
+          if (l > 0)
+            entry->_settings._no_length = !base._no_length;
+          entry->_settings._size_multiple = base._size_multiple * size_factors[s];
+          entry->_measured = false;
+          entry->_positions = 0;
+          entry->_selchars = 0.0;
+          entry->_state = ENTRY_PENDING;
+          entry->_max_hash_value = 0;
+          i++;
+        }
+
+  _best = _count;
+  _best_key[0] = _best_key[1] = 0.0;
+#if HAVE_PTHREAD
+  pthread_mutex_init (&_lock, NULL);
+#endif
+}
+
+Portfolio::~Portfolio ()
+{
+#if HAVE_PTHREAD
+  pthread_mutex_destroy (&_lock);
+#endif
+  delete[] _entries;
+}
+
+void
+Portfolio::lock ()
+{
+#if HAVE_PTHREAD
+  pthread_mutex_lock (&_lock);
+#endif
+}
+
+void
+Portfolio::unlock ()
+{
+#if HAVE_PTHREAD
+  pthread_mutex_unlock (&_lock);
+#endif
+}
+
+/* The objectives, for a table of TABLE_SIZE entries:
+     size        the table size, then the number of characters added,
+     positions   the number of key positions, then the table size,
+     cost        the lookup cost of the Cost_Model, then the table size.
+   All of them grow with the maximum hash value, so that they can be
+   computed for a lower bound of it.  */
+
+void
+Portfolio::objective (const Portfolio_Entry *entry, const Search *search, int max_hash_value, double key[2]) const
+{
+  double table_size = max_hash_value + 1;
+  switch (option.get_portfolio ())
+    {
+    case PORTFOLIO_POSITIONS:
+      key[0] = entry->_positions;
+      key[1] = table_size;
+      break;
+    case PORTFOLIO_COST:
+      key[0] = search->estimate_cost (max_hash_value)._total;
+      key[1] = table_size;
+      break;
+    default:
+      key[0] = table_size;
+      key[1] = entry->_selchars;
+      break;
+    }
+}
+
+bool
+Portfolio::worse_than_best (const double key[2], unsigned int index) const
+{
+  if (_best == _count)
+    return false;
+  if (key[0] != _best_key[0])
+    return key[0] > _best_key[0];
+  if (key[1] != _best_key[1])
+    return key[1] > _best_key[1];
+  return index > _best;
+}
+
+void
+Portfolio::run_entry (unsigned int index)
+{
+  Portfolio_Entry *entry = &_entries[index];
+
+  /* The search reorders the keyword list and modifies the keywords.
+     Therefore it works on copies.  */
+  KeywordExt_List *list = NULL;
+  KeywordExt_List **tail = &list;
+  for (KeywordExt_List *ptr = _list; ptr; ptr = ptr->rest())
+    {
+      KeywordExt *keyword = ptr->first();
+      *tail = new KeywordExt_List (new KeywordExt (keyword->_allchars,
+                                                   keyword->_allchars_length,
+                                                   keyword->_rest,
+                                                   keyword->_lineno));
+      tail = &(*tail)->rest();
+    }
+
+  {
+    Search search (list, entry->_settings);
+    search.set_monitor (entry);
+    search.optimize ();
+    list = search._head;
+
+    lock ();
+    if (search.was_stopped ())
+      entry->_state = ENTRY_STOPPED;
+    else
+      {
+        int max_hash_value = 0;
+        for (KeywordExt_List *ptr = list; ptr; ptr = ptr->rest())
+          if (max_hash_value < ptr->first()->_hash_value)
+            max_hash_value = ptr->first()->_hash_value;
+        entry->_state = ENTRY_DONE;
+        entry->_max_hash_value = max_hash_value;
+
+        double key[2];
+        objective (entry, &search, max_hash_value, key);
+        if (!worse_than_best (key, index))
+          {
+            _best = index;
+            _best_key[0] = key[0];
+            _best_key[1] = key[1];
+          }
+      }
+    unlock ();
+  }
+
+  for (KeywordExt_List *ptr = list; ptr; ptr = ptr->rest())
+    {
+      KeywordExt *keyword = ptr->first();
+      do
+        {
+          KeywordExt *next_keyword = keyword->_duplicate_link;
+          delete[] const_cast<unsigned int *>(keyword->_selchars);
+          delete keyword;
+          keyword = next_keyword;
+        }
+      while (keyword != NULL);
+    }
+  delete_list (list);
+}
+
+void *
+Portfolio::run_entries (void *arg)
+{
+  Portfolio *portfolio = static_cast<Portfolio *>(arg);
+  for (;;)
+    {
+      portfolio->lock ();
+      unsigned int index = portfolio->_next;
+      if (index < portfolio->_count)
+        portfolio->_next++;
+      portfolio->unlock ();
+      if (index >= portfolio->_count)
+        break;
+      portfolio->run_entry (index);
+    }
+  return NULL;
+}
+
+/* Runs the searches.  Since a search is stopped only when it is worse than
+   a finished one, and ties go to the lower index, the best search does not
+   depend on the order in which the searches finish.  */
+
+Search_Settings
+Portfolio::run ()
+{
+  /* With -d, run the searches one after the other, so that their debugging
+     output is not interleaved.  */
+  int thread_count = (option[DEBUG] ? 1 : option.get_threads ());
+  if (thread_count > static_cast<int>(_count))
+    thread_count = _count;
+#if HAVE_PTHREAD
+  if (thread_count > 1)
+    {
+      pthread_t *threads = new pthread_t[thread_count];
+      bool *started = new bool[thread_count];
+      for (int t = 1; t < thread_count; t++)
+        started[t] =
+          (pthread_create (&threads[t], NULL, run_entries, this) == 0);
+      run_entries (this);
+      for (int t = 1; t < thread_count; t++)
+        if (started[t])
+          pthread_join (threads[t], NULL);
+      delete[] started;
+      delete[] threads;
+    }
+  else
+#endif
+    run_entries (this);
+
+  if (option[DEBUG])
+    {
+      fprintf (stderr, "\nPortfolio:\n");
+      for (unsigned int i = 0; i < _count; i++)
+        {
+          const Portfolio_Entry *entry = &_entries[i];
+          fprintf (stderr, "%2u: positions %s, %s length, size multiple %g: ",
+                   i,
+                   !entry->_settings._positions_given ? "computed" :
+                   entry->_settings._key_positions.is_useall () ? "all" : "given",
+                   entry->_settings._no_length ? "without" : "with",
+                   static_cast<double>(entry->_settings._size_multiple));
+          if (entry->_state == ENTRY_DONE)
+            fprintf (stderr, "%d positions, maximum hash value %d%s\n",
+                     entry->_positions, entry->_max_hash_value,
+                     i == _best ? " (best)" : "");
+          else
+            fprintf (stderr, "stopped\n");
+        }
+    }
+
+  /* If no search has finished, the keywords have duplicates.  Then the
+     search with the settings given by the options reports them.  */
+  Search_Settings result =
+    (_best < _count ? _entries[_best]._settings : _entries[0]._settings);
+  result._threads = option.get_threads ();
+  return result;
+}
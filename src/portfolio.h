@@ -0,0 +1,89 @@
+/* This may look like C code, but it is really -*- C++ -*- */
+
+/* Portfolio search: several searches with different settings.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of GNU GPERF.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#ifndef portfolio_h
+#define portfolio_h 1
+
+#include "keyword-list.h"
+#include "search.h"
+#include "config.h"
+#if HAVE_PTHREAD
+# include <pthread.h>
+#endif
+
+struct Portfolio_Entry;
+
+/* A Portfolio runs searches with different settings on copies of a keyword
+   list, possibly in parallel, and determines the settings that lead to the
+   best result, according to the objective given by option --portfolio.
+   A search is stopped early when it cannot lead to a better result than a
+   search that has already finished.  Among equally good results, the one of
+   the earliest settings wins, so that the outcome does not depend on the
+   number of threads.  */
+
+class Portfolio
+{
+  friend struct Portfolio_Entry;
+public:
+  /* Prepares the searches for the keywords in LIST.  The first settings
+     are the ones given by the command line options.  */
+                        Portfolio (KeywordExt_List *list);
+                        ~Portfolio ();
+
+  /* Runs the searches.  Returns the settings of the best one.  */
+  Search_Settings       run ();
+
+private:
+  /* Thread entry point: runs searches until there are no more.  */
+  static void *         run_entries (void *arg);
+
+  /* Runs the search of the entry with the given index.  */
+  void                  run_entry (unsigned int index);
+
+  /* Computes the objective of an entry and its search, for a given maximum
+     hash value, as a pair of numbers, compared lexicographically.  */
+  void                  objective (const Portfolio_Entry *entry, const Search *search, int max_hash_value, double key[2]) const;
+
+  /* Tests whether the objective KEY of the entry with the given index is
+     worse than the best result so far.  Must be called while locked.  */
+  bool                  worse_than_best (const double key[2], unsigned int index) const;
+
+  /* Locks and unlocks the shared state.  */
+  void                  lock ();
+  void                  unlock ();
+
+  /* The keyword list.  */
+  KeywordExt_List *     _list;
+  /* The entries, and their number.  */
+  Portfolio_Entry *     _entries;
+  unsigned int          _count;
+  /* The index of the next entry to run.  */
+  unsigned int          _next;
+  /* The index of the best result so far, or _count, and its objective.  */
+  unsigned int          _best;
+  double                _best_key[2];
+#if HAVE_PTHREAD
+  /* Protects _next, _best, _best_key and the results of the entries.  */
+  pthread_mutex_t       _lock;
+#endif
+};
+
+#endif
@@ -24,14 +24,36 @@
 #include <stdio.h>
 #include <stdlib.h> /* declares exit() */
 #include <string.h>
+#include "output-buffer.h"
 
 /* ---------------------------- Class Positions ---------------------------- */
 
+/* Makes room for at least CAPACITY positions.  */
+void
+Positions::reserve (unsigned int capacity)
+{
+  if (capacity > _capacity)
+    {
+      unsigned int new_capacity = 2 * _capacity;
+      if (new_capacity < capacity)
+        new_capacity = capacity;
+      int *new_positions = new int[new_capacity];
+      memcpy (new_positions, _positions, _size * sizeof (_positions[0]));
+      if (_positions != _inline_positions)
+        delete[] _positions;
+      _positions = new_positions;
+      _capacity = new_capacity;
+    }
+}
+
 /* Set operations.  Assumes the array is in reverse order.  */
 
 bool
 Positions::contains (int pos) const
 {
+  if (_useall)
+    return pos >= 0 && pos < MAX_KEY_POS;
+
   unsigned int count = _size;
   const int *p = _positions + _size - 1;
 
@@ -50,14 +72,9 @@ Positions::add (int pos)
 {
   set_useall (false);
 
-  unsigned int count = _size;
-
-  if (count == MAX_SIZE)
-    {
-      fprintf (stderr, "Positions::add internal error: overflow\n");
-      exit (1);
-    }
+  reserve (_size + 1);
 
+  unsigned int count = _size;
   int *p = _positions + _size - 1;
 
   for (; count > 0; p--, count--)
@@ -120,46 +137,54 @@ Positions::remove (int pos)
 
 /* Output in external syntax.  */
 void
-Positions::print () const
+Positions::print (Output_Buffer& out) const
 {
   if (_useall)
-    printf ("*");
+    out.put ('*');
   else
     {
       bool first = true;
-      bool seen_LASTCHAR = false;
-      unsigned int count = _size;
-      const int *p = _positions + _size - 1;
+      /* The positions counted from the start come first in the array.  */
+      unsigned int forward;
+      for (forward = 0; forward < _size && _positions[forward] >= 0; forward++)
+        ;
+
+      /* Print them in ascending order.  */
+      unsigned int count = forward;
+      const int *p = _positions + forward - 1;
 
       for (; count > 0; p--)
         {
           count--;
-          if (*p == LASTCHAR)
-            seen_LASTCHAR = true;
-          else
+          if (!first)
+            out.put (',');
+          out.put_number (*p + 1);
+          if (count > 0 && p[-1] == *p + 1)
             {
-              if (!first)
-                printf (",");
-              printf ("%d", *p + 1);
-              if (count > 0 && p[-1] == *p + 1)
+              out.put ('-');
+              do
                 {
-                  printf ("-");
-                  do
-                    {
-                      p--;
-                      count--;
-                    }
-                  while (count > 0 && p[-1] == *p + 1);
-                  printf ("%d", *p + 1);
+                  p--;
+                  count--;
                 }
-              first = false;
+              while (count > 0 && p[-1] == *p + 1);
+              out.put_number (*p + 1);
             }
+          first = false;
         }
-      if (seen_LASTCHAR)
+      /* Then the positions counted from the end: ..., $-1, $.  */
+      for (unsigned int i = _size; i > forward; )
         {
+          i--;
           if (!first)
-            printf (",");
-          printf ("$");
+            out.put (',');
+          out.put ('$');
+          if (_positions[i] != LASTCHAR)
+            {
+              out.put ('-');
+              out.put_number (LASTCHAR - _positions[i]);
+            }
+          first = false;
         }
     }
 }
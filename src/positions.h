@@ -24,6 +24,8 @@
 #ifndef positions_h
 #define positions_h 1
 
+class Output_Buffer;
+
 /* Classes defined below.  */
 class PositionIterator;
 class PositionReverseIterator;
@@ -35,17 +37,16 @@ class Positions
   friend class PositionIterator;
   friend class PositionReverseIterator;
 public:
-  /* Denotes the last char of a keyword, depending on the keyword's length.  */
+  /* Denotes the last char of a keyword, depending on the keyword's length.
+     More generally, a negative position p denotes the char at index len + p
+     of a keyword of length len: LASTCHAR - 1 is the char before the last
+     one, and so on.  Such a position is present only in keywords of length
+     >= -p.  */
   enum {                LASTCHAR = -1 };
 
-  /* Maximum key position specifiable by the user, 1-based.
-     Note that MAX_KEY_POS-1 must fit into the element type of _positions[],
-     below.  */
-  enum {                MAX_KEY_POS = 255 };
-
-  /* Maximum possible size.  Since duplicates are eliminated and the possible
-     0-based positions are -1 .. MAX_KEY_POS-1, this is:  */
-  enum {                MAX_SIZE = MAX_KEY_POS + 1 };
+  /* Maximum key position specifiable by the user, 1-based, counting from
+     the start or from the end of the keyword.  */
+  enum {                MAX_KEY_POS = 65535 };
 
   /* Constructors.  */
                         Positions ();
@@ -55,6 +56,9 @@ public:
   /* Copy constructor.  */
                         Positions (const Positions& src);
 
+  /* Destructor.  */
+                        ~Positions ();
+
   /* Assignment operator.  */
   Positions&            operator= (const Positions& src);
 
@@ -65,8 +69,8 @@ public:
 
   /* Write access.  */
   void                  set_useall (bool useall);
-  int *                 pointer ();
-  void                  set_size (unsigned int size);
+  /* Appends a position at the end, without sorting.  */
+  void                  append (int pos);
 
   /* Sorts the array in reverse order.
      Returns true if there are no duplicates, false otherwise.  */
@@ -89,16 +93,31 @@ public:
   void                  remove (int pos);
 
   /* Output in external syntax.  */
-  void                  print () const;
+  void                  print (Output_Buffer& out) const;
 
 private:
-  /* The special case denoted by '*'.  */
+  /* Makes room for at least CAPACITY positions.  */
+  void                  reserve (unsigned int capacity);
+
+  /* Determines the indices start <= i < end of the positions that apply to
+     strings of length <= maxlen.  */
+  void                  applicable (int maxlen, unsigned int& start, unsigned int& end) const;
+
+  /* Number of positions that are stored without a heap allocation.  */
+  enum {                INLINE_CAPACITY = 16 };
+
+  /* The special case denoted by '*'.  It stands for the positions
+     MAX_KEY_POS-1, ..., 1, 0, which are not stored.  */
   bool                  _useall;
   /* Number of positions.  */
   unsigned int          _size;
   /* Array of positions.  0 for the first char, 1 for the second char etc.,
-     LASTCHAR for the last char.  */
-  int                   _positions[MAX_SIZE];
+     LASTCHAR for the last char, LASTCHAR - 1 for the char before it etc.
+     It points to _inline_positions or to a heap allocated array.  */
+  int *                 _positions;
+  /* Number of elements of the array.  */
+  unsigned int          _capacity;
+  int                   _inline_positions[INLINE_CAPACITY];
 };
 
 /* This class denotes an iterator through a set of byte positions.  */
@@ -110,8 +129,8 @@ public:
   /* Copy constructor.  */
                         PositionIterator (const PositionIterator& src);
 
-  /* End of iteration marker.  */
-  enum {                EOS = -2 };
+  /* End of iteration marker.  Distinct from all positions.  */
+  enum {                EOS = -0x7fffffff - 1 };
 
   /* Retrieves the next position, or EOS past the end.  */
   int                   next ();
@@ -123,11 +142,13 @@ public:
 private:
   /* Initializes an iterator through POSITIONS.  */
                         PositionIterator (Positions const& positions);
-  /* Initializes an iterator through POSITIONS, ignoring positions >= maxlen.  */
+  /* Initializes an iterator through POSITIONS, ignoring the positions that
+     are not present in strings of length maxlen.  */
                         PositionIterator (Positions const& positions, int maxlen);
 
   const Positions&      _set;
   unsigned int          _index;
+  unsigned int          _endindex;
 };
 
 /* This class denotes an iterator in reverse direction through a set of
@@ -140,8 +161,8 @@ public:
   /* Copy constructor.  */
                         PositionReverseIterator (const PositionReverseIterator& src);
 
-  /* End of iteration marker.  */
-  enum {                EOS = -2 };
+  /* End of iteration marker.  Distinct from all positions.  */
+  enum {                EOS = -0x7fffffff - 1 };
 
   /* Retrieves the next position, or EOS past the end.  */
   int                   next ();
@@ -153,7 +174,8 @@ public:
 private:
   /* Initializes an iterator through POSITIONS.  */
                         PositionReverseIterator (Positions const& positions);
-  /* Initializes an iterator through POSITIONS, ignoring positions >= maxlen.  */
+  /* Initializes an iterator through POSITIONS, ignoring the positions that
+     are not present in strings of length maxlen.  */
                         PositionReverseIterator (Positions const& positions, int maxlen);
 
   const Positions&      _set;
@@ -0,0 +1,83 @@
+/* Pseudo-random number generator.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of GNU GPERF.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Specification. */
+#include "random.h"
+
+/* All computations are modulo 2^32, also if unsigned int is wider.  */
+#define MASK32 0xffffffffU
+
+/* Rotates a 32-bit value left by K bits, 0 < K < 32.  */
+static inline unsigned int
+rotl (unsigned int x, int k)
+{
+  return ((x << k) | ((x & MASK32) >> (32 - k))) & MASK32;
+}
+
+/* Maps a 32-bit value to a well mixed 32-bit value.  This is the finalizer
+   of MurmurHash3.  */
+static unsigned int
+mix (unsigned int z)
+{
+  z = ((z ^ (z >> 16)) * 0x85ebca6bU) & MASK32;
+  z = ((z ^ (z >> 13)) * 0xc2b2ae35U) & MASK32;
+  return z ^ (z >> 16);
+}
+
+Random::Random (unsigned int seed)
+{
+  this->seed (seed);
+}
+
+void
+Random::seed (unsigned int seed)
+{
+  /* Fill the state with a Weyl sequence passed through mix.  Successive
+     values of a bijective mixing function of distinct inputs are distinct,
+     so that the state is never all zero.  */
+  unsigned int z = seed & MASK32;
+  for (int i = 0; i < 4; i++)
+    {
+      z = (z + 0x9e3779b9U) & MASK32;
+      _state[i] = mix (z);
+    }
+}
+
+unsigned int
+Random::next ()
+{
+  unsigned int result = (rotl ((_state[1] * 5) & MASK32, 7) * 9) & MASK32;
+  unsigned int t = (_state[1] << 9) & MASK32;
+
+  _state[2] ^= _state[0];
+  _state[3] ^= _state[1];
+  _state[1] ^= _state[2];
+  _state[0] ^= _state[3];
+  _state[2] ^= t;
+  _state[3] = rotl (_state[3], 11);
+
+  return result;
+}
+
+unsigned int
+Random::derive_seed (unsigned int seed, unsigned int index)
+{
+  return mix ((seed ^ mix ((index * 0x9e3779b9U + 0x7f4a7c15U) & MASK32))
+              & MASK32);
+}
@@ -0,0 +1,50 @@
+/* This may look like C code, but it is really -*- C++ -*- */
+
+/* Pseudo-random number generator.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of GNU GPERF.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#ifndef random_h
+#define random_h 1
+
+/* A Random instance is a xoshiro128** pseudo-random number generator.
+   Unlike rand(), it has no global state, so that every search can have its
+   own generator, and it produces the same sequence on every platform.  */
+
+class Random
+{
+public:
+  /* Initializes the generator with the given seed.  */
+                        Random (unsigned int seed);
+
+  /* Restarts the sequence with the given seed.  */
+  void                  seed (unsigned int seed);
+
+  /* Returns the next pseudo-random number, in the range 0 .. 2^32-1.  */
+  unsigned int          next ();
+
+  /* Returns the seed for the INDEXth of several independent generators that
+     are derived from SEED.  */
+  static unsigned int   derive_seed (unsigned int seed, unsigned int index);
+
+private:
+  /* The generator state.  Never all zero.  */
+  unsigned int          _state[4];
+};
+
+#endif
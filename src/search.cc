@@ -22,15 +22,24 @@
 #include "search.h"
 
 #include <stdio.h>
-#include <stdlib.h> /* declares exit(), rand(), srand() */
+#include <stdlib.h> /* declares exit() */
 #include <string.h> /* declares memset(), memcmp() */
 #include <time.h> /* declares time() */
 #include <math.h> /* declares exp() */
 #include <limits.h> /* defines INT_MIN, INT_MAX, UINT_MAX */
+#include <new> /* declares placement new */
 #include "options.h"
 #include "hash-table.h"
+#include "arena.h"
+#include "solver.h"
+#include "cost.h"
+#include "stats.h"
 #include "config.h"
 
+#if HAVE_PTHREAD
+# include <pthread.h>
+#endif
+
 /* ============================== Portability ============================== */
 
 /* Assume ISO C++ 'for' scoping rule.  */
@@ -117,12 +126,38 @@
 
    where alpha_unify[c] is chosen so that an upper/lower case change in
    keyword[i] doesn't change  alpha_unify[keyword[i] + alpha_inc[i]].
+
+   With option --reduce-alphabet, alpha_unify[c] = c mod 16, if this doesn't
+   introduce artificial duplicates.  Then asso_values has only 16 distinct
+   entries, which the generated code can keep in a single SIMD register.
  */
 
 /* ==================== Initialization and Preparation ===================== */
 
-Search::Search (KeywordExt_List *list)
-  : _head (list)
+Search_Settings::Search_Settings ()
+  : _positions_given (option[POSITIONS]),
+    _key_positions (option.get_key_positions ()),
+    _no_length (option[NOLENGTH]),
+    _size_multiple (option.get_size_multiple ()),
+    _seed (option.get_seed ()),
+    _threads (option.get_threads ())
+{
+}
+
+Search_Monitor::~Search_Monitor ()
+{
+}
+
+Search::Search (KeywordExt_List *list, const Search_Settings& settings)
+  : _head (list), _alpha_inc (NULL), _alpha_unify (NULL),
+    _alpha_reduced (false), _occurrences (NULL), _asso_values (NULL),
+    _collision_detector (NULL), _cost_model (NULL),
+    _seed (0), _random (0), _threads (1),
+    _positions_tried (0), _alpha_incs_tried (0),
+    _asso_values_tried (0), _backtracking_steps (0),
+    _solver_nodes (0), _range_moves (0),
+    _settings (settings), _monitor (NULL), _stopped (false),
+    _shared (false)
 {
 }
 
@@ -157,6 +192,8 @@ Search::prepare ()
       exit (1);
     }
 
+  _cost_model = new Cost_Model (_head, _min_key_len, _max_key_len);
+
   /* Exit program if the characters in the keywords are not in the required
      range.  */
   if (option[SEVENBIT])
@@ -179,7 +216,7 @@ Search::prepare ()
     }
 
   /* Determine whether the hash function shall include the length.  */
-  _hash_includes_len = !(option[NOLENGTH] || (_min_key_len == _max_key_len));
+  _hash_includes_len = !(_settings._no_length || (_min_key_len == _max_key_len));
 }
 
 /* ====================== Finding good byte positions ====================== */
@@ -239,6 +276,7 @@ Search::count_duplicates_tuple (const Positions& positions, const unsigned int *
   /* Run through the keyword list and count the duplicates incrementally.
      The result does not depend on the order of the keyword list, thanks to
      the formula above.  */
+  _positions_tried++;
   init_selchars_tuple (positions, alpha_unify);
 
   unsigned int count = 0;
@@ -263,9 +301,9 @@ void
 Search::find_positions ()
 {
   /* If the user gave the key positions, we use them.  */
-  if (option[POSITIONS])
+  if (_settings._positions_given)
     {
-      _key_positions = option.get_key_positions();
+      _key_positions = _settings._key_positions;
       return;
     }
 
@@ -344,6 +382,7 @@ Search::find_positions ()
     {
       Positions best;
       unsigned int best_duplicates_count = UINT_MAX;
+      double best_cost = 0.0;
 
       for (int i = imax; i >= -1; i--)
         if (!current.contains (i))
@@ -352,15 +391,20 @@ Search::find_positions ()
             tryal.add (i);
             unsigned int try_duplicates_count =
               count_duplicates_tuple (tryal, alpha_unify);
+            double try_cost = _cost_model->hash_cost (tryal);
 
             /* We prefer 'try' to 'best' if it produces less duplicates,
                or if it produces the same number of duplicates but with
-               a more efficient hash function.  */
+               a cheaper hash function, or an equally cheap one that
+               doesn't use the last character.  */
             if (try_duplicates_count < best_duplicates_count
-                || (try_duplicates_count == best_duplicates_count && i >= 0))
+                || (try_duplicates_count == best_duplicates_count
+                    && (try_cost < best_cost
+                        || (try_cost == best_cost && i >= 0))))
               {
                 best = tryal;
                 best_duplicates_count = try_duplicates_count;
+                best_cost = try_cost;
               }
           }
 
@@ -378,6 +422,7 @@ Search::find_positions ()
     {
       Positions best;
       unsigned int best_duplicates_count = UINT_MAX;
+      double best_cost = 0.0;
 
       for (int i = imax; i >= -1; i--)
         if (current.contains (i) && !mandatory.contains (i))
@@ -386,15 +431,20 @@ Search::find_positions ()
             tryal.remove (i);
             unsigned int try_duplicates_count =
               count_duplicates_tuple (tryal, alpha_unify);
+            double try_cost = _cost_model->hash_cost (tryal);
 
             /* We prefer 'try' to 'best' if it produces less duplicates,
                or if it produces the same number of duplicates but with
-               a more efficient hash function.  */
+               a cheaper hash function, or an equally cheap one that
+               doesn't use the last character.  */
             if (try_duplicates_count < best_duplicates_count
-                || (try_duplicates_count == best_duplicates_count && i == -1))
+                || (try_duplicates_count == best_duplicates_count
+                    && (try_cost < best_cost
+                        || (try_cost == best_cost && i == -1))))
               {
                 best = tryal;
                 best_duplicates_count = try_duplicates_count;
+                best_cost = try_cost;
               }
           }
 
@@ -407,11 +457,12 @@ Search::find_positions ()
     }
 
   /* 4. Replace two positions by one, as long as this doesn't increase the
-     duplicates count.  */
+     duplicates count nor the cost of the hash function.  */
   for (;;)
     {
       Positions best;
       unsigned int best_duplicates_count = UINT_MAX;
+      double best_cost = 0.0;
 
       /* Loop over all pairs { i1, i2 } of currently selected positions.
          W.l.o.g. we can assume i1 > i2.  */
@@ -430,24 +481,32 @@ Search::find_positions ()
                         tryal.add (i3);
                         unsigned int try_duplicates_count =
                           count_duplicates_tuple (tryal, alpha_unify);
+                        double try_cost = _cost_model->hash_cost (tryal);
 
                         /* We prefer 'try' to 'best' if it produces less
                            duplicates, or if it produces the same number
-                           of duplicates but with a more efficient hash
-                           function.  */
+                           of duplicates but with a cheaper hash function,
+                           or an equally cheap one that doesn't use the
+                           last character.  */
                         if (try_duplicates_count < best_duplicates_count
                             || (try_duplicates_count == best_duplicates_count
-                                && (i1 == -1 || i2 == -1) && i3 >= 0))
+                                && (try_cost < best_cost
+                                    || (try_cost == best_cost
+                                        && (i1 == -1 || i2 == -1)
+                                        && i3 >= 0))))
                           {
                             best = tryal;
                             best_duplicates_count = try_duplicates_count;
+                            best_cost = try_cost;
                           }
                       }
                 }
           }
 
       /* Stop removing positions when it gives no improvement.  */
-      if (best_duplicates_count > current_duplicates_count)
+      if (best_duplicates_count > current_duplicates_count
+          || (best_duplicates_count == current_duplicates_count
+              && best_cost > _cost_model->hash_cost (current)))
         break;
 
       current = best;
@@ -461,28 +520,28 @@ Search::find_positions ()
     {
       /* Print the result.  */
       fprintf (stderr, "\nComputed positions: ");
-      PositionReverseIterator iter = _key_positions.reviterator();
-      bool seen_lastchar = false;
       bool first = true;
-      for (int i; (i = iter.next ()) != PositionReverseIterator::EOS; )
-        {
-          if (!first)
-            fprintf (stderr, ", ");
-          if (i == Positions::LASTCHAR)
-            seen_lastchar = true;
-          else
-            {
-              fprintf (stderr, "%d", i + 1);
-              first = false;
-            }
-        }
-      if (seen_lastchar)
+      /* First the positions counted from the start, then those counted
+         from the end.  */
+      for (int pass = 0; pass < 2; pass++)
         {
-          if (!first)
-            fprintf (stderr, ", ");
-          fprintf (stderr, "$");
+          PositionReverseIterator iter = _key_positions.reviterator();
+          for (int i; (i = iter.next ()) != PositionReverseIterator::EOS; )
+            if ((i >= 0) == (pass == 0))
+              {
+                if (!first)
+                  fprintf (stderr, ", ");
+                if (i == Positions::LASTCHAR)
+                  fprintf (stderr, "$");
+                else if (i < 0)
+                  fprintf (stderr, "$-%d", Positions::LASTCHAR - i);
+                else
+                  fprintf (stderr, "%d", i + 1);
+                first = false;
+              }
         }
-      fprintf (stderr, "\n");
+      fprintf (stderr, "\nHash function cost: %.2f\n",
+               _cost_model->hash_cost (_key_positions));
     }
 
   /* Free preliminary alpha_unify table.  */
@@ -519,7 +578,18 @@ Search::compute_alpha_size (const unsigned int *alpha_inc) const
 unsigned int *
 Search::compute_alpha_unify (const Positions& positions, const unsigned int *alpha_inc) const
 {
-  if (option[UPPERLOWER])
+  if (_alpha_reduced)
+    {
+      /* Unify c with c mod 16.  This includes the upper/lower case
+         unification, since 'a'-'A' is a multiple of 16.  */
+      unsigned int alpha_size = compute_alpha_size (alpha_inc);
+
+      unsigned int *alpha_unify = new unsigned int[alpha_size];
+      for (unsigned int c = 0; c < alpha_size; c++)
+        alpha_unify[c] = c % 16;
+      return alpha_unify;
+    }
+  else if (option[UPPERLOWER])
     {
       /* Without alpha increments, we would simply unify
            'A' -> 'a', ..., 'Z' -> 'z'.
@@ -551,8 +621,8 @@ Search::compute_alpha_unify (const Positions& positions, const unsigned int *alp
           for (int i; (i = iter.next ()) != PositionIterator::EOS; )
             {
               unsigned int c;
-              if (i == Positions::LASTCHAR)
-                c = static_cast<unsigned char>(keyword->_allchars[keyword->_allchars_length - 1]);
+              if (i < 0)
+                c = static_cast<unsigned char>(keyword->_allchars[keyword->_allchars_length + i]);
               else if (i < keyword->_allchars_length)
                 c = static_cast<unsigned char>(keyword->_allchars[i]);
               else
@@ -561,7 +631,7 @@ Search::compute_alpha_unify (const Positions& positions, const unsigned int *alp
                 c += 'a' - 'A';
               if (c >= 'a' && c <= 'z')
                 {
-                  if (i != Positions::LASTCHAR)
+                  if (i >= 0)
                     c += alpha_inc[i];
                   /* Unify c with c - ('a'-'A').  */
                   unsigned int d = alpha_unify[c];
@@ -597,6 +667,7 @@ Search::count_duplicates_multiset (const unsigned int *alpha_inc) const
   /* Run through the keyword list and count the duplicates incrementally.
      The result does not depend on the order of the keyword list, thanks to
      the formula above.  */
+  _alpha_incs_tried++;
   unsigned int *alpha_unify = compute_alpha_unify (_key_positions, alpha_inc);
   init_selchars_multiset (_key_positions, alpha_unify, alpha_inc);
 
@@ -617,6 +688,105 @@ Search::count_duplicates_multiset (const unsigned int *alpha_inc) const
   return count;
 }
 
+/* Performs several rounds of searching for a good alpha increment, starting
+   from alpha_inc[], which produces duplicates_count duplicates.  Each round
+   reduces the number of artificial collisions by adding an increment in a
+   single key position.  The increments are bounded by max_inc, unless it is
+   0.  Returns true if the number of duplicates has dropped to
+   duplicates_goal, or false if a round found no improvement.
+   Without a bound, a round always finds an improvement if at most one of the
+   positions is counted from the end.  Positions counted from the end have
+   no increment, however, so with several of them a round may fail even
+   without a bound.  */
+
+bool
+Search::improve_alpha_inc (unsigned int *alpha_inc, unsigned int duplicates_count, unsigned int duplicates_goal, unsigned int max_inc) const
+{
+  /* Look which alpha_inc[i] we are free to increment.  */
+  unsigned int nindices;
+  {
+    nindices = 0;
+    PositionIterator iter = _key_positions.iterator(_max_key_len);
+    for (;;)
+      {
+        int key_pos = iter.next ();
+        if (key_pos == PositionIterator::EOS)
+          break;
+        if (key_pos >= 0)
+          nindices++;
+      }
+  }
+
+  DYNAMIC_ARRAY (indices, unsigned int, nindices);
+  {
+    unsigned int j = 0;
+    PositionIterator iter = _key_positions.iterator(_max_key_len);
+    for (;;)
+      {
+        int key_pos = iter.next ();
+        if (key_pos == PositionIterator::EOS)
+          break;
+        if (key_pos >= 0)
+          indices[j++] = key_pos;
+      }
+    if (!(j == nindices))
+      abort ();
+  }
+
+  bool success = true;
+  DYNAMIC_ARRAY (best, unsigned int, _max_key_len);
+  DYNAMIC_ARRAY (tryal, unsigned int, _max_key_len);
+  while (duplicates_count > duplicates_goal)
+    {
+      /* An increment of 1 is not always enough.  Try higher increments
+         also.  */
+      /* An increment >= the alphabet size moves the characters of a key
+         position past all others.  Higher increments produce the same
+         duplicates.  */
+      unsigned int inc_limit =
+        (max_inc > 0 ? max_inc : compute_alpha_size (alpha_inc));
+      unsigned int inc;
+      for (inc = 1; inc <= inc_limit; inc++)
+        {
+          unsigned int best_duplicates_count = UINT_MAX;
+
+          for (unsigned int j = 0; j < nindices; j++)
+            {
+              memcpy (tryal, alpha_inc, _max_key_len * sizeof (unsigned int));
+              tryal[indices[j]] += inc;
+              unsigned int try_duplicates_count =
+                count_duplicates_multiset (tryal);
+
+              /* We prefer 'try' to 'best' if it produces less
+                 duplicates.  */
+              if (try_duplicates_count < best_duplicates_count)
+                {
+                  memcpy (best, tryal, _max_key_len * sizeof (unsigned int));
+                  best_duplicates_count = try_duplicates_count;
+                }
+            }
+
+          /* Stop this round when we got an improvement.  */
+          if (best_duplicates_count < duplicates_count)
+            {
+              memcpy (alpha_inc, best, _max_key_len * sizeof (unsigned int));
+              duplicates_count = best_duplicates_count;
+              break;
+            }
+        }
+      if (inc > inc_limit)
+        {
+          success = false;
+          break;
+        }
+    }
+  FREE_DYNAMIC_ARRAY (tryal);
+  FREE_DYNAMIC_ARRAY (best);
+  FREE_DYNAMIC_ARRAY (indices);
+
+  return success;
+}
+
 /* Find good _alpha_inc[].  */
 
 void
@@ -635,96 +805,23 @@ Search::find_alpha_inc ()
 
   if (current_duplicates_count > duplicates_goal)
     {
-      /* Look which _alpha_inc[i] we are free to increment.  */
-      unsigned int nindices;
-      {
-        nindices = 0;
-        PositionIterator iter = _key_positions.iterator(_max_key_len);
-        for (;;)
-          {
-            int key_pos = iter.next ();
-            if (key_pos == PositionIterator::EOS)
-              break;
-            if (key_pos != Positions::LASTCHAR)
-              nindices++;
-          }
-      }
-
-      DYNAMIC_ARRAY (indices, unsigned int, nindices);
-      {
-        unsigned int j = 0;
-        PositionIterator iter = _key_positions.iterator(_max_key_len);
-        for (;;)
-          {
-            int key_pos = iter.next ();
-            if (key_pos == PositionIterator::EOS)
-              break;
-            if (key_pos != Positions::LASTCHAR)
-              indices[j++] = key_pos;
-          }
-        if (!(j == nindices))
-          abort ();
-      }
-
-      /* Perform several rounds of searching for a good alpha increment.
-         Each round reduces the number of artificial collisions by adding
-         an increment in a single key position.  */
-      DYNAMIC_ARRAY (best, unsigned int, _max_key_len);
-      DYNAMIC_ARRAY (tryal, unsigned int, _max_key_len);
-      do
-        {
-          /* An increment of 1 is not always enough.  Try higher increments
-             also.  */
-          for (unsigned int inc = 1; ; inc++)
-            {
-              unsigned int best_duplicates_count = UINT_MAX;
-
-              for (unsigned int j = 0; j < nindices; j++)
-                {
-                  memcpy (tryal, current, _max_key_len * sizeof (unsigned int));
-                  tryal[indices[j]] += inc;
-                  unsigned int try_duplicates_count =
-                    count_duplicates_multiset (tryal);
-
-                  /* We prefer 'try' to 'best' if it produces less
-                     duplicates.  */
-                  if (try_duplicates_count < best_duplicates_count)
-                    {
-                      memcpy (best, tryal, _max_key_len * sizeof (unsigned int));
-                      best_duplicates_count = try_duplicates_count;
-                    }
-                }
-
-              /* Stop this round when we got an improvement.  */
-              if (best_duplicates_count < current_duplicates_count)
-                {
-                  memcpy (current, best, _max_key_len * sizeof (unsigned int));
-                  current_duplicates_count = best_duplicates_count;
-                  break;
-                }
-            }
-        }
-      while (current_duplicates_count > duplicates_goal);
-      FREE_DYNAMIC_ARRAY (tryal);
-      FREE_DYNAMIC_ARRAY (best);
+      improve_alpha_inc (current, current_duplicates_count, duplicates_goal, 0);
 
       if (option[DEBUG])
         {
           /* Print the result.  */
           fprintf (stderr, "\nComputed alpha increments: ");
           bool first = true;
-          for (unsigned int j = nindices; j-- > 0; )
-            if (current[indices[j]] != 0)
+          for (int i = 0; i < _max_key_len; i++)
+            if (current[i] != 0)
               {
                 if (!first)
                   fprintf (stderr, ", ");
-                fprintf (stderr, "%u:+%u",
-                         indices[j] + 1, current[indices[j]]);
+                fprintf (stderr, "%u:+%u", i + 1, current[i]);
                 first = false;
               }
           fprintf (stderr, "\n");
         }
-      FREE_DYNAMIC_ARRAY (indices);
     }
 
   _alpha_inc = current;
@@ -732,6 +829,57 @@ Search::find_alpha_inc ()
   _alpha_unify = compute_alpha_unify (_key_positions, _alpha_inc);
 }
 
+/* Tries to reduce the alphabet to 16 character classes, namely the residue
+   classes mod 16.  Characters in the same class share the same asso_value.
+   This is possible if it doesn't introduce artificial duplicates, possibly
+   after adjusting _alpha_inc[].  Since only the alpha increments mod 16
+   matter for the classes, increments up to 15 suffice.  */
+
+void
+Search::find_alpha_reduction ()
+{
+  unsigned int duplicates_goal = count_duplicates_multiset (_alpha_inc);
+
+  _alpha_reduced = true;
+
+  unsigned int *current = new unsigned int [_max_key_len];
+  memcpy (current, _alpha_inc, _max_key_len * sizeof (unsigned int));
+  unsigned int current_duplicates_count = count_duplicates_multiset (current);
+
+  if (current_duplicates_count > duplicates_goal
+      && !improve_alpha_inc (current, current_duplicates_count,
+                             duplicates_goal, 15))
+    {
+      /* Keep the full alphabet.  */
+      _alpha_reduced = false;
+      delete[] current;
+      if (option[DEBUG])
+        fprintf (stderr, "\nThe alphabet cannot be reduced to 16 classes.\n");
+      return;
+    }
+
+  if (option[DEBUG])
+    {
+      fprintf (stderr, "\nReduced the alphabet to 16 classes");
+      bool first = true;
+      for (int i = 0; i < _max_key_len; i++)
+        if (current[i] != _alpha_inc[i])
+          {
+            fprintf (stderr, "%s%u:+%u",
+                     first ? ", with alpha increments " : ", ",
+                     i + 1, current[i]);
+            first = false;
+          }
+      fprintf (stderr, "\n");
+    }
+
+  delete[] _alpha_inc;
+  _alpha_inc = current;
+  _alpha_size = compute_alpha_size (_alpha_inc);
+  delete[] _alpha_unify;
+  _alpha_unify = compute_alpha_unify (_key_positions, _alpha_inc);
+}
+
 /* ======================= Finding good asso_values ======================== */
 
 /* Initializes the asso_values[] related parameters.  */
@@ -809,14 +957,23 @@ Search::prepare_asso_values ()
      slower.  */
   if (_total_duplicates)
     {
-      if (option[DUP])
+      if (_monitor != NULL)
+        {
+          /* Leave the messages to the search that produces the output.  */
+          if (!option[DUP])
+            {
+              _stopped = true;
+              return;
+            }
+        }
+      else if (option[DUP])
         fprintf (stderr, "%d input keys have identical hash values, examine output carefully...\n",
                          _total_duplicates);
       else
         {
           fprintf (stderr, "%d input keys have identical hash values,\n",
                            _total_duplicates);
-          if (option[POSITIONS])
+          if (_settings._positions_given)
             fprintf (stderr, "try different key positions or use option -D.\n");
           else
             fprintf (stderr, "use option -D.\n");
@@ -842,7 +999,7 @@ Search::prepare_asso_values ()
   unsigned int asso_value_max;
 
   asso_value_max =
-    static_cast<unsigned int>(non_linked_length * option.get_size_multiple());
+    static_cast<unsigned int>(non_linked_length * _settings._size_multiple);
   /* Round up to the next power of two.  This makes it easy to ensure
      an _asso_value[c] is >= 0 and < asso_value_max.  Also, the jump value
      being odd, it guarantees that Search::try_asso_value() will iterate
@@ -901,11 +1058,33 @@ Search::prepare_asso_values ()
     }
 
   if (option[RANDOM] || option.get_jump () == 0)
-    /* We will use rand(), so initialize the random number generator.  */
-    srand (static_cast<long>(time (0)));
+    {
+      /* We will use random numbers, so initialize the random number
+         generator.  Without --seed, the results depend on the time.  */
+      _seed = (_settings._seed >= 0
+               ? static_cast<unsigned int>(_settings._seed)
+               : static_cast<unsigned int>(time (0)));
+      _random.seed (Random::derive_seed (_seed, 0));
+      if (option[DEBUG])
+        fprintf (stderr, "random seed = %u\n", _seed);
+    }
+  _threads = _settings._threads;
 
   _initial_asso_value = (option[RANDOM] ? -1 : option.get_initial_asso_value ());
   _jump = option.get_jump ();
+
+  /* The keywords of the list have different hash values.  */
+  should_stop (_list_len - 1);
+}
+
+/* Asks the monitor whether the search should stop.  */
+
+bool
+Search::should_stop (int max_hash_value_bound)
+{
+  if (_monitor != NULL && _monitor->stop (this, max_hash_value_bound))
+    _stopped = true;
+  return _stopped;
 }
 
 /* Finds some _asso_values[] that fit.  */
@@ -942,14 +1121,33 @@ struct EquivalenceClass
   KeywordExt_List *     _keywords_last;
   /* The number of keywords in this equivalence class.  */
   unsigned int          _cardinality;
-  /* The undetermined selected characters for the keywords in this
-     equivalence class, as a canonically reordered multiset.  */
-  unsigned int *        _undetermined_chars;
-  unsigned int          _undetermined_chars_length;
-
   EquivalenceClass *    _next;
 };
 
+/* A partition of the keyword list into equivalence classes.  The classes
+   and their keyword lists are allocated from a single arena, so that the
+   partition can be built and freed without one heap allocation per
+   keyword.  */
+struct Partition
+{
+  /* The equivalence classes, in the order of their first keyword.  */
+  EquivalenceClass *    _classes;
+  /* Holds the classes and their keyword lists.  */
+  Arena                 _arena;
+};
+
+/* Returns storage for N objects of type T from ARENA.  The size is rounded
+   up to a multiple of the pointer size, so that all objects allocated from
+   the arena remain suitably aligned.  */
+template <class T>
+static inline T *
+arena_allocate (Arena& arena, size_t n)
+{
+  size_t size = n * sizeof (T);
+  size = (size + sizeof (void *) - 1) / sizeof (void *) * sizeof (void *);
+  return reinterpret_cast<T *>(arena.allocate (size));
+}
+
 struct Step
 {
   /* The characters whose values are being determined in this step.  */
@@ -961,7 +1159,7 @@ struct Step
   /* The characters whose values will be determined after this step.  */
   bool *                _undetermined;
   /* The keyword set partition after this step.  */
-  EquivalenceClass *    _partition;
+  Partition *           _partition;
   /* The expected number of iterations in this step.  */
   double                _expected_lower;
   double                _expected_upper;
@@ -969,202 +1167,1018 @@ struct Step
   Step *                _next;
 };
 
-static inline bool
-equals (const unsigned int *ptr1, const unsigned int *ptr2, unsigned int len)
+/* A partition of the keyword list that is refined in place, one character
+   at a time, as the steps are determined from the last one to the first one.
+   Refining by c splits every equivalence class according to the frequency
+   of occurrence of c.  For every character c, the partition caches the
+   number of possible collisions that refining by c would lead to, and the
+   number of classes that it would split.  A refinement only updates these
+   numbers for the classes that are actually split, so that choosing the
+   characters of a step does not require rescanning every class.  */
+
+class Partition_Refinement
 {
-  while (len > 0)
-    {
-      if (*ptr1 != *ptr2)
-        return false;
-      ptr1++;
-      ptr2++;
-      len--;
-    }
-  return true;
-}
+public:
+  /* Starts with a single equivalence class that contains all keywords.  */
+                        Partition_Refinement (KeywordExt_List *list, unsigned int list_len, unsigned int alpha_size, unsigned int max_selchars_length);
+                        ~Partition_Refinement ();
+
+  /* Returns the possible number of collisions when _asso_values[c] is
+     chosen, leading to the current partition.  */
+  unsigned int          possible_collisions (unsigned int c) const
+                          { return _possible_collisions[c]; }
+
+  /* Tests whether refining by c would leave the partition unchanged.  */
+  bool                  unchanged (unsigned int c) const
+                          { return _splitting_classes[c] == 0; }
+
+  /* Splits every equivalence class according to the frequency of
+     occurrence of c.  */
+  void                  refine (unsigned int c);
+
+  /* Returns a copy of the current partition.  The classes are in the order
+     of their first keyword, and the keywords of each class are in list
+     order.  */
+  Partition *           snapshot () const;
+
+private:
+  /* Returns the number of occurrences of c in the keyword with index k.  */
+  unsigned int          count (unsigned int k, unsigned int c) const;
+
+  /* Adds (if sign > 0) or removes (if sign < 0) the contribution of a class
+     to _possible_collisions[] and _splitting_classes[].  */
+  void                  update_counters (unsigned int cls, int sign);
+
+  /* Number of keywords.  */
+  unsigned int          _n;
+  /* Size of the alphabet.  */
+  unsigned int          _alpha_size;
+  /* The keywords, indexed by their position in the keyword list.  */
+  KeywordExt **         _keywords;
+  /* The distinct characters of keyword k and their number of occurrences,
+     at indices _hist_start[k] .. _hist_start[k+1]-1.  */
+  unsigned int *        _hist_start;
+  unsigned int *        _hist_chars;
+  unsigned int *        _hist_counts;
+  /* The keywords in which c occurs, at indices
+     _occ_start[c] .. _occ_start[c+1]-1.  */
+  unsigned int *        _occ_start;
+  unsigned int *        _occ_keywords;
+  /* The keywords, ordered so that every class is a contiguous segment.
+     Within a segment, the keywords are in list order.  */
+  unsigned int *        _order;
+  /* The segment of each class.  */
+  unsigned int *        _class_start;
+  unsigned int *        _class_length;
+  unsigned int          _class_count;
+  /* The class of each keyword.  */
+  unsigned int *        _class_of;
+  /* For each character c, the cached number of possible collisions and
+     the number of classes in which c has different frequencies.  */
+  unsigned int *        _possible_collisions;
+  unsigned int *        _splitting_classes;
+
+  /* Scratch space.  */
+  /* Marks for characters and classes, valid if equal to _stamp.  */
+  unsigned int          _stamp;
+  unsigned int *        _char_mark;
+  unsigned int *        _class_mark;
+  /* For each marked character, the first of its (count, frequency) nodes.  */
+  unsigned int *        _char_nodes;
+  /* The marked characters.  */
+  unsigned int *        _touched;
+  /* (count, frequency) nodes, linked through _node_next.  */
+  unsigned int *        _node_count;
+  unsigned int *        _node_frequency;
+  unsigned int *        _node_next;
+  /* The count of the refining character in each keyword of a segment, and
+     a copy of the segment.  */
+  unsigned int *        _segment_counts;
+  unsigned int *        _segment_copy;
+  /* The number of keywords of a segment for each count, and the class
+     that receives them.  */
+  unsigned int *        _tally;
+  unsigned int *        _tally_class;
+  unsigned int          _max_count;
+};
+
+/* Marks the end of a list of nodes.  */
+static const unsigned int NO_NODE = UINT_MAX;
 
-EquivalenceClass *
-Search::compute_partition (bool *undetermined) const
+Partition_Refinement::Partition_Refinement (KeywordExt_List *list, unsigned int list_len, unsigned int alpha_size, unsigned int max_selchars_length)
+  : _n (list_len),
+    _alpha_size (alpha_size),
+    _class_count (0),
+    _stamp (0),
+    _max_count (max_selchars_length)
 {
-  EquivalenceClass *partition = NULL;
-  EquivalenceClass *partition_last = NULL;
-  for (KeywordExt_List *temp = _head; temp; temp = temp->rest())
-    {
-      KeywordExt *keyword = temp->first();
+  unsigned int n = _n;
 
-      /* Compute the undetermined characters for this keyword.  */
-      unsigned int *undetermined_chars =
-        new unsigned int[keyword->_selchars_length];
-      unsigned int undetermined_chars_length = 0;
+  _keywords = new KeywordExt*[n];
+  {
+    unsigned int k = 0;
+    for (KeywordExt_List *temp = list; temp; temp = temp->rest())
+      _keywords[k++] = temp->first();
+  }
 
+  _char_mark = new unsigned int[alpha_size];
+  for (unsigned int c = 0; c < alpha_size; c++)
+    _char_mark[c] = 0;
+  _char_nodes = new unsigned int[alpha_size];
+  _touched = new unsigned int[alpha_size];
+
+  /* Compute the histogram of each keyword.  */
+  unsigned int total = 0;
+  for (unsigned int k = 0; k < n; k++)
+    total += _keywords[k]->_selchars_length;
+  _hist_start = new unsigned int[n + 1];
+  _hist_chars = new unsigned int[total];
+  _hist_counts = new unsigned int[total];
+  unsigned int pos = 0;
+  for (unsigned int k = 0; k < n; k++)
+    {
+      const KeywordExt *keyword = _keywords[k];
+      _stamp++;
+      _hist_start[k] = pos;
       for (int i = 0; i < keyword->_selchars_length; i++)
-        if (undetermined[keyword->_selchars[i]])
-          undetermined_chars[undetermined_chars_length++] = keyword->_selchars[i];
-
-      /* Look up the equivalence class to which this keyword belongs.  */
-      EquivalenceClass *equclass;
-      for (equclass = partition; equclass; equclass = equclass->_next)
-        if (equclass->_undetermined_chars_length == undetermined_chars_length
-            && equals (equclass->_undetermined_chars, undetermined_chars,
-                       undetermined_chars_length))
-          break;
-      if (equclass == NULL)
         {
-          equclass = new EquivalenceClass();
-          equclass->_keywords = NULL;
-          equclass->_keywords_last = NULL;
-          equclass->_cardinality = 0;
-          equclass->_undetermined_chars = undetermined_chars;
-          equclass->_undetermined_chars_length = undetermined_chars_length;
-          equclass->_next = NULL;
-          if (partition)
-            partition_last->_next = equclass;
-          else
-            partition = equclass;
-          partition_last = equclass;
+          unsigned int c = keyword->_selchars[i];
+          if (_char_mark[c] != _stamp)
+            {
+              _char_mark[c] = _stamp;
+              /* _char_nodes[c] serves as the index of c's entry here.  */
+              _char_nodes[c] = pos;
+              _hist_chars[pos] = c;
+              _hist_counts[pos] = 0;
+              pos++;
+            }
+          _hist_counts[_char_nodes[c]]++;
         }
-      else
-        delete[] undetermined_chars;
+    }
+  _hist_start[n] = pos;
+  unsigned int distinct = pos;
+
+  /* Invert the histograms.  */
+  _occ_start = new unsigned int[alpha_size + 1];
+  for (unsigned int c = 0; c <= alpha_size; c++)
+    _occ_start[c] = 0;
+  for (unsigned int i = 0; i < distinct; i++)
+    _occ_start[_hist_chars[i] + 1]++;
+  for (unsigned int c = 0; c < alpha_size; c++)
+    _occ_start[c + 1] += _occ_start[c];
+  _occ_keywords = new unsigned int[distinct];
+  {
+    DYNAMIC_ARRAY (fill, unsigned int, alpha_size);
+    for (unsigned int c = 0; c < alpha_size; c++)
+      fill[c] = _occ_start[c];
+    for (unsigned int k = 0; k < n; k++)
+      for (unsigned int i = _hist_start[k]; i < _hist_start[k + 1]; i++)
+        _occ_keywords[fill[_hist_chars[i]]++] = k;
+    FREE_DYNAMIC_ARRAY (fill);
+  }
 
-      /* Add the keyword to the equivalence class.  */
-      KeywordExt_List *cons = new KeywordExt_List(keyword);
-      if (equclass->_keywords)
-        equclass->_keywords_last->rest() = cons;
-      else
-        equclass->_keywords = cons;
-      equclass->_keywords_last = cons;
-      equclass->_cardinality++;
+  _order = new unsigned int[n];
+  _class_start = new unsigned int[n];
+  _class_length = new unsigned int[n];
+  _class_of = new unsigned int[n];
+  _class_mark = new unsigned int[n];
+  for (unsigned int k = 0; k < n; k++)
+    {
+      _order[k] = k;
+      _class_of[k] = 0;
+      _class_mark[k] = 0;
     }
 
-  /* Free some of the allocated memory.  The caller doesn't need it.  */
-  for (EquivalenceClass *cls = partition; cls; cls = cls->_next)
-    delete[] cls->_undetermined_chars;
+  _possible_collisions = new unsigned int[alpha_size];
+  _splitting_classes = new unsigned int[alpha_size];
+  for (unsigned int c = 0; c < alpha_size; c++)
+    {
+      _possible_collisions[c] = 0;
+      _splitting_classes[c] = 0;
+    }
 
-  return partition;
-}
+  _node_count = new unsigned int[distinct];
+  _node_frequency = new unsigned int[distinct];
+  _node_next = new unsigned int[distinct];
+  _segment_counts = new unsigned int[n];
+  _segment_copy = new unsigned int[n];
+  _tally = new unsigned int[max_selchars_length + 1];
+  _tally_class = new unsigned int[max_selchars_length + 1];
 
-static void
-delete_partition (EquivalenceClass *partition)
-{
-  while (partition != NULL)
+  /* Start with a single class.  */
+  if (n > 0)
     {
-      EquivalenceClass *equclass = partition;
-      partition = equclass->_next;
-      delete_list (equclass->_keywords);
-      //delete[] equclass->_undetermined_chars; // already freed above
-      delete equclass;
+      _class_start[0] = 0;
+      _class_length[0] = n;
+      _class_count = 1;
+      update_counters (0, 1);
     }
 }
 
-/* Compute the possible number of collisions when _asso_values[c] is
-   chosen, leading to the given partition.  */
-unsigned int
-Search::count_possible_collisions (EquivalenceClass *partition, unsigned int c) const
+Partition_Refinement::~Partition_Refinement ()
+{
+  delete[] _tally_class;
+  delete[] _tally;
+  delete[] _segment_copy;
+  delete[] _segment_counts;
+  delete[] _node_next;
+  delete[] _node_frequency;
+  delete[] _node_count;
+  delete[] _splitting_classes;
+  delete[] _possible_collisions;
+  delete[] _class_mark;
+  delete[] _class_of;
+  delete[] _class_length;
+  delete[] _class_start;
+  delete[] _order;
+  delete[] _occ_keywords;
+  delete[] _occ_start;
+  delete[] _hist_counts;
+  delete[] _hist_chars;
+  delete[] _hist_start;
+  delete[] _touched;
+  delete[] _char_nodes;
+  delete[] _char_mark;
+  delete[] _keywords;
+}
+
+/* Returns the number of occurrences of c in the keyword with index k.  */
+inline unsigned int
+Partition_Refinement::count (unsigned int k, unsigned int c) const
+{
+  for (unsigned int i = _hist_start[k]; i < _hist_start[k + 1]; i++)
+    if (_hist_chars[i] == c)
+      return _hist_counts[i];
+  return 0;
+}
+
+/* Adds or removes the contribution of a class to _possible_collisions[]
+   and _splitting_classes[].  */
+void
+Partition_Refinement::update_counters (unsigned int cls, int sign)
 {
   /* Every equivalence class p is split according to the frequency of
      occurrence of c, leading to equivalence classes p1, p2, ...
-     This leads to   (|p|^2 - |p1|^2 - |p2|^2 - ...)/2  possible collisions.
-     Return the sum of this expression over all equivalence classes.  */
-  unsigned int sum = 0;
-  unsigned int m = _max_selchars_length;
-  DYNAMIC_ARRAY (split_cardinalities, unsigned int, m + 1);
-  for (EquivalenceClass *cls = partition; cls; cls = cls->_next)
+     This leads to   |p|^2 - |p1|^2 - |p2|^2 - ...   possible collisions.
+     Collect, for each character c that occurs in p, the number of keywords
+     of p in which c occurs exactly 1, 2, ... times.  */
+  unsigned int start = _class_start[cls];
+  unsigned int length = _class_length[cls];
+  unsigned int touched_count = 0;
+  unsigned int node_count = 0;
+
+  _stamp++;
+  for (unsigned int j = start; j < start + length; j++)
     {
-      for (unsigned int i = 0; i <= m; i++)
-        split_cardinalities[i] = 0;
-
-      for (KeywordExt_List *temp = cls->_keywords; temp; temp = temp->rest())
+      unsigned int k = _order[j];
+      for (unsigned int i = _hist_start[k]; i < _hist_start[k + 1]; i++)
         {
-          KeywordExt *keyword = temp->first();
-
-          unsigned int count = 0;
-          for (int i = 0; i < keyword->_selchars_length; i++)
-            if (keyword->_selchars[i] == c)
-              count++;
+          unsigned int c = _hist_chars[i];
+          unsigned int cnt = _hist_counts[i];
+          if (_char_mark[c] != _stamp)
+            {
+              _char_mark[c] = _stamp;
+              _char_nodes[c] = NO_NODE;
+              _touched[touched_count++] = c;
+            }
+          unsigned int node;
+          for (node = _char_nodes[c]; node != NO_NODE; node = _node_next[node])
+            if (_node_count[node] == cnt)
+              break;
+          if (node == NO_NODE)
+            {
+              node = node_count++;
+              _node_count[node] = cnt;
+              _node_frequency[node] = 0;
+              _node_next[node] = _char_nodes[c];
+              _char_nodes[c] = node;
+            }
+          _node_frequency[node]++;
+        }
+    }
 
-          split_cardinalities[count]++;
+  for (unsigned int t = 0; t < touched_count; t++)
+    {
+      unsigned int c = _touched[t];
+      unsigned int node = _char_nodes[c];
+      /* c splits p unless it occurs equally often in all keywords of p.  */
+      if (_node_next[node] == NO_NODE && _node_frequency[node] == length)
+        continue;
+
+      unsigned int sum = length * length;
+      unsigned int present = 0;
+      for (; node != NO_NODE; node = _node_next[node])
+        {
+          sum -= _node_frequency[node] * _node_frequency[node];
+          present += _node_frequency[node];
         }
+      unsigned int absent = length - present;
+      sum -= absent * absent;
 
-      sum += cls->_cardinality * cls->_cardinality;
-      for (unsigned int i = 0; i <= m; i++)
-        sum -= split_cardinalities[i] * split_cardinalities[i];
+      if (sign > 0)
+        {
+          _possible_collisions[c] += sum;
+          _splitting_classes[c]++;
+        }
+      else
+        {
+          _possible_collisions[c] -= sum;
+          _splitting_classes[c]--;
+        }
     }
-  FREE_DYNAMIC_ARRAY (split_cardinalities);
-  return sum;
 }
 
-/* Test whether adding c to the undetermined characters changes the given
-   partition.  */
-bool
-Search::unchanged_partition (EquivalenceClass *partition, unsigned int c) const
+/* Splits every equivalence class according to the frequency of occurrence
+   of c.  */
+void
+Partition_Refinement::refine (unsigned int c)
 {
-  for (EquivalenceClass *cls = partition; cls; cls = cls->_next)
+  if (_splitting_classes[c] == 0)
+    return;
+
+  /* Only the classes that contain a keyword with c can be split.  */
+  _stamp++;
+  unsigned int affected_count = 0;
+  DYNAMIC_ARRAY (affected, unsigned int, _occ_start[c + 1] - _occ_start[c]);
+  for (unsigned int i = _occ_start[c]; i < _occ_start[c + 1]; i++)
     {
-      unsigned int first_count = UINT_MAX;
+      unsigned int cls = _class_of[_occ_keywords[i]];
+      if (_class_mark[cls] != _stamp)
+        {
+          _class_mark[cls] = _stamp;
+          affected[affected_count++] = cls;
+        }
+    }
 
-      for (KeywordExt_List *temp = cls->_keywords; temp; temp = temp->rest())
+  for (unsigned int a = 0; a < affected_count; a++)
+    {
+      unsigned int cls = affected[a];
+      unsigned int start = _class_start[cls];
+      unsigned int length = _class_length[cls];
+
+      /* Count the keywords of this class for each count of c.  */
+      for (unsigned int cnt = 0; cnt <= _max_count; cnt++)
+        _tally[cnt] = 0;
+      unsigned int distinct_counts = 0;
+      for (unsigned int j = 0; j < length; j++)
         {
-          KeywordExt *keyword = temp->first();
+          _segment_copy[j] = _order[start + j];
+          _segment_counts[j] = count (_segment_copy[j], c);
+          if (_tally[_segment_counts[j]]++ == 0)
+            distinct_counts++;
+        }
+      if (distinct_counts == 1)
+        /* c occurs equally often in all keywords of this class.  */
+        continue;
 
-          unsigned int count = 0;
-          for (int i = 0; i < keyword->_selchars_length; i++)
-            if (keyword->_selchars[i] == c)
-              count++;
+      update_counters (cls, -1);
 
-          if (temp == cls->_keywords)
-            first_count = count;
-          else if (count != first_count)
-            /* c would split this equivalence class.  */
-            return false;
+      /* Sort the segment by the count of c, keeping the list order within
+         each new class.  The first new class reuses the number of the old
+         class.  */
+      unsigned int first_new_class = _class_count;
+      unsigned int offset = start;
+      bool first = true;
+      for (unsigned int cnt = 0; cnt <= _max_count; cnt++)
+        if (_tally[cnt] > 0)
+          {
+            unsigned int new_cls = (first ? cls : _class_count++);
+            first = false;
+            _class_start[new_cls] = offset;
+            _class_length[new_cls] = _tally[cnt];
+            _tally_class[cnt] = new_cls;
+            /* From now on, _tally[cnt] is the next free position.  */
+            _tally[cnt] = offset;
+            offset += _class_length[new_cls];
+          }
+      for (unsigned int j = 0; j < length; j++)
+        {
+          unsigned int k = _segment_copy[j];
+          unsigned int cnt = _segment_counts[j];
+          _order[_tally[cnt]++] = k;
+          _class_of[k] = _tally_class[cnt];
         }
+
+      update_counters (cls, 1);
+      for (unsigned int nc = first_new_class; nc < _class_count; nc++)
+        update_counters (nc, 1);
     }
-  return true;
+  FREE_DYNAMIC_ARRAY (affected);
 }
 
-void
-Search::find_asso_values ()
+/* Returns a copy of the current partition.  */
+Partition *
+Partition_Refinement::snapshot () const
 {
-  Step *steps;
-
-  /* Determine the steps, starting with the last one.  */
-  {
-    bool *undetermined;
-    bool *determined;
+  Partition *partition = new Partition();
+  partition->_classes = NULL;
+  EquivalenceClass *partition_last = NULL;
 
-    steps = NULL;
+  /* Within a segment, the keywords are in list order.  Therefore the first
+     keyword of a class is the first keyword of its segment.  */
+  DYNAMIC_ARRAY (class_starting_at, unsigned int, _n);
+  for (unsigned int k = 0; k < _n; k++)
+    class_starting_at[k] = UINT_MAX;
+  for (unsigned int cls = 0; cls < _class_count; cls++)
+    class_starting_at[_order[_class_start[cls]]] = cls;
 
-    undetermined = new bool[_alpha_size];
-    for (unsigned int c = 0; c < _alpha_size; c++)
-      undetermined[c] = false;
+  for (unsigned int k = 0; k < _n; k++)
+    if (class_starting_at[k] != UINT_MAX)
+      {
+        unsigned int cls = class_starting_at[k];
+        EquivalenceClass *equclass =
+          arena_allocate<EquivalenceClass> (partition->_arena, 1);
+        equclass->_keywords = NULL;
+        equclass->_keywords_last = NULL;
+        equclass->_cardinality = _class_length[cls];
+        equclass->_next = NULL;
+        for (unsigned int j = _class_start[cls];
+             j < _class_start[cls] + _class_length[cls];
+             j++)
+          {
+            KeywordExt_List *cons =
+              new (arena_allocate<KeywordExt_List> (partition->_arena, 1))
+                KeywordExt_List(_keywords[_order[j]]);
+            if (equclass->_keywords)
+              equclass->_keywords_last->rest() = cons;
+            else
+              equclass->_keywords = cons;
+            equclass->_keywords_last = cons;
+          }
+        if (partition->_classes)
+          partition_last->_next = equclass;
+        else
+          partition->_classes = equclass;
+        partition_last = equclass;
+      }
 
-    determined = new bool[_alpha_size];
-    for (unsigned int c = 0; c < _alpha_size; c++)
-      determined[c] = true;
+  FREE_DYNAMIC_ARRAY (class_starting_at);
+  return partition;
+}
 
-    for (;;)
-      {
-        /* Compute the partition that needs to be refined.  */
-        EquivalenceClass *partition = compute_partition (undetermined);
+/* Tests whether the given asso_values[] lead to collisions among the
+   keywords of the equivalence classes from FIRST up to, but excluding, LAST.
+   Only keywords of the same class can collide.  */
+static bool
+classes_collide (EquivalenceClass *first, EquivalenceClass *last,
+                 const bool *undetermined, const int *asso_values,
+                 bool hash_includes_len, Bool_Array *detector)
+{
+  for (EquivalenceClass *cls = first; cls != last; cls = cls->_next)
+    {
+      /* Iteration Number array is a win, O(1) initialization time!  */
+      detector->clear ();
 
-        /* Determine the main character to be chosen in this step.
-           Choosing such a character c has the effect of splitting every
-           equivalence class (according the the frequency of occurrence of c).
-           We choose the c with the minimum number of possible collisions,
-           so that characters which lead to a large number of collisions get
-           handled early during the search.  */
-        unsigned int chosen_c;
-        unsigned int chosen_possible_collisions;
+      for (KeywordExt_List *ptr = cls->_keywords; ptr; ptr = ptr->rest())
         {
-          unsigned int best_c = 0;
-          unsigned int best_possible_collisions = UINT_MAX;
-          for (unsigned int c = 0; c < _alpha_size; c++)
-            if (_occurrences[c] > 0 && determined[c])
-              {
-                unsigned int possible_collisions =
-                  count_possible_collisions (partition, c);
-                if (possible_collisions < best_possible_collisions)
-                  {
-                    best_c = c;
+          KeywordExt *keyword = ptr->first();
+
+          /* Compute the new hash code for the keyword, leaving apart
+             the yet undetermined asso_values[].  */
+          int sum = hash_includes_len ? keyword->_allchars_length : 0;
+          const unsigned int *p = keyword->_selchars;
+          int i = keyword->_selchars_length;
+          for (; i > 0; p++, i--)
+            if (!undetermined[*p])
+              sum += asso_values[*p];
+
+          /* See whether it collides with another keyword's hash code,
+             from the same equivalence class.  */
+          if (detector->set_bit (sum))
+            return true;
+        }
+    }
+  return false;
+}
+
+#if HAVE_PTHREAD
+
+/* Minimum number of keywords per thread for which testing asso_values[]
+   in parallel is worth the synchronization.  */
+static const unsigned int MIN_KEYWORDS_PER_THREAD = 1024;
+
+/* Tests candidate asso_values[] for the characters of a step in several
+   threads.  A batch of candidates is tested at once; each candidate is
+   tested on a few chunks of the step's equivalence classes, and each pair
+   of a candidate and a chunk is a separate work item.  Every thread has
+   its own copy of asso_values[] and its own collision detector.  The result
+   of a batch is the first candidate that leads to no collision, regardless
+   of the number of threads and of the order in which the items are done.  */
+
+class Parallel_Collision_Test;
+
+/* The state of one thread of a Parallel_Collision_Test.  */
+struct Collision_Worker
+{
+  Parallel_Collision_Test * _owner;
+  unsigned int          _index;
+  pthread_t             _thread;
+  /* The thread's copy of asso_values[].  */
+  int *                 _asso_values;
+  /* The thread's collision detector.  */
+  Bool_Array *          _detector;
+};
+
+class Parallel_Collision_Test
+{
+public:
+  /* Starts THREADS - 1 worker threads; the calling thread is the other one.
+     If SPECULATE is true, a batch has one candidate per thread, otherwise
+     a single candidate.  */
+                        Parallel_Collision_Test (unsigned int threads, unsigned int alpha_size, bool hash_includes_len, bool speculate);
+                        ~Parallel_Collision_Test ();
+
+  /* Prepares for testing the candidates of the given step.  */
+  void                  start_step (const Step *step);
+
+  /* Returns true if the batches of the current step have more than one
+     work item.  */
+  bool                  is_parallel () const
+                          { return _batch_size * _chunk_count > 1; }
+
+  /* Returns the number of candidates in a batch.  */
+  unsigned int          batch_size () const
+                          { return _batch_size; }
+
+  /* Stores the asso_values[] of the step's characters as candidate B,
+     together with the step's _asso_value_max at that time.  */
+  void                  set_candidate (unsigned int b, const int *asso_values, unsigned int asso_value_max);
+
+  /* Copies candidate B into asso_values[].  */
+  void                  get_candidate (unsigned int b, int *asso_values) const;
+
+  /* Returns the step's _asso_value_max at the time candidate B was
+     stored.  */
+  unsigned int          get_candidate_asso_value_max (unsigned int b) const
+                          { return _candidate_asso_value_max[b]; }
+
+  /* Makes the collision detectors suitable for hash values < SIZE.  */
+  void                  resize_detectors (unsigned int size);
+
+  /* Tests the candidates 0..COUNT-1.  ASSO_VALUES holds the values of the
+     other characters.  Returns the index of the first candidate that leads
+     to no collision, or COUNT if there is none.  */
+  unsigned int          test (unsigned int count, const int *asso_values);
+
+  /* Main loop of a worker thread.  */
+  void                  work (unsigned int thread);
+
+private:
+  /* Does work items until there are no more.  */
+  void                  do_items (unsigned int thread);
+
+  unsigned int          _alpha_size;
+  bool                  _hash_includes_len;
+  bool                  _speculate;
+
+  /* The threads.  _workers[0] is the calling thread.  */
+  Collision_Worker *    _workers;
+  unsigned int          _worker_count;
+  /* Size of the collision detectors.  */
+  unsigned int          _detector_size;
+
+  /* The current step.  */
+  const Step *          _step;
+  unsigned int          _batch_size;
+  /* The chunks of the step's equivalence classes: chunk i consists of
+     the classes from _chunks[i] up to, but excluding, _chunks[i+1].  */
+  EquivalenceClass **   _chunks;
+  unsigned int          _chunk_count;
+
+  /* The candidates: the values of the step's characters, and the step's
+     _asso_value_max.  */
+  int *                 _candidates;
+  unsigned int *        _candidate_asso_value_max;
+
+  /* The state of the current batch, protected by _mutex.  */
+  pthread_mutex_t       _mutex;
+  pthread_cond_t        _work_available;
+  pthread_cond_t        _work_done;
+  /* Incremented for every batch.  */
+  unsigned int          _generation;
+  bool                  _shutdown;
+  const int *           _base_asso_values;
+  unsigned int          _item_count;
+  unsigned int          _next_item;
+  /* Number of worker threads that are still busy with the batch.  */
+  unsigned int          _busy_workers;
+  /* For each candidate, whether a collision has been found, and the number
+     of chunks that have been tested.  */
+  bool *                _collides;
+  unsigned int *        _chunks_done;
+  /* The first candidate that has been found to lead to no collision.  */
+  unsigned int          _first_success;
+};
+
+/* Thread entry point: runs the Collision_Worker ARG.  */
+static void *
+collision_test_worker (void *arg)
+{
+  Collision_Worker *worker = static_cast<Collision_Worker *>(arg);
+  worker->_owner->work (worker->_index);
+  return NULL;
+}
+
+Parallel_Collision_Test::Parallel_Collision_Test (unsigned int threads, unsigned int alpha_size, bool hash_includes_len, bool speculate)
+  : _alpha_size (alpha_size),
+    _hash_includes_len (hash_includes_len),
+    _speculate (speculate),
+    _detector_size (0),
+    _step (NULL),
+    _batch_size (1),
+    _chunk_count (1),
+    _generation (0),
+    _shutdown (false),
+    _base_asso_values (NULL),
+    _item_count (0),
+    _next_item (0),
+    _busy_workers (0),
+    _first_success (0)
+{
+  pthread_mutex_init (&_mutex, NULL);
+  pthread_cond_init (&_work_available, NULL);
+  pthread_cond_init (&_work_done, NULL);
+
+  _workers = new Collision_Worker[threads];
+  _chunks = new EquivalenceClass*[threads + 1];
+  _candidates = new int[threads * alpha_size];
+  _candidate_asso_value_max = new unsigned int[threads];
+  _collides = new bool[threads];
+  _chunks_done = new unsigned int[threads];
+
+  /* Start the worker threads.  Continue with fewer threads if one cannot
+     be started.  */
+  _worker_count = 0;
+  for (unsigned int i = 0; i < threads; i++)
+    {
+      Collision_Worker& worker = _workers[i];
+      worker._owner = this;
+      worker._index = i;
+      worker._asso_values = new int[alpha_size];
+      worker._detector = NULL;
+      if (i > 0
+          && pthread_create (&worker._thread, NULL, collision_test_worker,
+                             &worker) != 0)
+        {
+          delete[] worker._asso_values;
+          break;
+        }
+      _worker_count++;
+    }
+}
+
+Parallel_Collision_Test::~Parallel_Collision_Test ()
+{
+  pthread_mutex_lock (&_mutex);
+  _shutdown = true;
+  pthread_cond_broadcast (&_work_available);
+  pthread_mutex_unlock (&_mutex);
+  for (unsigned int i = 1; i < _worker_count; i++)
+    pthread_join (_workers[i]._thread, NULL);
+
+  for (unsigned int i = 0; i < _worker_count; i++)
+    {
+      delete _workers[i]._detector;
+      delete[] _workers[i]._asso_values;
+    }
+  delete[] _chunks_done;
+  delete[] _collides;
+  delete[] _candidate_asso_value_max;
+  delete[] _candidates;
+  delete[] _chunks;
+  delete[] _workers;
+
+  pthread_cond_destroy (&_work_done);
+  pthread_cond_destroy (&_work_available);
+  pthread_mutex_destroy (&_mutex);
+}
+
+/* Prepares for testing the candidates of the given step.  */
+void
+Parallel_Collision_Test::start_step (const Step *step)
+{
+  _step = step;
+  _batch_size = (_speculate ? _worker_count : 1);
+
+  /* Split the equivalence classes into chunks of roughly the same number
+     of keywords.  */
+  unsigned int keyword_count = 0;
+  for (EquivalenceClass *cls = step->_partition->_classes; cls; cls = cls->_next)
+    keyword_count += cls->_cardinality;
+  unsigned int chunk_count = keyword_count / MIN_KEYWORDS_PER_THREAD;
+  if (chunk_count > _worker_count)
+    chunk_count = _worker_count;
+  if (chunk_count == 0)
+    chunk_count = 1;
+
+  _chunks[0] = step->_partition->_classes;
+  _chunk_count = 1;
+  unsigned int sum = 0;
+  for (EquivalenceClass *cls = step->_partition->_classes; cls; cls = cls->_next)
+    {
+      sum += cls->_cardinality;
+      if (_chunk_count < chunk_count && cls->_next != NULL
+          && sum >= static_cast<unsigned long>(keyword_count) * _chunk_count / chunk_count)
+        _chunks[_chunk_count++] = cls->_next;
+    }
+  _chunks[_chunk_count] = NULL;
+}
+
+/* Stores the asso_values[] of the step's characters as candidate B.  */
+void
+Parallel_Collision_Test::set_candidate (unsigned int b, const int *asso_values, unsigned int asso_value_max)
+{
+  int *candidate = _candidates + b * _alpha_size;
+  for (unsigned int i = 0; i < _step->_changing_count; i++)
+    candidate[i] = asso_values[_step->_changing[i]];
+  _candidate_asso_value_max[b] = asso_value_max;
+}
+
+/* Copies candidate B into asso_values[].  */
+void
+Parallel_Collision_Test::get_candidate (unsigned int b, int *asso_values) const
+{
+  const int *candidate = _candidates + b * _alpha_size;
+  for (unsigned int i = 0; i < _step->_changing_count; i++)
+    asso_values[_step->_changing[i]] = candidate[i];
+}
+
+/* Makes the collision detectors suitable for hash values < SIZE.  */
+void
+Parallel_Collision_Test::resize_detectors (unsigned int size)
+{
+  if (_detector_size != size)
+    {
+      for (unsigned int i = 0; i < _worker_count; i++)
+        {
+          delete _workers[i]._detector;
+          _workers[i]._detector = new Bool_Array (size);
+        }
+      _detector_size = size;
+    }
+}
+
+/* Tests the candidates 0..COUNT-1.  */
+unsigned int
+Parallel_Collision_Test::test (unsigned int count, const int *asso_values)
+{
+  pthread_mutex_lock (&_mutex);
+  _base_asso_values = asso_values;
+  _item_count = count * _chunk_count;
+  _next_item = 0;
+  for (unsigned int b = 0; b < count; b++)
+    {
+      _collides[b] = false;
+      _chunks_done[b] = 0;
+    }
+  _first_success = count;
+  _busy_workers = _worker_count - 1;
+  _generation++;
+  pthread_cond_broadcast (&_work_available);
+  pthread_mutex_unlock (&_mutex);
+
+  do_items (0);
+
+  pthread_mutex_lock (&_mutex);
+  while (_busy_workers > 0)
+    pthread_cond_wait (&_work_done, &_mutex);
+  unsigned int result = _first_success;
+  pthread_mutex_unlock (&_mutex);
+  return result;
+}
+
+/* Main loop of a worker thread.  */
+void
+Parallel_Collision_Test::work (unsigned int thread)
+{
+  unsigned int generation = 0;
+  pthread_mutex_lock (&_mutex);
+  for (;;)
+    {
+      while (_generation == generation && !_shutdown)
+        pthread_cond_wait (&_work_available, &_mutex);
+      if (_shutdown)
+        break;
+      generation = _generation;
+      pthread_mutex_unlock (&_mutex);
+
+      do_items (thread);
+
+      pthread_mutex_lock (&_mutex);
+      if (--_busy_workers == 0)
+        pthread_cond_signal (&_work_done);
+    }
+  pthread_mutex_unlock (&_mutex);
+}
+
+/* Does work items until there are no more.  */
+void
+Parallel_Collision_Test::do_items (unsigned int thread)
+{
+  Collision_Worker& worker = _workers[thread];
+  memcpy (worker._asso_values, _base_asso_values, _alpha_size * sizeof (int));
+  unsigned int loaded = UINT_MAX;
+
+  for (;;)
+    {
+      /* Take the next item that is still useful: skip the candidates that
+         are known to collide or that come after a known success.  */
+      unsigned int b = 0;
+      unsigned int chunk = 0;
+      bool found = false;
+      pthread_mutex_lock (&_mutex);
+      while (_next_item < _item_count)
+        {
+          unsigned int item = _next_item++;
+          b = item / _chunk_count;
+          chunk = item % _chunk_count;
+          if (!_collides[b] && b < _first_success)
+            {
+              found = true;
+              break;
+            }
+        }
+      pthread_mutex_unlock (&_mutex);
+      if (!found)
+        break;
+
+      if (loaded != b)
+        {
+          get_candidate (b, worker._asso_values);
+          loaded = b;
+        }
+      bool collides =
+        classes_collide (_chunks[chunk], _chunks[chunk + 1],
+                         _step->_undetermined, worker._asso_values,
+                         _hash_includes_len, worker._detector);
+
+      pthread_mutex_lock (&_mutex);
+      if (collides)
+        _collides[b] = true;
+      if (++_chunks_done[b] == _chunk_count && !_collides[b]
+          && b < _first_success)
+        _first_success = b;
+      pthread_mutex_unlock (&_mutex);
+    }
+}
+
+#endif
+
+/* Advances the asso_values[] of the characters that are being determined
+   in a step to the next candidate.  ITER and II hold the state of the
+   enumeration.  */
+void
+Search::next_asso_values (Step *step, unsigned int *iter, unsigned int& ii)
+{
+  unsigned int k = step->_changing_count;
+  if (_jump != 0)
+    {
+      /* The way we try various values for
+           asso_values[step->_changing[0],...step->_changing[k-1]]
+         is like this:
+         for (bound = 0,1,...)
+           for (ii = 0,...,k-1)
+             iter[ii] := bound
+             iter[0..ii-1] := values <= bound
+             iter[ii+1..k-1] := values < bound
+         and
+           asso_values[step->_changing[i]] =
+             _initial_asso_value + iter[i] * _jump.
+         This makes it more likely to find small asso_values[].
+       */
+      unsigned int bound = iter[ii];
+      unsigned int i = 0;
+      while (i < ii)
+        {
+          unsigned int c = step->_changing[i];
+          iter[i]++;
+          _asso_values[c] =
+            (_asso_values[c] + _jump) & (step->_asso_value_max - 1);
+          if (iter[i] <= bound)
+            return;
+          _asso_values[c] =
+            (_asso_values[c] - iter[i] * _jump)
+            & (step->_asso_value_max - 1);
+          iter[i] = 0;
+          i++;
+        }
+      i = ii + 1;
+      while (i < k)
+        {
+          unsigned int c = step->_changing[i];
+          iter[i]++;
+          _asso_values[c] =
+            (_asso_values[c] + _jump) & (step->_asso_value_max - 1);
+          if (iter[i] < bound)
+            return;
+          _asso_values[c] =
+            (_asso_values[c] - iter[i] * _jump)
+            & (step->_asso_value_max - 1);
+          iter[i] = 0;
+          i++;
+        }
+      /* Switch from one ii to the next.  */
+      {
+        unsigned int c = step->_changing[ii];
+        _asso_values[c] =
+          (_asso_values[c] - bound * _jump)
+          & (step->_asso_value_max - 1);
+        iter[ii] = 0;
+      }
+      /* Here all iter[i] == 0.  */
+      ii++;
+      if (ii == k)
+        {
+          ii = 0;
+          bound++;
+          if (bound == step->_asso_value_max)
+            {
+              /* Out of search space!  We can either backtrack, or
+                 increase the available search space of this step.
+                 It seems simpler to choose the latter solution.  */
+              _backtracking_steps++;
+              step->_asso_value_max = 2 * step->_asso_value_max;
+              if (step->_asso_value_max > _asso_value_max)
+                {
+                  _asso_value_max = step->_asso_value_max;
+                  /* Reinitialize _max_hash_value.  */
+                  _max_hash_value =
+                    (_hash_includes_len ? _max_key_len : 0)
+                    + (_asso_value_max - 1) * _max_selchars_length;
+                  /* Reinitialize _collision_detector.  */
+                  delete _collision_detector;
+                  _collision_detector =
+                    new Bool_Array (_max_hash_value + 1);
+                }
+            }
+        }
+      {
+        unsigned int c = step->_changing[ii];
+        iter[ii] = bound;
+        _asso_values[c] =
+          (_asso_values[c] + bound * _jump)
+          & (step->_asso_value_max - 1);
+      }
+    }
+  else
+    {
+      /* Random.  */
+      unsigned int c = step->_changing[ii];
+      _asso_values[c] =
+        (_asso_values[c] + _random.next ()) & (step->_asso_value_max - 1);
+      /* Next time, change the next c.  */
+      ii++;
+      if (ii == k)
+        ii = 0;
+    }
+}
+
+void
+Search::find_asso_values ()
+{
+  Step *steps;
+
+  /* Determine the steps, starting with the last one.  */
+  {
+    bool *undetermined;
+    bool *determined;
+
+    steps = NULL;
+
+    undetermined = new bool[_alpha_size];
+    for (unsigned int c = 0; c < _alpha_size; c++)
+      undetermined[c] = false;
+
+    determined = new bool[_alpha_size];
+    for (unsigned int c = 0; c < _alpha_size; c++)
+      determined[c] = true;
+
+    /* The partition that needs to be refined.  */
+    Partition_Refinement partition (_head, _list_len, _alpha_size,
+                                    _max_selchars_length);
+
+    for (;;)
+      {
+
+        /* Determine the main character to be chosen in this step.
+           Choosing such a character c has the effect of splitting every
+           equivalence class (according the the frequency of occurrence of c).
+           We choose the c with the minimum number of possible collisions,
+           so that characters which lead to a large number of collisions get
+           handled early during the search.  */
+        unsigned int chosen_c;
+        unsigned int chosen_possible_collisions;
+        {
+          unsigned int best_c = 0;
+          unsigned int best_possible_collisions = UINT_MAX;
+          for (unsigned int c = 0; c < _alpha_size; c++)
+            if (_occurrences[c] > 0 && determined[c])
+              {
+                unsigned int possible_collisions =
+                  partition.possible_collisions (c);
+                if (possible_collisions < best_possible_collisions)
+                  {
+                    best_c = c;
                     best_possible_collisions = possible_collisions;
                   }
               }
@@ -1172,7 +2186,6 @@ Search::find_asso_values ()
             {
               /* All c with _occurrences[c] > 0 are undetermined.  We are
                  are the starting situation and don't need any more step.  */
-              delete_partition (partition);
               break;
             }
           chosen_c = best_c;
@@ -1185,12 +2198,12 @@ Search::find_asso_values ()
         step->_undetermined = new bool[_alpha_size];
         memcpy (step->_undetermined, undetermined, _alpha_size*sizeof(bool));
 
-        step->_partition = partition;
+        step->_partition = partition.snapshot ();
 
         /* Now determine how the equivalence classes will be before this
            step.  */
         undetermined[chosen_c] = true;
-        partition = compute_partition (undetermined);
+        partition.refine (chosen_c);
 
         /* Now determine which other characters should be determined in this
            step, because they will not change the equivalence classes at
@@ -1199,7 +2212,7 @@ Search::find_asso_values ()
            of the equivalence class.  */
         for (unsigned int c = 0; c < _alpha_size; c++)
           if (_occurrences[c] > 0 && determined[c]
-              && unchanged_partition (partition, c))
+              && partition.unchanged (c))
             {
               undetermined[c] = true;
               determined[c] = false;
@@ -1235,8 +2248,6 @@ Search::find_asso_values ()
           exp (static_cast<double>(chosen_possible_collisions)
                / static_cast<double>(_asso_value_max));
 
-        delete_partition (partition);
-
         step->_next = steps;
         steps = step;
       }
@@ -1261,7 +2272,7 @@ Search::find_asso_values ()
           fprintf (stderr, "], expected number of iterations between %g and %g.\n",
                    step->_expected_lower, step->_expected_upper);
           fprintf (stderr, "Keyword equivalence classes:\n");
-          for (EquivalenceClass *cls = step->_partition; cls; cls = cls->_next)
+          for (EquivalenceClass *cls = step->_partition->_classes; cls; cls = cls->_next)
             {
               fprintf (stderr, "\n");
               for (KeywordExt_List *temp = cls->_keywords; temp; temp = temp->rest())
@@ -1275,11 +2286,26 @@ Search::find_asso_values ()
         }
     }
 
+#if HAVE_PTHREAD
+  /* With several threads, test the candidate asso_values[] in parallel.  */
+  Parallel_Collision_Test *parallel = NULL;
+  if (_threads > 1
+      && static_cast<unsigned int>(_list_len) >= 2 * MIN_KEYWORDS_PER_THREAD)
+    parallel = new Parallel_Collision_Test (_threads, _alpha_size,
+                                            _hash_includes_len, _jump != 0);
+#endif
+
   /* Initialize _asso_values[].  (The value given here matters only
      for those c which occur in all keywords with equal multiplicity.)  */
   for (unsigned int c = 0; c < _alpha_size; c++)
     _asso_values[c] = 0;
 
+  /* After each step, report a lower bound of the maximum hash value to the
+     monitor.  It holds only if no later phase changes the _asso_values[].  */
+  bool monitor_steps =
+    (_monitor != NULL && option.get_asso_iterations () == 0
+     && option.get_solver_limit () == 0 && !option[MINRANGE]);
+
   unsigned int stepno = 0;
   for (Step *step = steps; step; step = step->_next)
     {
@@ -1291,7 +2317,9 @@ Search::find_asso_values ()
         {
           unsigned int c = step->_changing[i];
           _asso_values[c] =
-            (_initial_asso_value < 0 ? rand () : _initial_asso_value)
+            (_initial_asso_value < 0
+             ? _random.next ()
+             : static_cast<unsigned int>(_initial_asso_value))
             & (step->_asso_value_max - 1);
         }
 
@@ -1300,154 +2328,81 @@ Search::find_asso_values ()
       for (unsigned int i = 0; i < k; i++)
         iter[i] = 0;
       unsigned int ii = (_jump != 0 ? k - 1 : 0);
+#if HAVE_PTHREAD
+      if (parallel != NULL)
+        parallel->start_step (step);
+#endif
 
       for (;;)
         {
-          /* Test whether these asso_values[] lead to collisions among
-             the equivalence classes that should be collision-free.  */
-          bool has_collision = false;
-          for (EquivalenceClass *cls = step->_partition; cls; cls = cls->_next)
+#if HAVE_PTHREAD
+          if (parallel != NULL && parallel->is_parallel ())
             {
-              /* Iteration Number array is a win, O(1) initialization time!  */
-              _collision_detector->clear ();
-
-              for (KeywordExt_List *ptr = cls->_keywords; ptr; ptr = ptr->rest())
+              /* Test a batch of candidates at once, in parallel.  In
+                 random mode, a batch consists of a single candidate, so
+                 that the sequence of random numbers remains the same.  */
+              unsigned int batch_size = parallel->batch_size ();
+              unsigned int global_asso_value_max = _asso_value_max;
+              for (unsigned int b = 0; ; )
                 {
-                  KeywordExt *keyword = ptr->first();
-
-                  /* Compute the new hash code for the keyword, leaving apart
-                     the yet undetermined asso_values[].  */
-                  int hashcode;
-                  {
-                    int sum = _hash_includes_len ? keyword->_allchars_length : 0;
-                    const unsigned int *p = keyword->_selchars;
-                    int i = keyword->_selchars_length;
-                    for (; i > 0; p++, i--)
-                      if (!step->_undetermined[*p])
-                        sum += _asso_values[*p];
-                    hashcode = sum;
-                  }
+                  parallel->set_candidate (b, _asso_values, step->_asso_value_max);
+                  if (++b == batch_size)
+                    break;
+                  next_asso_values (step, iter, ii);
+                }
+              parallel->resize_detectors (_max_hash_value + 1);
+              unsigned int winner = parallel->test (batch_size, _asso_values);
 
-                  /* See whether it collides with another keyword's hash code,
-                     from the same equivalence class.  */
-                  if (_collision_detector->set_bit (hashcode))
+              unsigned int tested = (winner < batch_size ? winner + 1 : batch_size);
+              iterations += tested;
+              _asso_values_tried += tested;
+              if (winner < batch_size)
+                {
+                  /* Use the winner.  Undo the search space increases that
+                     happened while preparing the later candidates.  */
+                  parallel->get_candidate (winner, _asso_values);
+                  unsigned int winner_asso_value_max =
+                    parallel->get_candidate_asso_value_max (winner);
+                  while (step->_asso_value_max > winner_asso_value_max)
                     {
-                      has_collision = true;
-                      break;
+                      step->_asso_value_max /= 2;
+                      _backtracking_steps--;
                     }
+                  unsigned int asso_value_max =
+                    (winner_asso_value_max > global_asso_value_max
+                     ? winner_asso_value_max
+                     : global_asso_value_max);
+                  if (_asso_value_max != asso_value_max)
+                    {
+                      _asso_value_max = asso_value_max;
+                      _max_hash_value =
+                        (_hash_includes_len ? _max_key_len : 0)
+                        + (_asso_value_max - 1) * _max_selchars_length;
+                      delete _collision_detector;
+                      _collision_detector = new Bool_Array (_max_hash_value + 1);
+                    }
+                  break;
                 }
 
-              /* Don't need to continue looking at the other equivalence
-                 classes if we already have found a collision.  */
-              if (has_collision)
-                break;
+              next_asso_values (step, iter, ii);
+              continue;
             }
+#endif
+
+          /* Test whether these asso_values[] lead to collisions among
+             the equivalence classes that should be collision-free.  */
+          bool has_collision =
+            classes_collide (step->_partition->_classes, NULL,
+                             step->_undetermined, _asso_values,
+                             _hash_includes_len, _collision_detector);
 
           iterations++;
+          _asso_values_tried++;
           if (!has_collision)
             break;
 
           /* Try other asso_values[].  */
-          if (_jump != 0)
-            {
-              /* The way we try various values for
-                   asso_values[step->_changing[0],...step->_changing[k-1]]
-                 is like this:
-                 for (bound = 0,1,...)
-                   for (ii = 0,...,k-1)
-                     iter[ii] := bound
-                     iter[0..ii-1] := values <= bound
-                     iter[ii+1..k-1] := values < bound
-                 and
-                   asso_values[step->_changing[i]] =
-                     _initial_asso_value + iter[i] * _jump.
-                 This makes it more likely to find small asso_values[].
-               */
-              unsigned int bound = iter[ii];
-              unsigned int i = 0;
-              while (i < ii)
-                {
-                  unsigned int c = step->_changing[i];
-                  iter[i]++;
-                  _asso_values[c] =
-                    (_asso_values[c] + _jump) & (step->_asso_value_max - 1);
-                  if (iter[i] <= bound)
-                    goto found_next;
-                  _asso_values[c] =
-                    (_asso_values[c] - iter[i] * _jump)
-                    & (step->_asso_value_max - 1);
-                  iter[i] = 0;
-                  i++;
-                }
-              i = ii + 1;
-              while (i < k)
-                {
-                  unsigned int c = step->_changing[i];
-                  iter[i]++;
-                  _asso_values[c] =
-                    (_asso_values[c] + _jump) & (step->_asso_value_max - 1);
-                  if (iter[i] < bound)
-                    goto found_next;
-                  _asso_values[c] =
-                    (_asso_values[c] - iter[i] * _jump)
-                    & (step->_asso_value_max - 1);
-                  iter[i] = 0;
-                  i++;
-                }
-              /* Switch from one ii to the next.  */
-              {
-                unsigned int c = step->_changing[ii];
-                _asso_values[c] =
-                  (_asso_values[c] - bound * _jump)
-                  & (step->_asso_value_max - 1);
-                iter[ii] = 0;
-              }
-              /* Here all iter[i] == 0.  */
-              ii++;
-              if (ii == k)
-                {
-                  ii = 0;
-                  bound++;
-                  if (bound == step->_asso_value_max)
-                    {
-                      /* Out of search space!  We can either backtrack, or
-                         increase the available search space of this step.
-                         It seems simpler to choose the latter solution.  */
-                      step->_asso_value_max = 2 * step->_asso_value_max;
-                      if (step->_asso_value_max > _asso_value_max)
-                        {
-                          _asso_value_max = step->_asso_value_max;
-                          /* Reinitialize _max_hash_value.  */
-                          _max_hash_value =
-                            (_hash_includes_len ? _max_key_len : 0)
-                            + (_asso_value_max - 1) * _max_selchars_length;
-                          /* Reinitialize _collision_detector.  */
-                          delete _collision_detector;
-                          _collision_detector =
-                            new Bool_Array (_max_hash_value + 1);
-                        }
-                    }
-                }
-              {
-                unsigned int c = step->_changing[ii];
-                iter[ii] = bound;
-                _asso_values[c] =
-                  (_asso_values[c] + bound * _jump)
-                  & (step->_asso_value_max - 1);
-              }
-             found_next: ;
-            }
-          else
-            {
-              /* Random.  */
-              unsigned int c = step->_changing[ii];
-              _asso_values[c] =
-                (_asso_values[c] + rand ()) & (step->_asso_value_max - 1);
-              /* Next time, change the next c.  */
-              ii++;
-              if (ii == k)
-                ii = 0;
-            }
+          next_asso_values (step, iter, ii);
         }
       FREE_DYNAMIC_ARRAY (iter);
 
@@ -1462,8 +2417,31 @@ Search::find_asso_values ()
             }
           fprintf (stderr, "] in %u iterations.\n", iterations);
         }
+
+      if (monitor_steps)
+        {
+          /* The _asso_values[c] of the characters that are determined
+             after this step are final, and the others are >= 0.  */
+          int max_hash_value_bound = 0;
+          for (KeywordExt_List *ptr = _head; ptr; ptr = ptr->rest())
+            {
+              KeywordExt *keyword = ptr->first();
+              int sum = _hash_includes_len ? keyword->_allchars_length : 0;
+              for (int i = 0; i < keyword->_selchars_length; i++)
+                if (!step->_undetermined[keyword->_selchars[i]])
+                  sum += _asso_values[keyword->_selchars[i]];
+              if (max_hash_value_bound < sum)
+                max_hash_value_bound = sum;
+            }
+          if (should_stop (max_hash_value_bound))
+            break;
+        }
     }
 
+#if HAVE_PTHREAD
+  delete parallel;
+#endif
+
   /* Free allocated memory.  */
   while (steps != NULL)
     {
@@ -1471,7 +2449,7 @@ Search::find_asso_values ()
       steps = step->_next;
       delete[] step->_changing;
       delete[] step->_undetermined;
-      delete_partition (step->_partition);
+      delete step->_partition;
       delete step;
     }
 }
@@ -1492,18 +2470,593 @@ Search::compute_hash (KeywordExt *keyword) const
   return keyword->_hash_value = sum;
 }
 
+/* Lowers the maximum hash value of the found _asso_values[] through an
+   exact search.  Each round looks for _asso_values[] whose maximum hash value
+   is smaller than the best one so far, until the solver proves that there
+   are none or reaches its node limit.  */
+
+void
+Search::solve_asso_values ()
+{
+  int max_hash_value = 0;
+  for (KeywordExt_List *ptr = _head; ptr; ptr = ptr->rest())
+    {
+      int hashcode = compute_hash (ptr->first());
+      if (max_hash_value < hashcode)
+        max_hash_value = hashcode;
+    }
+
+  Solver solver (_head, _alpha_size, _occurrences, _hash_includes_len);
+  unsigned long node_limit = option.get_solver_limit ();
+  int *asso_values = new int[_alpha_size];
+  memcpy (asso_values, _asso_values, _alpha_size * sizeof (_asso_values[0]));
+
+  bool optimal = false;
+  while (solver.get_nodes () < node_limit)
+    {
+      Solver::Result result =
+        solver.solve (max_hash_value - 1, node_limit - solver.get_nodes (),
+                      asso_values);
+      if (result == Solver::INFEASIBLE)
+        optimal = true;
+      if (result != Solver::FOUND)
+        break;
+
+      /* Install the better _asso_values[].  */
+      memcpy (_asso_values, asso_values,
+              _alpha_size * sizeof (_asso_values[0]));
+      max_hash_value = 0;
+      for (KeywordExt_List *ptr = _head; ptr; ptr = ptr->rest())
+        {
+          int hashcode = compute_hash (ptr->first());
+          if (max_hash_value < hashcode)
+            max_hash_value = hashcode;
+        }
+    }
+  delete[] asso_values;
+
+  _solver_nodes += solver.get_nodes ();
+  if (option[DEBUG])
+    fprintf (stderr, "Solver: maximum hash value %d is %s, after %lu nodes.\n",
+             max_hash_value, optimal ? "optimal" : "not proved optimal",
+             solver.get_nodes ());
+}
+
+/* Lowers the maximum hash value of collision-free _asso_values[] through
+   local search.  A move gives one character a smaller value, or exchanges
+   the values of two characters.  It is accepted if the hash values remain
+   different and do not exceed a bound.  Only the keywords that contain the
+   changed characters need to be checked.  */
+
+class Range_Minimizer
+{
+public:
+  /* Prepares the search for the keywords in LIST, whose hash values,
+     relative to ASSO_VALUES, are all different.  DETECTOR must have room for
+     their hash values.  */
+                        Range_Minimizer (KeywordExt_List *list, unsigned int alpha_size, const int *occurrences, bool hash_includes_len, int *asso_values, Bool_Array *detector);
+                        ~Range_Minimizer ();
+
+  /* Modifies the associated values as long as this makes progress.
+     Returns the new maximum hash value.  */
+  int                   minimize ();
+
+  /* Returns the maximum hash value before the search.  */
+  int                   get_initial_max_hash_value () const
+                          { return _initial_max_hash_value; }
+
+  /* Returns the number of moves tried.  */
+  unsigned long         get_moves () const { return _moves; }
+
+private:
+  /* Computes the hash value of the keyword with index k.  */
+  int                   hash (unsigned int k) const;
+
+  /* Tests whether the keyword with index k contains c.  */
+  bool                  contains (unsigned int k, unsigned int c) const;
+
+  /* Sets _asso_values[c1] to v1 and, if c2 < _alpha_size, _asso_values[c2]
+     to v2, provided that all hash values remain different and <= BOUND.
+     Returns true if the change was made.  */
+  bool                  try_change (unsigned int c1, int v1, unsigned int c2, int v2, int bound);
+
+  /* Moves the keyword with the largest hash value lower.  Returns true if
+     successful.  */
+  bool                  lower_maximum ();
+
+  /* Gives each character the smallest value that keeps the hash values
+     different.  Returns true if some value was lowered.  */
+  bool                  lower_values ();
+
+  /* Number of keywords.  */
+  unsigned int          _n;
+  /* Size of the alphabet.  */
+  unsigned int          _alpha_size;
+  /* Whether the hash function includes the length.  */
+  bool                  _hash_includes_len;
+  /* The keywords, in list order.  */
+  KeywordExt **         _keywords;
+  /* The associated values being modified.  */
+  int * const           _asso_values;
+  /* Detects collisions among the changed hash values.  */
+  Bool_Array * const    _detector;
+  /* The keywords in which c occurs, at indices
+     _occ_start[c] .. _occ_start[c+1]-1.  */
+  unsigned int *        _occ_start;
+  unsigned int *        _occ_keywords;
+  /* The hash value of each keyword.  */
+  int *                 _hashes;
+  /* For each hash value, the index of the keyword that has it, or -1.  */
+  int *                 _owner;
+  /* The keywords affected by the current move, and their new hash values.  */
+  unsigned int *        _affected;
+  int *                 _new_hashes;
+  /* The current and the initial maximum hash value.  */
+  int                   _max_hash_value;
+  int                   _initial_max_hash_value;
+  /* Number of moves tried.  */
+  unsigned long         _moves;
+};
+
+Range_Minimizer::Range_Minimizer (KeywordExt_List *list, unsigned int alpha_size, const int *occurrences, bool hash_includes_len, int *asso_values, Bool_Array *detector)
+  : _n (0),
+    _alpha_size (alpha_size),
+    _hash_includes_len (hash_includes_len),
+    _asso_values (asso_values),
+    _detector (detector),
+    _max_hash_value (0),
+    _moves (0)
+{
+  for (KeywordExt_List *temp = list; temp; temp = temp->rest())
+    _n++;
+  _keywords = new KeywordExt*[_n];
+  {
+    unsigned int k = 0;
+    for (KeywordExt_List *temp = list; temp; temp = temp->rest())
+      _keywords[k++] = temp->first();
+  }
+
+  /* For each character, list the keywords in which it occurs.  The
+     characters that don't occur in the search, because their _occurrences[]
+     are 0, are left alone.  */
+  unsigned int *seen = new unsigned int[alpha_size];
+  _occ_start = new unsigned int[alpha_size + 1];
+  for (unsigned int c = 0; c < alpha_size; c++)
+    {
+      seen[c] = 0;
+      _occ_start[c] = 0;
+    }
+  unsigned int total = 0;
+  for (unsigned int k = 0; k < _n; k++)
+    {
+      const KeywordExt *keyword = _keywords[k];
+      for (int i = 0; i < keyword->_selchars_length; i++)
+        {
+          unsigned int c = keyword->_selchars[i];
+          if (occurrences[c] > 0 && seen[c] != k + 1)
+            {
+              seen[c] = k + 1;
+              _occ_start[c]++;
+              total++;
+            }
+        }
+    }
+  {
+    unsigned int start = 0;
+    for (unsigned int c = 0; c < alpha_size; c++)
+      {
+        unsigned int count = _occ_start[c];
+        _occ_start[c] = start;
+        start += count;
+        seen[c] = 0;
+      }
+    _occ_start[alpha_size] = start;
+  }
+  _occ_keywords = new unsigned int[total];
+  {
+    unsigned int *fill = new unsigned int[alpha_size];
+    memcpy (fill, _occ_start, alpha_size * sizeof (fill[0]));
+    for (unsigned int k = 0; k < _n; k++)
+      {
+        const KeywordExt *keyword = _keywords[k];
+        for (int i = 0; i < keyword->_selchars_length; i++)
+          {
+            unsigned int c = keyword->_selchars[i];
+            if (occurrences[c] > 0 && seen[c] != k + 1)
+              {
+                seen[c] = k + 1;
+                _occ_keywords[fill[c]++] = k;
+              }
+          }
+      }
+    delete[] fill;
+  }
+  delete[] seen;
+
+  _hashes = new int[_n];
+  for (unsigned int k = 0; k < _n; k++)
+    {
+      _hashes[k] = hash (k);
+      if (_max_hash_value < _hashes[k])
+        _max_hash_value = _hashes[k];
+    }
+  _initial_max_hash_value = _max_hash_value;
+  _owner = new int[_max_hash_value + 1];
+  for (int h = 0; h <= _max_hash_value; h++)
+    _owner[h] = -1;
+  for (unsigned int k = 0; k < _n; k++)
+    _owner[_hashes[k]] = k;
+
+  _affected = new unsigned int[_n];
+  _new_hashes = new int[_n];
+}
+
+Range_Minimizer::~Range_Minimizer ()
+{
+  delete[] _new_hashes;
+  delete[] _affected;
+  delete[] _owner;
+  delete[] _hashes;
+  delete[] _occ_keywords;
+  delete[] _occ_start;
+  delete[] _keywords;
+}
+
+inline int
+Range_Minimizer::hash (unsigned int k) const
+{
+  const KeywordExt *keyword = _keywords[k];
+  int sum = _hash_includes_len ? keyword->_allchars_length : 0;
+
+  const unsigned int *p = keyword->_selchars;
+  int i = keyword->_selchars_length;
+  for (; i > 0; p++, i--)
+    sum += _asso_values[*p];
+
+  return sum;
+}
+
+inline bool
+Range_Minimizer::contains (unsigned int k, unsigned int c) const
+{
+  const KeywordExt *keyword = _keywords[k];
+  for (int i = 0; i < keyword->_selchars_length; i++)
+    if (keyword->_selchars[i] == c)
+      return true;
+  return false;
+}
+
+bool
+Range_Minimizer::try_change (unsigned int c1, int v1, unsigned int c2, int v2, int bound)
+{
+  _moves++;
+
+  int old_v1 = _asso_values[c1];
+  int old_v2 = 0;
+  _asso_values[c1] = v1;
+  if (c2 < _alpha_size)
+    {
+      old_v2 = _asso_values[c2];
+      _asso_values[c2] = v2;
+    }
+
+  /* Compute the new hash values of the affected keywords.  A new hash value
+     must not exceed the bound, must not be the hash value of a keyword that
+     keeps its hash value, and must be different from the other new hash
+     values.  */
+  _detector->clear ();
+  unsigned int count = 0;
+  bool ok = true;
+  for (unsigned int pass = 0; pass < 2 && ok; pass++)
+    {
+      unsigned int c = (pass == 0 ? c1 : c2);
+      if (c >= _alpha_size)
+        break;
+      for (unsigned int j = _occ_start[c]; j < _occ_start[c + 1]; j++)
+        {
+          unsigned int k = _occ_keywords[j];
+          if (pass > 0 && contains (k, c1))
+            /* Already done in the first pass.  */
+            continue;
+          int h = hash (k);
+          int owner;
+          if (h > bound
+              || ((owner = _owner[h]) >= 0
+                  && !contains (owner, c1)
+                  && !(c2 < _alpha_size && contains (owner, c2)))
+              || _detector->set_bit (h))
+            {
+              ok = false;
+              break;
+            }
+          _affected[count] = k;
+          _new_hashes[count] = h;
+          count++;
+        }
+    }
+
+  if (!ok)
+    {
+      _asso_values[c1] = old_v1;
+      if (c2 < _alpha_size)
+        _asso_values[c2] = old_v2;
+      return false;
+    }
+
+  for (unsigned int j = 0; j < count; j++)
+    _owner[_hashes[_affected[j]]] = -1;
+  for (unsigned int j = 0; j < count; j++)
+    {
+      unsigned int k = _affected[j];
+      _hashes[k] = _new_hashes[j];
+      _owner[_hashes[k]] = k;
+    }
+  return true;
+}
+
+bool
+Range_Minimizer::lower_maximum ()
+{
+  const KeywordExt *keyword = _keywords[_owner[_max_hash_value]];
+  int bound = _max_hash_value - 1;
+  bool found = false;
+
+  /* Try a smaller value for one of the keyword's characters.  */
+  for (int i = 0; i < keyword->_selchars_length && !found; i++)
+    {
+      unsigned int c = keyword->_selchars[i];
+      if (_occ_start[c] < _occ_start[c + 1])
+        {
+          for (int v = 0; v < _asso_values[c]; v++)
+            if (try_change (c, v, _alpha_size, 0, bound))
+              {
+                found = true;
+                break;
+              }
+        }
+    }
+
+  /* Try to exchange the value of one of the keyword's characters with the
+     smaller value of another character.  */
+  for (int i = 0; i < keyword->_selchars_length && !found; i++)
+    {
+      unsigned int c1 = keyword->_selchars[i];
+      if (_occ_start[c1] < _occ_start[c1 + 1])
+        {
+          for (unsigned int c2 = 0; c2 < _alpha_size; c2++)
+            if (_occ_start[c2] < _occ_start[c2 + 1]
+                && _asso_values[c2] < _asso_values[c1]
+                && try_change (c1, _asso_values[c2], c2, _asso_values[c1], bound))
+              {
+                found = true;
+                break;
+              }
+        }
+    }
+
+  if (found)
+    while (_owner[_max_hash_value] < 0)
+      _max_hash_value--;
+  return found;
+}
+
+bool
+Range_Minimizer::lower_values ()
+{
+  bool lowered = false;
+
+  for (unsigned int c = 0; c < _alpha_size; c++)
+    if (_occ_start[c] < _occ_start[c + 1])
+      {
+        for (int v = 0; v < _asso_values[c]; v++)
+          if (try_change (c, v, _alpha_size, 0, _max_hash_value))
+            {
+              lowered = true;
+              break;
+            }
+      }
+
+  if (lowered)
+    while (_owner[_max_hash_value] < 0)
+      _max_hash_value--;
+  return lowered;
+}
+
+int
+Range_Minimizer::minimize ()
+{
+  /* Both kinds of steps make progress: lower_maximum lowers the maximum
+     hash value, and lower_values lowers the sum of the values.  Lower
+     values make room for the next attempts of lower_maximum.  */
+  for (;;)
+    {
+      bool progress = false;
+      while (lower_maximum ())
+        progress = true;
+      if (lower_values ())
+        progress = true;
+      if (!progress)
+        break;
+    }
+  return _max_hash_value;
+}
+
+/* Lowers the maximum hash value of the found _asso_values[] through local
+   search.  */
+
+void
+Search::minimize_range ()
+{
+  Range_Minimizer minimizer (_head, _alpha_size, _occurrences,
+                             _hash_includes_len, _asso_values,
+                             _collision_detector);
+  int max_hash_value = minimizer.minimize ();
+
+  _range_moves += minimizer.get_moves ();
+  if (option[DEBUG])
+    fprintf (stderr, "Range minimization: maximum hash value %d -> %d, after %lu moves.\n",
+             minimizer.get_initial_max_hash_value (), max_hash_value,
+             minimizer.get_moves ());
+}
+
+/* A range of restarts, run by one thread: the restarts with indices
+   _first, _first + _stride, ... below _count.  */
+struct Restart_Range
+{
+  Search **             _restarts;
+  int                   _count;
+  int                   _first;
+  int                   _stride;
+#if HAVE_PTHREAD
+  pthread_t             _thread;
+#endif
+};
+
+void *
+Search::run_restarts (void *arg)
+{
+  Restart_Range *range = static_cast<Restart_Range *>(arg);
+  for (int i = range->_first; i < range->_count; i += range->_stride)
+    range->_restarts[i]->find_asso_values ();
+  return NULL;
+}
+
+/* Finds _asso_values[] through several independent random searches.  The
+   random numbers of each restart are derived from _seed and the index of
+   the restart, and the best result is chosen in the order of the indices.
+   Therefore the result does not depend on the number of threads.  */
+
+void
+Search::find_asso_values_with_restarts (int restart_count)
+{
+  Search **restarts = new Search*[restart_count];
+  for (int i = 0; i < restart_count; i++)
+    {
+      Search *restart = new Search (*this);
+      restart->_shared = true;
+      restart->_asso_values = new int[_alpha_size];
+      restart->_collision_detector = new Bool_Array (_max_hash_value + 1);
+      restart->_random.seed (Random::derive_seed (_seed, i));
+      restart->_threads = 1;
+      restart->_asso_values_tried = 0;
+      restart->_backtracking_steps = 0;
+      restart->_monitor = NULL;
+      restarts[i] = restart;
+    }
+
+  /* With -d, run the restarts one after the other, so that their debugging
+     output is not interleaved.  */
+  int thread_count = (option[DEBUG] ? 1 : _threads);
+  if (thread_count > restart_count)
+    thread_count = restart_count;
+  Restart_Range *ranges = new Restart_Range[thread_count];
+  for (int t = 0; t < thread_count; t++)
+    {
+      ranges[t]._restarts = restarts;
+      ranges[t]._count = restart_count;
+      ranges[t]._first = t;
+      ranges[t]._stride = thread_count;
+    }
+#if HAVE_PTHREAD
+  if (thread_count > 1)
+    {
+      bool *started = new bool[thread_count];
+      for (int t = 1; t < thread_count; t++)
+        started[t] =
+          (pthread_create (&ranges[t]._thread, NULL, run_restarts, &ranges[t])
+           == 0);
+      run_restarts (&ranges[0]);
+      for (int t = 1; t < thread_count; t++)
+        {
+          if (started[t])
+            pthread_join (ranges[t]._thread, NULL);
+          else
+            run_restarts (&ranges[t]);
+        }
+      delete[] started;
+    }
+  else
+#endif
+    for (int t = 0; t < thread_count; t++)
+      run_restarts (&ranges[t]);
+  delete[] ranges;
+
+  /* Choose the restart with the fewest collisions and, among these, with
+     the lowest lookup cost and the smallest maximum hash value.  */
+  int best = 0;
+  int best_collisions = INT_MAX;
+  double best_cost = 0.0;
+  int best_max_hash_value = INT_MAX;
+  for (int i = 0; i < restart_count; i++)
+    {
+      Search *restart = restarts[i];
+      int collisions = 0;
+      int max_hash_value = INT_MIN;
+      restart->_collision_detector->clear ();
+      for (KeywordExt_List *ptr = _head; ptr; ptr = ptr->rest())
+        {
+          int hashcode = restart->compute_hash (ptr->first());
+          if (max_hash_value < hashcode)
+            max_hash_value = hashcode;
+          if (restart->_collision_detector->set_bit (hashcode))
+            collisions++;
+        }
+      double cost = estimate_cost (max_hash_value)._total;
+      if (option[DEBUG])
+        fprintf (stderr, "Restart %d: %d collisions, maximum hash value %d, lookup cost %.2f.\n",
+                 i, collisions, max_hash_value, cost);
+      if (collisions < best_collisions
+          || (collisions == best_collisions
+              && (cost < best_cost
+                  || (cost == best_cost
+                      && max_hash_value < best_max_hash_value))))
+        {
+          best = i;
+          best_collisions = collisions;
+          best_cost = cost;
+          best_max_hash_value = max_hash_value;
+        }
+      _asso_values_tried += restart->_asso_values_tried;
+      _backtracking_steps += restart->_backtracking_steps;
+    }
+
+  /* Install the best restart's results.  Its _collision_detector has room
+     for its hash values.  */
+  Search *restart = restarts[best];
+  memcpy (_asso_values, restart->_asso_values,
+          _alpha_size * sizeof (_asso_values[0]));
+  _asso_value_max = restart->_asso_value_max;
+  _max_hash_value = restart->_max_hash_value;
+  Bool_Array *detector = _collision_detector;
+  _collision_detector = restart->_collision_detector;
+  restart->_collision_detector = detector;
+
+  for (int i = 0; i < restart_count; i++)
+    delete restarts[i];
+  delete[] restarts;
+}
+
 /* Finds good _asso_values[].  */
 
 void
 Search::find_good_asso_values ()
 {
   prepare_asso_values ();
+  if (_stopped)
+    return;
 
   /* Search for good _asso_values[].  */
   int asso_iteration;
   if ((asso_iteration = option.get_asso_iterations ()) == 0)
-    /* Try only the given _initial_asso_value and _jump.  */
-    find_asso_values ();
+    {
+      /* Try only the given _initial_asso_value and _jump.  */
+      find_asso_values ();
+      if (_stopped)
+        return;
+    }
+  else if (option[RANDOM])
+    /* Try different random numbers.  */
+    find_asso_values_with_restarts (asso_iteration);
   else
     {
       /* Try different pairs of _initial_asso_value and _jump, in the
@@ -1520,6 +3073,7 @@ Search::find_good_asso_values ()
       int best_jump = 1;
       int *best_asso_values = new int[_alpha_size];
       int best_collisions = INT_MAX;
+      double best_cost = 0.0;
       int best_max_hash_value = INT_MAX;
 
       _initial_asso_value = 0; _jump = 1;
@@ -1542,13 +3096,22 @@ Search::find_good_asso_values ()
               if (_collision_detector->set_bit (hashcode))
                 collisions++;
             }
+          /* Among the solutions with the fewest collisions, prefer the
+             lowest lookup cost, then the smallest maximum hash value.  */
+          double cost = estimate_cost (max_hash_value)._total;
+          if (option[DEBUG])
+            fprintf (stderr, "Iteration (%d, %d): %d collisions, maximum hash value %d, lookup cost %.2f.\n",
+                     _initial_asso_value, _jump, collisions, max_hash_value, cost);
           if (collisions < best_collisions
               || (collisions == best_collisions
-                  && max_hash_value < best_max_hash_value))
+                  && (cost < best_cost
+                      || (cost == best_cost
+                          && max_hash_value < best_max_hash_value))))
             {
               memcpy (best_asso_values, _asso_values,
                       _alpha_size * sizeof (_asso_values[0]));
               best_collisions = collisions;
+              best_cost = cost;
               best_max_hash_value = max_hash_value;
             }
           /* Delete the copied keyword list.  */
@@ -1571,6 +3134,11 @@ Search::find_good_asso_values ()
       delete[] best_asso_values;
       /* The keywords' _hash_value fields are recomputed below.  */
     }
+
+  if (option.get_solver_limit () > 0)
+    solve_asso_values ();
+  if (option[MINRANGE])
+    minimize_range ();
 }
 
 /* ========================================================================= */
@@ -1590,20 +3158,65 @@ Search::sort ()
   _head = mergesort_list (_head, less_by_hash_value);
 }
 
+/* Estimates the lookup cost of the generated code.  */
+
+Lookup_Cost
+Search::estimate_cost (int max_hash_value) const
+{
+  return _cost_model->estimate (_key_positions,
+                                _alpha_reduced ? 16 : _alpha_size,
+                                max_hash_value);
+}
+
+/* Adds the counters of this search to the global statistics.  */
+
+void
+Search::add_statistics () const
+{
+  stats.lock ();
+  stats._positions_tried += _positions_tried;
+  stats._alpha_incs_tried += _alpha_incs_tried;
+  stats._asso_values_tried += _asso_values_tried;
+  stats._backtracking_steps += _backtracking_steps;
+  stats._solver_nodes += _solver_nodes;
+  stats._range_moves += _range_moves;
+  stats.unlock ();
+}
+
 void
 Search::optimize ()
 {
   /* Preparations.  */
+  start_phase (PHASE_PREPARE);
   prepare ();
+  stop_phase (PHASE_PREPARE);
 
   /* Step 1: Finding good byte positions.  */
+  start_phase (PHASE_FIND_POSITIONS);
   find_positions ();
+  stop_phase (PHASE_FIND_POSITIONS);
 
   /* Step 2: Finding good alpha increments.  */
+  start_phase (PHASE_FIND_ALPHA_INC);
   find_alpha_inc ();
+  stop_phase (PHASE_FIND_ALPHA_INC);
+
+  /* Step 2b: Reducing the alphabet.  */
+  if (option[REDUCE])
+    {
+      start_phase (PHASE_FIND_ALPHA_REDUCTION);
+      find_alpha_reduction ();
+      stop_phase (PHASE_FIND_ALPHA_REDUCTION);
+    }
 
   /* Step 3: Finding good asso_values.  */
+  start_phase (PHASE_FIND_GOOD_ASSO_VALUES);
   find_good_asso_values ();
+  stop_phase (PHASE_FIND_GOOD_ASSO_VALUES);
+
+  add_statistics ();
+  if (_stopped)
+    return;
 
   /* Make one final check, just to make sure nothing weird happened.... */
   _collision_detector->clear ();
@@ -1643,6 +3256,18 @@ Search::optimize ()
     if (_occurrences[c] == 0)
       _asso_values[c] = max_hash_value + 1;
 
+  /* Report the estimated lookup cost.  */
+  Lookup_Cost cost = estimate_cost (max_hash_value);
+  if (_monitor == NULL)
+    stats._lookup_cost = cost._total;
+  if (option[DEBUG])
+    fprintf (stderr, "\nLookup cost: hash function %.2f, tables %u bytes %.2f,"
+             " comparison %.2f for a hit and %.2f for a miss"
+             " (first character discrimination %.2f), total %.2f\n",
+             cost._hash, cost._table_bytes, cost._memory,
+             cost._hit_compare, cost._miss_compare,
+             _cost_model->get_first_char_discrimination (), cost._total);
+
   /* Propagate unified asso_values.  */
   if (_alpha_unify)
     {
@@ -1657,7 +3282,13 @@ Search::optimize ()
 Search::~Search ()
 {
   delete _collision_detector;
-  if (option[DEBUG])
+  if (_shared)
+    {
+      /* A restart owns only its _asso_values[].  */
+      delete[] _asso_values;
+      return;
+    }
+  if (option[DEBUG] && !_stopped)
     {
       fprintf (stderr, "\ndumping occurrence and associated values tables\n");
 
@@ -1693,4 +3324,5 @@ Search::~Search ()
   delete[] _occurrences;
   delete[] _alpha_unify;
   delete[] _alpha_inc;
+  delete _cost_model;
 }
@@ -24,19 +24,85 @@
 #ifndef search_h
 #define search_h 1
 
+#include <stddef.h>
+
 #include "keyword-list.h"
 #include "positions.h"
 #include "bool-array.h"
+#include "random.h"
+#include "stats.h"
+#include "cost.h"
+
+struct Step;
+class Search;
 
-struct EquivalenceClass;
+/* The settings of a search that a portfolio search varies.  By default,
+   they come from the command line options.  */
+
+struct Search_Settings
+{
+  /* Initializes the settings from the command line options.  */
+                        Search_Settings ();
+
+  /* Whether the key positions are given, and the given key positions.  */
+  bool                  _positions_given;
+  Positions             _key_positions;
+  /* Whether the keyword length must not be included in the hash function.  */
+  bool                  _no_length;
+  /* Factor by which to multiply the number of keywords, giving the range of
+     the asso_values[].  */
+  float                 _size_multiple;
+  /* Seed of the random numbers, or -1 to take it from the time.  */
+  int                   _seed;
+  /* Number of threads that the search may use.  */
+  int                   _threads;
+};
+
+/* A Search_Monitor can stop a search that cannot lead to a better result
+   than some other search.  */
+
+class Search_Monitor
+{
+public:
+  virtual               ~Search_Monitor ();
+
+  /* Returns true if SEARCH should stop.  MAX_HASH_VALUE_BOUND is a lower
+     bound of its final maximum hash value.  This is called when the key
+     positions are known, and again after each step of the search for
+     the asso_values[].  */
+  virtual bool          stop (const Search *search, int max_hash_value_bound) = 0;
+};
 
 class Search
 {
 public:
-                        Search (KeywordExt_List *list);
+                        Search (KeywordExt_List *list, const Search_Settings& settings = Search_Settings ());
                         ~Search ();
   void                  optimize ();
+
+  /* Lets MONITOR stop the search early.  A monitored search also doesn't
+     exit when there are duplicate keywords without -D; it stops instead.  */
+  void                  set_monitor (Search_Monitor *monitor) { _monitor = monitor; }
+
+  /* Returns true if the search was stopped before it found a result.  */
+  bool                  was_stopped () const { return _stopped; }
+
+  /* Estimates the lookup cost of the generated code, for the key positions
+     and a given maximum hash value.  Valid after the key positions have
+     been found.  */
+  Lookup_Cost           estimate_cost (int max_hash_value) const;
 private:
+  /* Marks the beginning and the end of a phase.  The phases of a monitored
+     search are not timed, since it may run concurrently with other
+     searches.  */
+  void                  start_phase (Stats_Phase phase) const
+                          { if (_monitor == NULL) stats.start (phase); }
+  void                  stop_phase (Stats_Phase phase) const
+                          { if (_monitor == NULL) stats.stop (phase); }
+
+  /* Adds the counters of this search to the global statistics.  */
+  void                  add_statistics () const;
+
   void                  prepare ();
 
   /* Computes the upper bound on the indices passed to asso_values[],
@@ -74,25 +140,48 @@ private:
      and a given alpha_inc[] array.  */
   unsigned int          count_duplicates_multiset (const unsigned int *alpha_inc) const;
 
+  /* Performs rounds of incrementing alpha_inc[] until the number of
+     duplicates drops to duplicates_goal.  */
+  bool                  improve_alpha_inc (unsigned int *alpha_inc, unsigned int duplicates_count, unsigned int duplicates_goal, unsigned int max_inc) const;
+
   /* Find good _alpha_inc[].  */
   void                  find_alpha_inc ();
 
+  /* Tries to reduce the alphabet to 16 character classes.  */
+  void                  find_alpha_reduction ();
+
   /* Initializes the asso_values[] related parameters.  */
   void                  prepare_asso_values ();
 
-  EquivalenceClass *    compute_partition (bool *undetermined) const;
+  /* Advances the _asso_values[] of a step's characters to the next
+     candidate.  */
+  void                  next_asso_values (Step *step, unsigned int *iter, unsigned int& ii);
 
-  unsigned int          count_possible_collisions (EquivalenceClass *partition, unsigned int c) const;
-
-  bool                  unchanged_partition (EquivalenceClass *partition, unsigned int c) const;
+  /* Asks the monitor whether the search should stop.  */
+  bool                  should_stop (int max_hash_value_bound);
 
   /* Finds some _asso_values[] that fit.  */
   void                  find_asso_values ();
 
+  /* Finds _asso_values[] through several independent random searches, and
+     keeps the best result.  */
+  void                  find_asso_values_with_restarts (int restart_count);
+
+  /* Thread entry point: runs find_asso_values on a range of restarts.  */
+  static void *         run_restarts (void *arg);
+
   /* Computes a keyword's hash value, relative to the current _asso_values[],
      and stores it in keyword->_hash_value.  */
   int                   compute_hash (KeywordExt *keyword) const;
 
+  /* Lowers the maximum hash value of the found _asso_values[] through an
+     exact search.  */
+  void                  solve_asso_values ();
+
+  /* Lowers the maximum hash value of the found _asso_values[] through local
+     search.  */
+  void                  minimize_range ();
+
   /* Finds good _asso_values[].  */
   void                  find_good_asso_values ();
 
@@ -129,6 +218,10 @@ public:
      upper case characters to lower case characters (and maybe more).  */
   unsigned int *        _alpha_unify;
 
+  /* Whether the alphabet is reduced to 16 classes: asso_values[c] depends
+     only on c mod 16.  */
+  bool                  _alpha_reduced;
+
   /* Maximum _selchars_length over all keywords.  */
   unsigned int          _max_selchars_length;
 
@@ -161,6 +254,41 @@ private:
 
   /* Sparse bit vector for collision detection.  */
   Bool_Array *          _collision_detector;
+
+  /* The cost model of the lookup function.  */
+  Cost_Model *          _cost_model;
+
+  /* Seed of the random numbers, and their generator.  */
+  unsigned int          _seed;
+  Random                _random;
+
+  /* Number of threads that find_asso_values may use.  */
+  int                   _threads;
+
+  /* Counters for the statistics.  They are added to the global statistics
+     at the end of optimize, so that the searches of several threads don't
+     update them concurrently.  */
+  mutable unsigned long _positions_tried;
+  mutable unsigned long _alpha_incs_tried;
+  unsigned long         _asso_values_tried;
+  unsigned long         _backtracking_steps;
+  unsigned long         _solver_nodes;
+  unsigned long         _range_moves;
+
+  /* The settings of this search.  */
+  Search_Settings       _settings;
+
+  /* The monitor, or NULL.  */
+  Search_Monitor *      _monitor;
+
+  /* Whether the monitor has stopped the search, or the search has found
+     duplicate keywords without -D.  */
+  bool                  _stopped;
+
+  /* Whether this object is a restart of a random search.  It then shares
+     everything but _asso_values[], _collision_detector and the random
+     number generator with the original Search object.  */
+  bool                  _shared;
 };
 
 #endif
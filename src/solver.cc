@@ -0,0 +1,353 @@
+/* Exact search for associated values.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of GNU GPERF.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Specification. */
+#include "solver.h"
+
+#include <stddef.h>
+
+Solver::Solver (KeywordExt_List *list, unsigned int alpha_size, const int *occurrences, bool hash_includes_len)
+  : _n (0),
+    _hash_includes_len (hash_includes_len),
+    _var_count (0),
+    _max_hash_value (0),
+    _taken (NULL),
+    _nodes (0),
+    _node_limit (0),
+    _total_nodes (0)
+{
+  for (KeywordExt_List *temp = list; temp; temp = temp->rest())
+    _n++;
+  _keywords = new KeywordExt*[_n];
+  {
+    unsigned int k = 0;
+    for (KeywordExt_List *temp = list; temp; temp = temp->rest())
+      _keywords[k++] = temp->first();
+  }
+
+  /* Count, for each character, the keywords in which it occurs.  */
+  unsigned int *char_keywords = new unsigned int[alpha_size];
+  /* For each character, the last keyword in which it was seen, plus 1.  */
+  unsigned int *seen = new unsigned int[alpha_size];
+  for (unsigned int c = 0; c < alpha_size; c++)
+    {
+      char_keywords[c] = 0;
+      seen[c] = 0;
+    }
+  _var_counts = new unsigned int[_n];
+  unsigned int total = 0;
+  for (unsigned int k = 0; k < _n; k++)
+    {
+      const KeywordExt *keyword = _keywords[k];
+      _var_counts[k] = 0;
+      for (int i = 0; i < keyword->_selchars_length; i++)
+        {
+          unsigned int c = keyword->_selchars[i];
+          if (seen[c] != k + 1)
+            {
+              seen[c] = k + 1;
+              char_keywords[c]++;
+              _var_counts[k]++;
+              total++;
+            }
+        }
+    }
+
+  /* Choose the order of the variables.  A keyword's hash value is known
+     when its last variable is assigned; the earlier this happens, the
+     earlier collisions are detected.  Therefore, choose next the variable
+     that completes the most keywords, then the one that occurs in the most
+     keywords.  */
+  _vars = new unsigned int[alpha_size];
+  {
+    unsigned int *remaining = new unsigned int[_n];
+    for (unsigned int k = 0; k < _n; k++)
+      remaining[k] = _var_counts[k];
+    bool *chosen = new bool[alpha_size];
+    for (unsigned int c = 0; c < alpha_size; c++)
+      chosen[c] = !(occurrences[c] > 0 && char_keywords[c] > 0);
+    unsigned int *completes = new unsigned int[alpha_size];
+
+    for (;;)
+      {
+        for (unsigned int c = 0; c < alpha_size; c++)
+          {
+            completes[c] = 0;
+            seen[c] = 0;
+          }
+        for (unsigned int k = 0; k < _n; k++)
+          if (remaining[k] == 1)
+            {
+              const KeywordExt *keyword = _keywords[k];
+              for (int i = 0; i < keyword->_selchars_length; i++)
+                {
+                  unsigned int c = keyword->_selchars[i];
+                  if (!chosen[c] && seen[c] != k + 1)
+                    {
+                      seen[c] = k + 1;
+                      completes[c]++;
+                    }
+                }
+            }
+
+        unsigned int best = alpha_size;
+        for (unsigned int c = 0; c < alpha_size; c++)
+          if (!chosen[c]
+              && (best == alpha_size
+                  || completes[c] > completes[best]
+                  || (completes[c] == completes[best]
+                      && char_keywords[c] > char_keywords[best])))
+            best = c;
+        if (best == alpha_size)
+          break;
+
+        chosen[best] = true;
+        _vars[_var_count++] = best;
+        for (unsigned int k = 0; k < _n; k++)
+          {
+            const KeywordExt *keyword = _keywords[k];
+            for (int i = 0; i < keyword->_selchars_length; i++)
+              if (keyword->_selchars[i] == best)
+                {
+                  remaining[k]--;
+                  break;
+                }
+          }
+      }
+
+    delete[] completes;
+    delete[] chosen;
+    delete[] remaining;
+  }
+
+  /* For each variable, list the keywords in which it occurs.  */
+  unsigned int *depth_of = new unsigned int[alpha_size];
+  for (unsigned int d = 0; d < _var_count; d++)
+    depth_of[_vars[d]] = d;
+  _occ_start = new unsigned int[_var_count + 1];
+  _occ_start[0] = 0;
+  for (unsigned int d = 0; d < _var_count; d++)
+    _occ_start[d + 1] = _occ_start[d] + char_keywords[_vars[d]];
+  _occ_keywords = new unsigned int[total];
+  _occ_counts = new unsigned int[total];
+  {
+    unsigned int *fill = new unsigned int[_var_count];
+    for (unsigned int d = 0; d < _var_count; d++)
+      fill[d] = _occ_start[d];
+    for (unsigned int c = 0; c < alpha_size; c++)
+      seen[c] = 0;
+    for (unsigned int k = 0; k < _n; k++)
+      {
+        const KeywordExt *keyword = _keywords[k];
+        for (int i = 0; i < keyword->_selchars_length; i++)
+          {
+            unsigned int c = keyword->_selchars[i];
+            unsigned int d = depth_of[c];
+            if (seen[c] != k + 1)
+              {
+                seen[c] = k + 1;
+                _occ_keywords[fill[d]] = k;
+                _occ_counts[fill[d]] = 0;
+                fill[d]++;
+              }
+            _occ_counts[fill[d] - 1]++;
+          }
+      }
+    delete[] fill;
+  }
+
+  delete[] depth_of;
+  delete[] seen;
+  delete[] char_keywords;
+
+  _partial = new int[_n];
+  _unassigned = new unsigned int[_n];
+  _values = new int[_var_count];
+  _preferred = new int[_var_count];
+}
+
+Solver::~Solver ()
+{
+  delete[] _preferred;
+  delete[] _values;
+  delete[] _unassigned;
+  delete[] _partial;
+  delete[] _occ_counts;
+  delete[] _occ_keywords;
+  delete[] _occ_start;
+  delete[] _vars;
+  delete[] _var_counts;
+  delete[] _keywords;
+}
+
+/* Assigns VALUE to the variable at DEPTH.  */
+bool
+Solver::assign (unsigned int depth, int value)
+{
+  unsigned int begin = _occ_start[depth];
+  unsigned int end = _occ_start[depth + 1];
+  for (unsigned int i = begin; i < end; i++)
+    {
+      unsigned int k = _occ_keywords[i];
+      _partial[k] += _occ_counts[i] * value;
+      if (--_unassigned[k] == 0)
+        {
+          if (_taken[_partial[k]])
+            {
+              /* Collision.  Undo the changes made so far.  */
+              _partial[k] -= _occ_counts[i] * value;
+              _unassigned[k]++;
+              while (i > begin)
+                {
+                  i--;
+                  k = _occ_keywords[i];
+                  if (_unassigned[k] == 0)
+                    _taken[_partial[k]] = false;
+                  _partial[k] -= _occ_counts[i] * value;
+                  _unassigned[k]++;
+                }
+              return false;
+            }
+          _taken[_partial[k]] = true;
+        }
+    }
+  return true;
+}
+
+/* Undoes assign.  */
+void
+Solver::unassign (unsigned int depth, int value)
+{
+  unsigned int begin = _occ_start[depth];
+  for (unsigned int i = _occ_start[depth + 1]; i > begin; )
+    {
+      i--;
+      unsigned int k = _occ_keywords[i];
+      if (_unassigned[k] == 0)
+        _taken[_partial[k]] = false;
+      _partial[k] -= _occ_counts[i] * value;
+      _unassigned[k]++;
+    }
+}
+
+/* Tries the values of the variables starting at DEPTH.  */
+bool
+Solver::search (unsigned int depth)
+{
+  if (depth == _var_count)
+    return true;
+
+  /* The largest value that keeps the partial hash values of all keywords
+     with this variable within the bound.  */
+  int max_value = _max_hash_value;
+  for (unsigned int i = _occ_start[depth]; i < _occ_start[depth + 1]; i++)
+    {
+      int limit =
+        (_max_hash_value - _partial[_occ_keywords[i]]) / static_cast<int>(_occ_counts[i]);
+      if (max_value > limit)
+        max_value = limit;
+    }
+
+  /* Try the preferred value first, then the others in increasing order.  */
+  int preferred = _preferred[depth];
+  for (int attempt = -1; attempt <= max_value; attempt++)
+    {
+      int value;
+      if (attempt < 0)
+        {
+          if (preferred > max_value)
+            continue;
+          value = preferred;
+        }
+      else
+        {
+          if (attempt == preferred)
+            continue;
+          value = attempt;
+        }
+
+      if (++_nodes > _node_limit)
+        return false;
+      if (assign (depth, value))
+        {
+          _values[depth] = value;
+          if (search (depth + 1))
+            return true;
+          unassign (depth, value);
+          if (_nodes > _node_limit)
+            return false;
+        }
+    }
+  return false;
+}
+
+/* Searches associated values for which all keywords have different hash
+   values <= MAX_HASH_VALUE.  */
+Solver::Result
+Solver::solve (int max_hash_value, unsigned long node_limit, int *asso_values)
+{
+  /* There must be room for all hash values.  */
+  if (max_hash_value < 0
+      || static_cast<unsigned int>(max_hash_value) + 1 < _n)
+    return INFEASIBLE;
+
+  _max_hash_value = max_hash_value;
+  _taken = new bool[max_hash_value + 1];
+  for (int h = 0; h <= max_hash_value; h++)
+    _taken[h] = false;
+
+  /* The keywords without any variable have a fixed hash value.  */
+  Result result = UNKNOWN;
+  for (unsigned int k = 0; k < _n; k++)
+    {
+      _partial[k] = _hash_includes_len ? _keywords[k]->_allchars_length : 0;
+      _unassigned[k] = _var_counts[k];
+      if (_unassigned[k] == 0)
+        {
+          if (_partial[k] > max_hash_value || _taken[_partial[k]])
+            result = INFEASIBLE;
+          else
+            _taken[_partial[k]] = true;
+        }
+      else if (_partial[k] > max_hash_value)
+        result = INFEASIBLE;
+    }
+
+  if (result != INFEASIBLE)
+    {
+      for (unsigned int d = 0; d < _var_count; d++)
+        _preferred[d] = asso_values[_vars[d]];
+
+      _nodes = 0;
+      _node_limit = node_limit;
+      if (search (0))
+        {
+          for (unsigned int d = 0; d < _var_count; d++)
+            asso_values[_vars[d]] = _values[d];
+          result = FOUND;
+        }
+      else
+        result = (_nodes > _node_limit ? UNKNOWN : INFEASIBLE);
+      _total_nodes += (_nodes > _node_limit ? _node_limit : _nodes);
+    }
+
+  delete[] _taken;
+  _taken = NULL;
+  return result;
+}
@@ -0,0 +1,114 @@
+/* This may look like C code, but it is really -*- C++ -*- */
+
+/* Exact search for associated values.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of GNU GPERF.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#ifndef solver_h
+#define solver_h 1
+
+#include "keyword-list.h"
+
+/* A Solver decides whether there are associated values for which all
+   keywords have different hash values, none larger than a given bound.
+   It is a branch and bound search over the asso_values[c] of the characters
+   that occur in the keywords.  A hash value is known as soon as all of a
+   keyword's characters have their value, and a partial hash value is a
+   lower bound of the final one, since all values are nonnegative.  So the
+   search backtracks as soon as two complete keywords collide or a partial
+   hash value exceeds the bound.  The search explores a bounded number of
+   nodes; if it exhausts the search space before, it has proved that there
+   is no solution.  */
+
+class Solver
+{
+public:
+  /* The outcome of a search.  */
+  enum Result
+  {
+    /* Found associated values that satisfy the bound.  */
+    FOUND,
+    /* Proved that no associated values satisfy the bound.  */
+    INFEASIBLE,
+    /* Reached the node limit.  */
+    UNKNOWN
+  };
+
+  /* Prepares a search for the keywords in LIST.  The variables are the
+     asso_values[c] of the characters c < ALPHA_SIZE with
+     OCCURRENCES[c] > 0.  */
+                        Solver (KeywordExt_List *list, unsigned int alpha_size, const int *occurrences, bool hash_includes_len);
+                        ~Solver ();
+
+  /* Searches associated values for which all keywords have different hash
+     values <= MAX_HASH_VALUE, exploring at most NODE_LIMIT nodes.  The
+     values in ASSO_VALUES are tried first.  Upon success, the variables'
+     values are stored in ASSO_VALUES.  */
+  Result                solve (int max_hash_value, unsigned long node_limit, int *asso_values);
+
+  /* Returns the number of nodes explored by all searches so far.  */
+  unsigned long         get_nodes () const { return _total_nodes; }
+
+private:
+  /* Tries the values of the variables starting at DEPTH.  */
+  bool                  search (unsigned int depth);
+
+  /* Assigns VALUE to the variable at DEPTH.  Returns false, without any
+     change, if this makes two complete keywords collide.  */
+  bool                  assign (unsigned int depth, int value);
+  /* Undoes assign.  */
+  void                  unassign (unsigned int depth, int value);
+
+  /* Number of keywords.  */
+  unsigned int          _n;
+  /* Whether the hash function includes the length.  */
+  bool                  _hash_includes_len;
+  /* The keywords, in list order.  */
+  KeywordExt **         _keywords;
+
+  /* The variables, in the order in which they are assigned.  */
+  unsigned int *        _vars;
+  unsigned int          _var_count;
+  /* For the variable at depth d, the keywords in which it occurs and the
+     number of its occurrences in them, at indices
+     _occ_start[d] .. _occ_start[d+1]-1.  */
+  unsigned int *        _occ_start;
+  unsigned int *        _occ_keywords;
+  unsigned int *        _occ_counts;
+  /* For each keyword, the number of its distinct characters.  */
+  unsigned int *        _var_counts;
+
+  /* State of the current search.  */
+  /* Hash value bound.  */
+  int                   _max_hash_value;
+  /* For each keyword, the sum of the length and the assigned values.  */
+  int *                 _partial;
+  /* For each keyword, the number of its variables that are unassigned.  */
+  unsigned int *        _unassigned;
+  /* Which hash values are taken by complete keywords.  */
+  bool *                _taken;
+  /* The current and the preferred values of the variables.  */
+  int *                 _values;
+  int *                 _preferred;
+  /* Node counter and limit.  */
+  unsigned long         _nodes;
+  unsigned long         _node_limit;
+  unsigned long         _total_nodes;
+};
+
+#endif
@@ -0,0 +1,206 @@
+/* Timings and counters of a gperf run.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of GNU GPERF.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Specification. */
+#include "stats.h"
+
+#include <stdio.h>
+#include <time.h> /* declares clock(), time() */
+#include "config.h"
+#if HAVE_GETTIMEOFDAY
+# include <sys/time.h>
+#endif
+#if HAVE_GETRUSAGE
+# include <sys/resource.h>
+#endif
+#if HAVE_PTHREAD
+# include <pthread.h>
+#endif
+
+/* Global statistics for the entire program.  */
+Statistics stats;
+
+#if HAVE_PTHREAD
+/* Protects the counters of stats.  */
+static pthread_mutex_t counters_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* The names of the phases in the report.  */
+static const char * const phase_names[PHASE_COUNT] =
+{
+  "input",
+  "portfolio",
+  "prepare",
+  "find_positions",
+  "find_alpha_inc",
+  "find_alpha_reduction",
+  "find_good_asso_values",
+  "output"
+};
+
+/* Returns the current wall-clock time, in seconds.  */
+static double
+wall_clock ()
+{
+#if HAVE_GETTIMEOFDAY
+  struct timeval tv;
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+#else
+  return static_cast<double>(time (NULL));
+#endif
+}
+
+/* Returns the CPU time used by the process so far, in seconds.  */
+static double
+cpu_clock ()
+{
+  return static_cast<double>(clock ()) / CLOCKS_PER_SEC;
+}
+
+/* Returns the peak resident set size of the process, in kilobytes, or -1 if
+   it is not known.  */
+static long
+peak_rss ()
+{
+#if HAVE_GETRUSAGE
+  struct rusage usage;
+  if (getrusage (RUSAGE_SELF, &usage) == 0)
+# if defined __APPLE__
+    /* macOS reports it in bytes.  */
+    return usage.ru_maxrss / 1024;
+# else
+    return usage.ru_maxrss;
+# endif
+#endif
+  return -1;
+}
+
+Statistics::Statistics ()
+  : _positions_tried (0),
+    _alpha_incs_tried (0),
+    _asso_values_tried (0),
+    _backtracking_steps (0),
+    _bool_array_clears (0),
+    _bool_array_set_bits (0),
+    _hash_table_collisions (0),
+    _solver_nodes (0),
+    _range_moves (0),
+    _total_keys (0),
+    _total_duplicates (0),
+    _key_positions (0),
+    _asso_values_size (0),
+    _min_hash_value (0),
+    _max_hash_value (0),
+    _keyword_table_size (0),
+    _lookup_cost (0.0)
+{
+  for (int i = 0; i < PHASE_COUNT; i++)
+    {
+      _wall_time[i] = 0;
+      _cpu_time[i] = 0;
+      _wall_start[i] = 0;
+      _cpu_start[i] = 0;
+    }
+}
+
+/* Marks the beginning of a phase.  */
+void
+Statistics::start (Stats_Phase phase)
+{
+  _wall_start[phase] = wall_clock ();
+  _cpu_start[phase] = cpu_clock ();
+}
+
+/* Marks the end of a phase.  */
+void
+Statistics::stop (Stats_Phase phase)
+{
+  _wall_time[phase] += wall_clock () - _wall_start[phase];
+  _cpu_time[phase] += cpu_clock () - _cpu_start[phase];
+}
+
+/* Locks the counters.  */
+void
+Statistics::lock ()
+{
+#if HAVE_PTHREAD
+  pthread_mutex_lock (&counters_lock);
+#endif
+}
+
+/* Unlocks the counters.  */
+void
+Statistics::unlock ()
+{
+#if HAVE_PTHREAD
+  pthread_mutex_unlock (&counters_lock);
+#endif
+}
+
+/* Writes the report, in JSON format, to the given file.  */
+bool
+Statistics::write (const char *file_name) const
+{
+  FILE *stream = fopen (file_name, "w");
+  if (stream == NULL)
+    return false;
+
+  fprintf (stream, "{\n"
+                   "  \"phases\": {\n");
+  for (int i = 0; i < PHASE_COUNT; i++)
+    fprintf (stream, "    \"%s\": { \"wall_seconds\": %.6f, \"cpu_seconds\": %.6f }%s\n",
+             phase_names[i], _wall_time[i], _cpu_time[i],
+             i < PHASE_COUNT - 1 ? "," : "");
+  fprintf (stream, "  },\n");
+
+  fprintf (stream, "  \"counters\": {\n"
+                   "    \"positions_tried\": %lu,\n"
+                   "    \"alpha_incs_tried\": %lu,\n"
+                   "    \"asso_values_tried\": %lu,\n"
+                   "    \"backtracking_steps\": %lu,\n"
+                   "    \"bool_array_clears\": %lu,\n"
+                   "    \"bool_array_set_bits\": %lu,\n"
+                   "    \"hash_table_collisions\": %lu,\n"
+                   "    \"solver_nodes\": %lu,\n"
+                   "    \"range_moves\": %lu\n"
+                   "  },\n",
+           _positions_tried, _alpha_incs_tried, _asso_values_tried,
+           _backtracking_steps, _bool_array_clears, _bool_array_set_bits,
+           _hash_table_collisions, _solver_nodes, _range_moves);
+
+  fprintf (stream, "  \"peak_rss_kb\": %ld,\n", peak_rss ());
+
+  fprintf (stream, "  \"tables\": {\n"
+                   "    \"total_keywords\": %d,\n"
+                   "    \"total_duplicates\": %d,\n"
+                   "    \"key_positions\": %d,\n"
+                   "    \"asso_values_size\": %d,\n"
+                   "    \"min_hash_value\": %d,\n"
+                   "    \"max_hash_value\": %d,\n"
+                   "    \"keyword_table_size\": %d,\n"
+                   "    \"lookup_cost\": %.2f\n"
+                   "  }\n"
+                   "}\n",
+           _total_keys, _total_duplicates, _key_positions, _asso_values_size,
+           _min_hash_value, _max_hash_value, _keyword_table_size,
+           _lookup_cost);
+
+  return !(ferror (stream) | fclose (stream));
+}
@@ -0,0 +1,127 @@
+/* This may look like C code, but it is really -*- C++ -*- */
+
+/* Timings and counters of a gperf run.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of GNU GPERF.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#ifndef stats_h
+#define stats_h 1
+
+/* The phases of a gperf run that are timed.  */
+
+enum Stats_Phase
+{
+  /* Reading and parsing the input file.  */
+  PHASE_INPUT,
+  /* The portfolio search, which chooses the settings of the search.  */
+  PHASE_PORTFOLIO,
+  /* Search::prepare.  */
+  PHASE_PREPARE,
+  /* Step 1 of the search: finding good byte positions.  */
+  PHASE_FIND_POSITIONS,
+  /* Step 2 of the search: finding good alpha increments.  */
+  PHASE_FIND_ALPHA_INC,
+  /* Step 2b of the search: reducing the alphabet.  */
+  PHASE_FIND_ALPHA_REDUCTION,
+  /* Step 3 of the search: finding good asso_values.  */
+  PHASE_FIND_GOOD_ASSO_VALUES,
+  /* Generating the output code.  */
+  PHASE_OUTPUT,
+
+  PHASE_COUNT
+};
+
+/* Collects the wall-clock and CPU time of each phase, and some counters of
+   the search, for the report written with --stats.  */
+
+class Statistics
+{
+public:
+  /* Constructor.  */
+                        Statistics ();
+
+  /* Marks the beginning of a phase.  */
+  void                  start (Stats_Phase phase);
+  /* Marks the end of a phase.  Its time is added to the phase's total.  */
+  void                  stop (Stats_Phase phase);
+
+  /* Locks and unlocks the counters.  Code that may run in several threads
+     at once must update the counters only while they are locked.  */
+  void                  lock ();
+  void                  unlock ();
+
+  /* Writes the report, in JSON format, to the given file.
+     Returns false upon a write error.  */
+  bool                  write (const char *file_name) const;
+
+  /* Counters, incremented by the modules that do the work.  */
+
+  /* Number of key position sets whose duplicates were counted.  */
+  unsigned long         _positions_tried;
+  /* Number of alpha increments whose duplicates were counted.  */
+  unsigned long         _alpha_incs_tried;
+  /* Number of asso_values[] combinations tried in find_asso_values.  */
+  unsigned long         _asso_values_tried;
+  /* Number of times a step of find_asso_values exhausted its search space.
+     The search then widens that step's search space instead of going back
+     to an earlier step.  */
+  unsigned long         _backtracking_steps;
+  /* Number of Bool_Array::clear and Bool_Array::set_bit calls.  */
+  unsigned long         _bool_array_clears;
+  unsigned long         _bool_array_set_bits;
+  /* Number of collisions in all Hash_Table instances.  */
+  unsigned long         _hash_table_collisions;
+  /* Number of nodes explored by the exact search for asso_values.  */
+  unsigned long         _solver_nodes;
+  /* Number of moves tried by the local search that lowers the maximum hash
+     value.  */
+  unsigned long         _range_moves;
+
+  /* Final sizes, filled in when the output is generated.  */
+
+  /* Number of keywords, counting duplicates.  */
+  int                   _total_keys;
+  /* Number of keywords with a duplicate hash value.  */
+  int                   _total_duplicates;
+  /* Number of key positions used by the hash function, or -1 if all
+     characters are used.  */
+  int                   _key_positions;
+  /* Size of the asso_values table.  */
+  int                   _asso_values_size;
+  /* Minimum and maximum hash value.  */
+  int                   _min_hash_value;
+  int                   _max_hash_value;
+  /* Number of elements of the keyword table.  */
+  int                   _keyword_table_size;
+  /* Estimated cost of a lookup, see Cost_Model.  */
+  double                _lookup_cost;
+
+private:
+  /* Accumulated wall-clock time of each phase, in seconds.  */
+  double                _wall_time[PHASE_COUNT];
+  /* Accumulated CPU time of each phase, in seconds.  */
+  double                _cpu_time[PHASE_COUNT];
+  /* Wall-clock and CPU time at the start of each phase.  */
+  double                _wall_start[PHASE_COUNT];
+  double                _cpu_start[PHASE_COUNT];
+};
+
+/* Global statistics for the entire program.  */
+extern Statistics stats;
+
+#endif
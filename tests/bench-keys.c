@@ -0,0 +1,123 @@
+/*
+   Prepares the keyword sets for the benchmark suite.
+   Usage: bench-keys COUNT [SEED]
+          bench-keys --keywords FILE
+   The first form prints COUNT different identifiers, one per line.  Each
+   identifier is a pseudo-random prefix of 2 to 9 lowercase letters followed
+   by a distinct serial number, so that the output only depends on COUNT and
+   SEED.
+   The second form prints the keywords of the gperf input FILE, one per line,
+   for use as a lookup corpus.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LEN 4096
+
+/* A linear congruential generator, independent of the C library.  */
+static unsigned long state;
+
+static unsigned int
+next_random (void)
+{
+  state = (state * 1103515245UL + 12345UL) & 0xffffffffUL;
+  return (unsigned int) (state >> 16);
+}
+
+/* Prints the keywords of a gperf input file: the first field of each line
+   of the keywords section, without the quotes of a quoted keyword.  */
+static int
+print_keywords (const char *file_name)
+{
+  FILE *fp = fopen (file_name, "r");
+  char line[MAX_LEN];
+  int has_sections = 0;
+  int section = 0;
+
+  if (fp == NULL)
+    return 1;
+
+  /* If the file has no "%%" line, it consists of keywords only.  */
+  while (fgets (line, MAX_LEN, fp))
+    if (strncmp (line, "%%", 2) == 0)
+      has_sections = 1;
+  rewind (fp);
+  if (!has_sections)
+    section = 1;
+
+  while (fgets (line, MAX_LEN, fp))
+    {
+      size_t len = strcspn (line, "\r\n");
+      line[len] = '\0';
+
+      if (strncmp (line, "%%", 2) == 0)
+        {
+          if (++section > 1)
+            break;
+          continue;
+        }
+      if (section != 1 || line[0] == '#' || len == 0)
+        continue;
+
+      if (line[0] == '"')
+        {
+          char *end = strchr (line + 1, '"');
+          if (end != NULL)
+            *end = '\0';
+          puts (line + 1);
+        }
+      else
+        {
+          line[strcspn (line, ",")] = '\0';
+          puts (line);
+        }
+    }
+
+  fclose (fp);
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+  long count;
+  long i;
+
+  if (argc == 3 && strcmp (argv[1], "--keywords") == 0)
+    return print_keywords (argv[2]);
+
+  if (argc < 2 || (count = atol (argv[1])) < 0)
+    {
+      fprintf (stderr, "Usage: %s COUNT [SEED]\n"
+                       "       %s --keywords FILE\n", argv[0], argv[0]);
+      return 1;
+    }
+  state = (argc > 2 ? strtoul (argv[2], NULL, 10) : 1);
+
+  for (i = 0; i < count; i++)
+    {
+      char buf[32];
+      int len = 2 + next_random () % 8;
+      int pos = 0;
+      long n = i;
+      int j;
+
+      for (j = 0; j < len; j++)
+        buf[pos++] = 'a' + next_random () % 26;
+      /* The serial number, in base 36, makes the identifiers distinct.  */
+      buf[pos++] = '_';
+      do
+        {
+          buf[pos++] = digits[n % 36];
+          n /= 36;
+        }
+      while (n > 0);
+      buf[pos] = '\0';
+      puts (buf);
+    }
+
+  return ferror (stdout) ? 1 : 0;
+}
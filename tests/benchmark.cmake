@@ -0,0 +1,188 @@
+# Benchmark suite for gperf, run by the 'benchmark' target.
+#
+# For each tests/*.gperf file and for synthetic keyword sets of the sizes in
+# SIZES, runs gperf with --stats and --benchmark, compiles the result, runs
+# the generated benchmark driver over the keywords, and appends a line to
+# the CSV file OUTPUT.
+#
+# Variables (set with -D):
+#   GPERF         the gperf program
+#   BENCH_KEYS    the bench-keys program
+#   SRCDIR        the tests source directory
+#   WORKDIR       a directory for the generated files
+#   OUTPUT        the CSV file
+#   C_COMPILER    the C compiler, and CXX_COMPILER the C++ compiler
+#   COMPILER_MSVC true if the compilers take MSVC style options
+#   SIZES         sizes of the synthetic keyword sets, separated by spaces
+#   OPTIONS       additional gperf options, as a command line fragment
+#   TIMEOUT       time limit in seconds for each program run
+#   RUNS          number of measured runs of each lookup workload
+
+cmake_minimum_required(VERSION 3.11)
+
+separate_arguments(SIZES UNIX_COMMAND "${SIZES}")
+separate_arguments(GPERF_OPTIONS UNIX_COMMAND "${OPTIONS}")
+
+# Generated C++ code is compiled with the C++ compiler.
+set(language_cxx FALSE)
+if(OPTIONS MATCHES "C\\+\\+")
+    set(language_cxx TRUE)
+endif()
+
+file(MAKE_DIRECTORY ${WORKDIR})
+file(WRITE ${OUTPUT} "name,keywords,options,gperf_status,input_seconds,prepare_seconds,find_positions_seconds,find_alpha_inc_seconds,find_good_asso_values_seconds,output_seconds,peak_rss_kb,max_hash_value,lookup_cost,compile_status,hits_ns,misses_ns,mixed_ns\n")
+
+# Sets VAR to the number that follows "KEY": in the JSON text, or to the
+# empty string.
+function(json_number var json key)
+    set(value "")
+    if(json MATCHES "\"${key}\": ([-0-9.]+)")
+        set(value ${CMAKE_MATCH_1})
+    endif()
+    set(${var} "${value}" PARENT_SCOPE)
+endfunction()
+
+# Sets VAR to the wall-clock time of a phase in the JSON text.
+function(json_phase var json phase)
+    set(value "")
+    if(json MATCHES "\"${phase}\": { \"wall_seconds\": ([0-9.]+)")
+        set(value ${CMAKE_MATCH_1})
+    endif()
+    set(${var} "${value}" PARENT_SCOPE)
+endfunction()
+
+# Sets VAR to the median ns/lookup of a workload in the driver's report.
+function(report_median var report workload)
+    set(value "")
+    if(report MATCHES "\n${workload} +[0-9]+ +[0-9.]+ +([0-9.]+)")
+        set(value ${CMAKE_MATCH_1})
+    endif()
+    set(${var} "${value}" PARENT_SCOPE)
+endfunction()
+
+# Runs gperf with the given extra options.  Sets gperf_status and
+# compile_status in the caller's scope.
+macro(generate_and_compile extra_options)
+    file(REMOVE ${stats} ${source} ${program})
+    execute_process(
+        COMMAND ${GPERF} ${GPERF_OPTIONS} ${extra_options} --benchmark
+                --stats=${stats} --output-file=${source} ${input}
+        RESULT_VARIABLE rc
+        OUTPUT_QUIET ERROR_QUIET
+        TIMEOUT ${TIMEOUT})
+    if(rc STREQUAL "0")
+        set(gperf_status ok)
+    elseif(rc MATCHES "timeout")
+        set(gperf_status timeout)
+    else()
+        set(gperf_status failed)
+    endif()
+    set(compile_status skipped)
+    if(gperf_status STREQUAL "ok")
+        if(language_cxx)
+            set(compiler ${CXX_COMPILER})
+        else()
+            set(compiler ${C_COMPILER})
+        endif()
+        if(COMPILER_MSVC)
+            set(compile_command ${compiler} /nologo /O2 /Fe${program} ${source})
+        else()
+            set(compile_command ${compiler} -O2 -o ${program} ${source})
+        endif()
+        execute_process(
+            COMMAND ${compile_command}
+            WORKING_DIRECTORY ${WORKDIR}
+            RESULT_VARIABLE rc
+            OUTPUT_QUIET ERROR_QUIET)
+        if(rc STREQUAL "0")
+            set(compile_status ok)
+        else()
+            set(compile_status failed)
+        endif()
+    endif()
+endmacro()
+
+# Benchmarks the gperf input INPUT, looking up the words in CORPUS.
+function(benchmark name input corpus)
+    message(STATUS "Benchmarking ${name}")
+    set(stats ${WORKDIR}/${name}.json)
+    if(language_cxx)
+        set(source ${WORKDIR}/${name}.cc)
+    else()
+        set(source ${WORKDIR}/${name}.c)
+    endif()
+    set(program ${WORKDIR}/${name}${CMAKE_EXECUTABLE_SUFFIX})
+
+    # Inputs with a struct declaration need -t.  Fall back to the plain
+    # run if gperf rejects -t.
+    set(used_options "${OPTIONS}")
+    generate_and_compile("")
+    if(compile_status STREQUAL "failed")
+        generate_and_compile("-t")
+        string(STRIP "${OPTIONS} -t" used_options)
+        if(gperf_status STREQUAL "failed")
+            generate_and_compile("")
+            set(used_options "${OPTIONS}")
+        endif()
+    endif()
+
+    set(json "")
+    if(EXISTS ${stats})
+        file(READ ${stats} json)
+    endif()
+    json_number(keywords "${json}" total_keywords)
+    json_phase(input_seconds "${json}" input)
+    json_phase(prepare_seconds "${json}" prepare)
+    json_phase(find_positions_seconds "${json}" find_positions)
+    json_phase(find_alpha_inc_seconds "${json}" find_alpha_inc)
+    json_phase(find_good_asso_values_seconds "${json}" find_good_asso_values)
+    json_phase(output_seconds "${json}" output)
+    json_number(peak_rss_kb "${json}" peak_rss_kb)
+    json_number(max_hash_value "${json}" max_hash_value)
+    json_number(lookup_cost "${json}" lookup_cost)
+
+    set(hits_ns "")
+    set(misses_ns "")
+    set(mixed_ns "")
+    if(compile_status STREQUAL "ok")
+        execute_process(
+            COMMAND ${program} ${corpus} ${RUNS}
+            RESULT_VARIABLE rc
+            OUTPUT_VARIABLE report
+            ERROR_QUIET
+            TIMEOUT ${TIMEOUT})
+        if(rc STREQUAL "0")
+            report_median(hits_ns "\n${report}" hits)
+            report_median(misses_ns "\n${report}" misses)
+            report_median(mixed_ns "\n${report}" mixed)
+        else()
+            set(compile_status run_failed)
+        endif()
+    endif()
+
+    file(APPEND ${OUTPUT} "${name},${keywords},\"${used_options}\",${gperf_status},${input_seconds},${prepare_seconds},${find_positions_seconds},${find_alpha_inc_seconds},${find_good_asso_values_seconds},${output_seconds},${peak_rss_kb},${max_hash_value},${lookup_cost},${compile_status},${hits_ns},${misses_ns},${mixed_ns}\n")
+endfunction()
+
+# The keyword sets of the test suite.
+file(GLOB inputs ${SRCDIR}/*.gperf)
+list(SORT inputs)
+foreach(input ${inputs})
+    get_filename_component(name ${input} NAME_WE)
+    set(corpus ${WORKDIR}/${name}.words)
+    execute_process(
+        COMMAND ${BENCH_KEYS} --keywords ${input}
+        OUTPUT_FILE ${corpus})
+    benchmark(${name} ${input} ${corpus})
+endforeach()
+
+# The synthetic keyword sets.
+foreach(size ${SIZES})
+    set(name synthetic-${size})
+    set(input ${WORKDIR}/${name}.gperf)
+    execute_process(
+        COMMAND ${BENCH_KEYS} ${size}
+        OUTPUT_FILE ${input})
+    benchmark(${name} ${input} ${input})
+endforeach()
+
+message(STATUS "Benchmark results written to ${OUTPUT}")
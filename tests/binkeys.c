@@ -0,0 +1,164 @@
+/*
+   Converts a simple gperf input file to the binary input format.
+   The input is read from standard input and may consist of
+     declarations
+     %%
+     keywords
+     %%
+     functions
+   where the sections before the first %% and after the second %% are
+   optional.  Each keyword line consists of the keyword, optionally followed
+   by a comma and the rest of the line.  Quoted keywords are not supported.
+   The binary input file is written to standard output.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Support for SET_BINARY. */
+#include <fcntl.h>
+#if !defined O_BINARY && defined _O_BINARY
+# define O_BINARY _O_BINARY
+#endif
+#ifdef __BEOS__
+# undef O_BINARY
+#endif
+#if O_BINARY
+# include <io.h>
+# define SET_BINARY(f) setmode (f, O_BINARY)
+#else
+# define SET_BINARY(f) (void)0
+#endif
+
+static void
+put_uint32 (unsigned long n)
+{
+  putchar (n & 0xff);
+  putchar ((n >> 8) & 0xff);
+  putchar ((n >> 16) & 0xff);
+  putchar ((n >> 24) & 0xff);
+}
+
+static void
+put_blob (const char *start, const char *end)
+{
+  put_uint32 (end - start);
+  fwrite (start, 1, end - start, stdout);
+}
+
+int
+main ()
+{
+  char *input = NULL;
+  size_t length = 0;
+  size_t allocated = 0;
+  const char *separator[2];
+  int separators = 0;
+  const char *declarations;
+  const char *declarations_end;
+  const char *keywords;
+  const char *keywords_end;
+  const char *code;
+  const char *code_end;
+  const char *p;
+  const char *line;
+  unsigned long count;
+
+  /* Read the entire input.  */
+  for (;;)
+    {
+      if (length == allocated)
+        {
+          allocated = 2 * allocated + 4096;
+          input = (char *) realloc (input, allocated);
+          if (input == NULL)
+            return 1;
+        }
+      {
+        size_t n = fread (input + length, 1, allocated - length, stdin);
+        if (n == 0)
+          break;
+        length += n;
+      }
+    }
+  if (ferror (stdin))
+    return 1;
+
+  /* Find the separator lines.  */
+  for (p = input; p < input + length && separators < 2; )
+    {
+      if (input + length - p >= 2 && p[0] == '%' && p[1] == '%')
+        separator[separators++] = p;
+      p = (const char *) memchr (p, '\n', input + length - p);
+      p = (p != NULL ? p + 1 : input + length);
+    }
+  declarations = declarations_end = input;
+  keywords = input;
+  keywords_end = code = code_end = input + length;
+  if (separators > 0)
+    {
+      declarations_end = separator[0];
+      keywords = (const char *) memchr (separator[0], '\n',
+                                        input + length - separator[0]);
+      keywords = (keywords != NULL ? keywords + 1 : input + length);
+    }
+  if (separators > 1)
+    {
+      keywords_end = separator[1];
+      code = separator[1] + 2;
+    }
+
+  /* Count the keywords.  */
+  count = 0;
+  for (line = keywords; line < keywords_end; )
+    {
+      const char *line_end =
+        (const char *) memchr (line, '\n', keywords_end - line);
+      line_end = (line_end != NULL ? line_end + 1 : keywords_end);
+      if (line[0] != '#')
+        count++;
+      line = line_end;
+    }
+
+  SET_BINARY (fileno (stdout));
+
+  /* Write the header.  */
+  fwrite ("\211gperf\r\n", 1, 8, stdout);
+  put_uint32 (1);
+  put_uint32 (count);
+  put_blob (declarations, declarations_end);
+  put_blob (code, code_end);
+
+  /* Write the keywords.  */
+  for (line = keywords; line < keywords_end; )
+    {
+      const char *line_end =
+        (const char *) memchr (line, '\n', keywords_end - line);
+      const char *text_end;
+      const char *comma;
+      line_end = (line_end != NULL ? line_end + 1 : keywords_end);
+      text_end = (line_end > line && line_end[-1] == '\n'
+                  ? line_end - 1 : line_end);
+      if (line[0] != '#')
+        {
+          comma = (const char *) memchr (line, ',', text_end - line);
+          if (comma != NULL)
+            {
+              put_blob (line, comma);
+              put_blob (comma + 1, text_end);
+            }
+          else
+            {
+              put_blob (line, text_end);
+              put_uint32 (0);
+            }
+          putchar ('\0');
+        }
+      line = line_end;
+    }
+
+  if (fflush (stdout) || ferror (stdout))
+    return 1;
+  return 0;
+}
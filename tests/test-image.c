@@ -0,0 +1,78 @@
+/*
+   Tests the loader for binary images generated with --output-image.
+   Usage: test-image IMAGE [-v | -p]
+   Looks up each line of standard input in IMAGE.  The -v option prints
+   diagnostics as to whether a word is in the set or not.  The -p option
+   prints the keyword that each word is found as, followed by a comma and
+   its payload.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "image-loader.h"
+
+#define MAX_LEN 1024
+
+int
+main (int argc, char *argv[])
+{
+  int verbose = argc > 2 && strcmp (argv[2], "-v") == 0;
+  int payloads = argc > 2 && strcmp (argv[2], "-p") == 0;
+  FILE *fp;
+  char *data;
+  long size;
+  struct gperf_image image;
+  char buf[MAX_LEN];
+
+  /* Read the image.  */
+  if (argc < 2 || (fp = fopen (argv[1], "rb")) == NULL)
+    return 1;
+  if (fseek (fp, 0, SEEK_END) != 0 || (size = ftell (fp)) < 0
+      || fseek (fp, 0, SEEK_SET) != 0)
+    return 1;
+  data = (char *) malloc (size > 0 ? size : 1);
+  if (data == NULL || fread (data, 1, size, fp) != (size_t) size)
+    return 1;
+  fclose (fp);
+
+  if (gperf_image_open (&image, data, size) < 0)
+    {
+      fprintf (stderr, "invalid image\n");
+      return 1;
+    }
+
+  while (fgets (buf, MAX_LEN, stdin))
+    {
+      long index;
+
+      if (strlen (buf) > 0 && buf[strlen (buf) - 1] == '\n')
+        buf[strlen (buf) - 1] = '\0';
+
+      index = gperf_image_lookup (&image, buf, strlen (buf));
+      if (index >= 0)
+        {
+          if (verbose)
+            printf ("in word set %s\n", buf);
+          if (payloads)
+            {
+              size_t key_length;
+              size_t payload_length;
+              const char *key =
+                gperf_image_key (&image, index, &key_length);
+              const char *payload =
+                gperf_image_payload (&image, index, &payload_length);
+              printf ("%.*s,%.*s\n", (int) key_length, key,
+                      (int) payload_length, payload);
+            }
+        }
+      else
+        {
+          if (verbose)
+            printf ("NOT in word set %s\n", buf);
+        }
+    }
+
+  return 0;
+}
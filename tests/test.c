@@ -9,7 +9,7 @@
 
 extern const char * in_word_set (const char *, size_t);
 
-#define MAX_LEN 80
+#define MAX_LEN 1024
 
 int
 main (int argc, char *argv[])